@@ -97,7 +97,10 @@
  * - Every REPORT_FREQUENCY clock ticks a line of comma seperated output
  *   is printed to STDOUT with some statistics about what's going on.
  * - Every DUMP_FREQUENCY clock ticks, all viable replicators (cells whose
- *   generation is >= 2) are dumped to a file on disk.
+ *   generation is >= 2) are dumped to a file on disk, as CSV or (with
+ *   DUMP_BINARY) in a compact binary format, by a background thread.
+ * - Every CHECKPOINT_FREQUENCY clock ticks (if defined) the whole state
+ *   of the simulation is saved to a file it can later be resumed from.
  * - Every INFLOW_FREQUENCY clock ticks a random x,y location is picked,
  *   energy is added (see INFLOW_RATE_MEAN and INFLOW_RATE_DEVIATION)
  *   and it's genome is filled with completely random bits.  Statistics
@@ -237,15 +240,37 @@
 /* Tunable parameters                                                      */
 /* ----------------------------------------------------------------------- */
 
+/* Define DISTRIBUTED_NODES to 2 or more to split the pond into that
+ * many strips of DISTRIBUTED_ROWS rows, each run by a process of its
+ * own, possibly on different machines (see "Distributed ponds" below).
+ * Each process then keeps only its strip plus a halo row above and
+ * below it, so POND_SIZE_Y is the height of that, and the whole pond is
+ * POND_SIZE_X by DISTRIBUTED_NODES * DISTRIBUTED_ROWS. */
+#ifndef DISTRIBUTED_NODES
+#define DISTRIBUTED_NODES 0
+#endif
+#ifndef DISTRIBUTED_ROWS
+#define DISTRIBUTED_ROWS 480
+#endif
+
+/* Ticks each process runs between halo exchanges, see runDistributed() */
+#define DISTRIBUTED_PHASE 100000
+
 /* Size of pond in X and Y dimensions. */
 #define POND_SIZE_X 640
+#if (DISTRIBUTED_NODES > 0)
+#define POND_SIZE_Y (DISTRIBUTED_ROWS + 4)
+#else
 #define POND_SIZE_Y 480
+#endif
 /*
 #define POND_SIZE_X 200
 #define POND_SIZE_Y 200
 */
 
-/* Iteration to stop at. Comment this out to run forever. */
+/* Iteration to stop at. Comment this out to run forever. This and the
+ * seed, MUTATION_RATE, INFLOW_RATE_BASE, INFLOW_RATE_VARIATION and
+ * REPRODUCTION_COST are only defaults, see struct PondConfig. */
 /* #define STOP_AT 150000000000ULL */
 /* #define STOP_AT 100000000ULL */
 
@@ -254,6 +279,90 @@
  * frequent updates. */
 #define REPORT_FREQUENCY    1000000
 
+/* Define this to 1 to keep the population totals in the report (energy,
+ * active, living and viable cells, and the maximum energies and
+ * generation) up to date as cells change, instead of scanning the whole
+ * pond for every report. TOTAL_ENERGY_CAP then sees the current total
+ * energy rather than the total as of the last report, which changes the
+ * run if it is set. */
+#ifndef INCREMENTAL_STATS
+#define INCREMENTAL_STATS 0
+#endif
+
+/* Define this to 1 (with INCREMENTAL_STATS) to also scan the pond for
+ * every report and abort if the totals differ. */
+#ifndef INCREMENTAL_STATS_CHECK
+#define INCREMENTAL_STATS_CHECK 0
+#endif
+
+/* Define this to 1 to keep a set of the cells that have energy and only
+ * pick cells to execute from it. Every tick still stands for one pick
+ * of a random cell, but the ticks whose pick would have found a cell
+ * without energy are skipped over: after each execution the number of
+ * them to skip is drawn from the geometric distribution the uniform
+ * picks would have given, so inflow, reports and the rest of the
+ * housekeeping keep their cadence, and the clock jumps over them up to
+ * the next of those. Skipped ticks still count as cell executions. This
+ * only pays off while most cells have no energy (a young pond); once
+ * the executions themselves dominate it is no faster. It changes the
+ * run, and needs PARALLEL_THREADS 0. */
+#ifndef ACTIVE_SET_SCHEDULER
+#define ACTIVE_SET_SCHEDULER 0
+#endif
+
+/* Define this to 1 to measure where the time goes: the cycles spent on
+ * each instruction and in each phase of a cell execution (resetting the
+ * VM, running the genome and placing the offspring), and histograms of
+ * the instructions run per execution and of the energy left at the end.
+ * These are written to profile.csv (after the output prefix) at every
+ * report. Cycles are read with rdtsc on x86, and are nanoseconds from
+ * clock_gettime() elsewhere. This takes a timestamp per instruction, so
+ * leave it off for real runs. */
+#ifndef PROFILE_CYCLES
+#define PROFILE_CYCLES 0
+#endif
+
+/* Define this to 1 to trace one in every EXEC_TRACE_SAMPLE cell
+ * executions: the position and instruction of each instruction run (the
+ * first EXEC_TRACE_STEPS of them), the LOOPs entered, repeated and
+ * skipped, the reads and writes of each bank of the cell's memory
+ * (special, private, public and the neighbor's), and how it ended
+ * (STOP, energy gone or loop stack overflow, and reproduced or not).
+ * Each worker keeps the last EXEC_TRACE_RING traces in a ring, which is
+ * written to <clock>.trace.bin (after the output prefix, named for the
+ * clock the run starts at) at every report. Run with -x <trace>... to
+ * rebuild the hot paths of each genome from them (see replayTraces()).
+ * Executions are picked by count, not at random, so a traced run is the
+ * same run. This needs GENOME_HASH_CACHE. */
+#ifndef EXEC_TRACE
+#define EXEC_TRACE 0
+#endif
+#ifndef EXEC_TRACE_SAMPLE
+#define EXEC_TRACE_SAMPLE 4096
+#endif
+#define EXEC_TRACE_STEPS 256
+#define EXEC_TRACE_RING 256
+
+/* Define this to 1 to hand reports over to an exporter thread through a
+ * lock-free ring of TELEMETRY_RING records, so that a report costs the
+ * simulation only the count of the population and a copy of the
+ * counters, and REPORT_FREQUENCY can be raised for finer monitoring. The
+ * exporter writes the CSV report (unless TELEMETRY_CSV is 0) and the
+ * [EVENT] messages as before, and can also append every report and
+ * event to a binary log named TELEMETRY_LOG (after the output prefix)
+ * and send each as a UDP datagram to TELEMETRY_UDP_HOST (127.0.0.1 by
+ * default) on TELEMETRY_UDP_PORT. See packTelemetryRecord() for the
+ * format. */
+#ifndef TELEMETRY
+#define TELEMETRY 0
+#endif
+#ifndef TELEMETRY_CSV
+#define TELEMETRY_CSV 1
+#endif
+#define TELEMETRY_RING 1024
+/* #define TELEMETRY_LOG "telemetry.bin" */
+/* #define TELEMETRY_UDP_PORT 9125 */
+
 /* This is the frequency of screen refreshes if SDL is enabled. */
 #define REFRESH_FREQUENCY   20000
 
@@ -265,17 +374,158 @@
  * four-bit value. */
 #define DUMP_FREQUENCY 10000000
 
+/* Define this to 1 to write dumps as <clock>.dump.bin in a compact
+ * binary format (fixed-width metadata and INST_BITS bits per
+ * instruction) instead of CSV. Run with -d <file> to convert one to the
+ * CSV format on standard output. */
+#ifndef DUMP_BINARY
+#define DUMP_BINARY 0
+#endif
+
+/* Define this to 1 to write dumps from a background thread, so the
+ * simulation only stops long enough to copy the viable cells. */
+#ifndef DUMP_THREAD
+#define DUMP_THREAD 1
+#endif
+
+/* Define this to 1 to make binary dumps (DUMP_BINARY) incremental: only
+ * every DUMP_KEYFRAME_INTERVAL'th dump holds all viable cells, and the
+ * ones in between, named <clock>.delta.bin, only hold the cells that
+ * changed since the dump before. Give -d a full dump followed by the
+ * deltas after it to get the CSV as of the last delta. */
+#ifndef DUMP_DELTA
+#define DUMP_DELTA 0
+#endif
+#if (DUMP_DELTA && (!DUMP_BINARY))
+#error "DUMP_DELTA needs DUMP_BINARY"
+/* Leave the deltas out so this is the only error reported */
+#undef DUMP_DELTA
+#define DUMP_DELTA 0
+#endif
+#define DUMP_KEYFRAME_INTERVAL 10
+
+/* Define this to 1 to log every birth to <clock>.births.bin (after the
+ * output prefix, named for the clock the run starts at): the IDs of the
+ * offspring and its parent, its lineage, generation, position and genome
+ * hash, and the clock. Each worker collects BIRTH_LOG_BATCH records and
+ * then copies them into the file, which is memory mapped BIRTH_LOG_CHUNK
+ * bytes at a time. Run with -p <dump> <birth log>... to build the
+ * phylogenetic tree of the cells in a CSV dump (see buildPhylogeny()).
+ * This needs GENOME_HASH_CACHE. */
+#ifndef BIRTH_LOG
+#define BIRTH_LOG 0
+#endif
+#define BIRTH_LOG_BATCH 1024
+#define BIRTH_LOG_CHUNK (16 * 1024 * 1024)
+
+/* Frequency at which to checkpoint the whole simulation to a file named
+ * <clock>.checkpoint in the current directory, which can be resumed by
+ * running with -r <file>. Checkpoints are large (about the size of the
+ * pond in memory) and are written in the background by a forked process.
+ * Comment out to disable. */
+/* #define CHECKPOINT_FREQUENCY 100000000ULL */
+
 /* Mutation rate -- range is from 0 (none) to 0xffffffff (all mutations!) */
 /* To get it from a float probability from 0.0 to 1.0, multiply it by
  * 4294967295 (0xffffffff) and round. */
 /*#define MUTATION_RATE 21475 */ /* p=~0.000005 */
 #define MUTATION_RATE 100000
 
+/* Define this to 1 to draw the number of instructions until the next
+ * mutation from a geometric distribution and count it down, instead of
+ * drawing a random number for every instruction. The mutation rate and
+ * the kinds of mutation are the same, but the random number sequence
+ * differs, so a given INIT_SEED gives a different run. */
+#ifndef MUTATION_SKIP_AHEAD
+#define MUTATION_SKIP_AHEAD 0
+#endif
+
+/* Define this to 1 to skip a false LOOP/REP block in one step using a
+ * cached matching-bracket table, charging the same energy as walking
+ * it. This needs MUTATION_SKIP_AHEAD, since no mutation may fall inside
+ * the skipped block; if one would, the block is walked as usual. The
+ * tables of recently run cells are cached per worker in
+ * LOOP_JUMP_CACHE_SIZE entries (a power of two) and are thrown away
+ * whenever a cell's genome is written. */
+#ifndef LOOP_JUMP_TABLE
+#define LOOP_JUMP_TABLE 0
+#endif
+#if (LOOP_JUMP_TABLE && (!MUTATION_SKIP_AHEAD))
+#error "LOOP_JUMP_TABLE needs MUTATION_SKIP_AHEAD"
+/* Leave the tables out so this is the only error reported */
+#undef LOOP_JUMP_TABLE
+#define LOOP_JUMP_TABLE 0
+#endif
+#define LOOP_JUMP_CACHE_SIZE 64
+
+/* Define this to 1 to keep each cell's genome sum (for the KINSHIP
+ * color scheme) and a 64-bit genome hash up to date as the genome is
+ * written, instead of summing all POND_DEPTH instructions of every cell
+ * on each redraw. The hash is a sum of the instructions weighted by
+ * powers of GENOME_HASH_MULTIPLIER, so one write updates it in O(1);
+ * equal genomes always have equal hashes, which makes it useful for
+ * grouping cells by genome. */
+#ifndef GENOME_HASH_CACHE
+#define GENOME_HASH_CACHE 1
+#endif
+#define GENOME_HASH_MULTIPLIER 0x9e3779b97f4a7c15ULL
+
+/* Define this to 1 to keep genomes in a pool of shared blocks instead of
+ * in the cells. Each cell holds only the index of its genome's block,
+ * and a genome written whole (an offspring, a seeded cell, a killed
+ * cell) is interned: if an equal genome is already in the pool its block
+ * is shared. A cell gets a private copy of a shared block the first time
+ * one of its instructions actually changes. Most of a mature pond is a
+ * few genomes copied over and over, so this takes far less memory than
+ * POND_DEPTH bytes per cell on large ponds. The pool is not locked, so
+ * this needs PARALLEL_THREADS 0. */
+#ifndef GENOME_POOL
+#define GENOME_POOL 0
+#endif
+
+/* Define this to 1 to store genomes packed INST_BITS bits per
+ * instruction in 64-bit words instead of one instruction per byte, which
+ * takes 320 rather than 512 bytes per cell for the default POND_DEPTH.
+ * Everything reads the genome through GENOME_AT() and writes it through
+ * genomeWrite() and genomeSet(), so this only changes how it is stored;
+ * runs are the same. It pays off when the pond doesn't fit in the
+ * caches, and costs a few shifts per instruction fetched otherwise. This
+ * can't be used with GENOME_POOL. */
+#ifndef GENOME_PACKED
+#define GENOME_PACKED 0
+#endif
+
+/* Define this to 1 to use vector versions of the whole-genome sum and
+ * hash (see genomeRewritten()) and of the report's scan of the energy
+ * and generation planes (with POND_LAYOUT_SOA): SSE2, AVX2 or AVX-512
+ * on x86, picked at startup by what the processor supports, or NEON on
+ * AArch64 (see SIMD_NEON). They give exactly the same results as the
+ * scalar loops. */
+#ifndef SIMD_KERNELS
+#define SIMD_KERNELS 1
+#endif
+
+/* Define this to 1 (with SIMD_KERNELS) to use the NEON kernels on
+ * AArch64. They have not been built and checked with -t on an AArch64
+ * machine yet, so until then AArch64 builds use the scalar loops. */
+#ifndef SIMD_NEON
+#define SIMD_NEON 0
+#endif
+
 /* How frequently should random cells / energy be introduced?
  * Making this too high makes things very chaotic. Making it too low
  * might not introduce enough energy. */
 #define INFLOW_FREQUENCY 100
 
+/* Define this to 1 to make the random genome of an inflow cell from
+ * whole random numbers, one byte per instruction, instead of calling
+ * the generator once per instruction. The masking loop vectorizes, and
+ * the generator is called sizeof(uintptr_t) times less often, but the
+ * run is not the same as without it. */
+#ifndef SEED_BULK_RANDOM
+#define SEED_BULK_RANDOM 0
+#endif
+
 /* Base amount of energy to introduce per INFLOW_FREQUENCY ticks */
 #define INFLOW_RATE_BASE 2000
 
@@ -300,14 +550,164 @@
  * genome size. This *must* be a multiple of 16! */
 #define POND_DEPTH 512
 
-/* Define this to use SDL. To use SDL, you must have SDL headers
- * available and you must link with the SDL library when you compile. */
+/* Define this to 1 to store the pond as separate planes (energy,
+ * generation, IDs, logo/facing, RAM and genome) instead of an array of
+ * Cell structures. Scans of the whole pond such as reports, dumps and
+ * screen refreshes then only pull the planes they read into the cache. */
+#ifndef POND_LAYOUT_SOA
+#define POND_LAYOUT_SOA 0
+#endif
+
+/* Order in which cells are laid out in memory. COLUMN is the original
+ * pond[x][y] order, ROW stores each row of the pond contiguously, and
+ * TILED stores the pond as square tiles of 1<<POND_TILE_BITS cells per
+ * side with the cells of a tile in Morton (Z) order, so most neighbors
+ * in all the DIRECTIONS share a tile. Whole-pond scans (reports, dumps,
+ * the screen refresh) walk cells in storage order whatever this is set
+ * to, so the order of cells in dump files follows it. POND_SIZE_X and
+ * POND_SIZE_Y must be multiples of the tile size for TILED. */
+#define POND_ORDER_COLUMN 0
+#define POND_ORDER_ROW    1
+#define POND_ORDER_TILED  2
+#ifndef POND_ORDER
+#define POND_ORDER POND_ORDER_COLUMN
+#endif
+#define POND_TILE_BITS 3
+
+/* Interpreter used to execute genomes. SWITCH is the original loop
+ * around a switch on the instruction. THREADED uses computed goto (a GCC
+ * extension) so that every instruction ends with its own indirect jump
+ * to the next one, and skips false LOOP/REP blocks in a separate tight
+ * loop. Both give identical results. */
+#define VM_DISPATCH_SWITCH   0
+#define VM_DISPATCH_THREADED 1
+#ifndef VM_DISPATCH
+#define VM_DISPATCH VM_DISPATCH_SWITCH
+#endif
+
+/* Define this to 1 to have the THREADED interpreter decode the whole
+ * genome into an array of jump targets before executing it. Entries are
+ * rewritten by WRITEG and XCHG. This only pays off for cells that run
+ * through most of their genome many times. */
+#ifndef VM_PREDECODE
+#define VM_PREDECODE 0
+#endif
+
+/* Number of neighbors each cell has: 4, 6 (a hex grid) or 8 */
+#ifndef DIRECTIONS
+#define DIRECTIONS 6
+#endif
+
+/* Define this to 1 to build the interpreter and getNeighbor() once for
+ * each of 4, 6 and 8 directions, and pick one per pond at run time from
+ * the directions in its struct PondConfig. Each copy has its direction
+ * count as a constant, so the neighbor lookups fold just as they do for
+ * DIRECTIONS, which is then only the default. This needs the SWITCH
+ * interpreter, since GCC can not make copies of a function that uses
+ * computed goto. */
+#ifndef VM_SPECIALIZE
+#define VM_SPECIALIZE 0
+#endif
+
+/* Define this to use SDL. To use SDL, you must have SDL 2 headers
+ * available and you must link with the SDL2 library when you compile. */
 /* Comment this out to compile without SDL visualization support. */
+/* (Or compile with -DNO_SDL, as the bench script does.) */
+#ifndef NO_SDL
 #define USE_SDL 1
+#endif
 #define SDL_TITLE "nanopond-ch"
 
+/* Define this to compress binary dumps (DUMP_BINARY) with zstd, at the
+ * given compression level. You must link with the zstd library (-lzstd).
+ * -t then checks that a compressed dump reads back as written. */
+/* #define USE_ZSTD 1 */
+#define DUMP_ZSTD_LEVEL 3
+
+#ifndef INIT_SEED
 #define INIT_SEED time(NULL)
 //#define INIT_SEED 1111
+#endif
+
+/* Random number generator backend. RNG_MT19937 is the original Mersenne
+ * Twister, kept for reference: a run with a given INIT_SEED repeats one
+ * made with earlier versions. RNG_XOSHIRO256SS and RNG_PCG64 are much
+ * faster 64-bit generators with tiny state. RNG_BATCH runs RNG_BATCH_LANES
+ * interleaved xoshiro256** streams in a loop the compiler can vectorize,
+ * filling a buffer of RNG_BATCH_SIZE numbers at a time. See the bench
+ * script for a comparison. */
+#define RNG_MT19937      0
+#define RNG_XOSHIRO256SS 1
+#define RNG_PCG64        2
+#define RNG_BATCH        3
+#ifndef RNG_BACKEND
+#define RNG_BACKEND RNG_MT19937
+#endif
+#define RNG_BATCH_LANES 4
+#define RNG_BATCH_SIZE  256
+
+/* Number of worker threads for the parallel tile engine. Set to 0 to
+ * use the original single threaded core loop. The parallel engine splits
+ * the pond into PARALLEL_TILES_X * PARALLEL_TILES_Y tiles which are
+ * colored in a 2x2 pattern. Tiles of the same color are never adjacent,
+ * so cells executing in them can't touch the same neighbor (KILL, SHARE,
+ * offspring, neighbor RAM) and all tiles of one color run at once. */
+#ifndef PARALLEL_THREADS
+#define PARALLEL_THREADS 0
+#endif
+
+/* Tile grid of the parallel engine. Both must be even (for the coloring
+ * to wrap around the toroidal pond), must divide the pond size, and tiles
+ * must be at least 2 cells wide and high. */
+#define PARALLEL_TILES_X 16
+#define PARALLEL_TILES_Y 16
+
+/* Clock ticks per parallel epoch. Each epoch the ticks are assigned to
+ * tiles at random (a tile is picked uniformly per tick, which is the same
+ * as picking a random cell per tick), then the four colors are run in a
+ * random order. Reports, dumps and screen refreshes happen between epochs,
+ * so this must divide REPORT_FREQUENCY, REFRESH_FREQUENCY and
+ * DUMP_FREQUENCY, and be a multiple of INFLOW_FREQUENCY. */
+#define PARALLEL_EPOCH 10000
+
+/* Define this to 1 for a deterministic parallel engine. Every tile then
+ * owns its random number generator and cell ID counter, so a run depends
+ * only on INIT_SEED and the tile grid, and not on PARALLEL_THREADS or on
+ * which worker happened to run which tile. Otherwise each worker thread
+ * has its own generator and ID counter, which is a little faster but does
+ * not repeat from run to run. */
+#ifndef PARALLEL_DETERMINISTIC
+#define PARALLEL_DETERMINISTIC 0
+#endif
+
+/* Define this to 1 to build the batch mode, run with -b <jobs file>
+ * [<threads>], which runs many independent ponds in one process for
+ * parameter sweeps, one pond per thread. Each line of the jobs file is
+ *   <name> <seed> <mutation rate> <inflow base> <inflow variation>
+ *   <reproduction cost> <stop at> [<directions>]
+ * (lines starting with # are skipped; directions other than DIRECTIONS
+ * need VM_SPECIALIZE), and each pond writes its report
+ * to <name>/report.csv and its dumps and checkpoints into <name>/.
+ * The simulation state is then thread-local (see POND_STATE), which
+ * needs NO_SDL and PARALLEL_THREADS 0. */
+#ifndef BATCH_PONDS
+#define BATCH_PONDS 0
+#endif
+
+/* Define this to 1 to build the dump analysis tool, run with
+ * -a <state file> <dump>..., which summarizes a series of CSV or full
+ * binary dumps: cells, unique genomes (by the genome hash of
+ * GENOME_HASH_CACHE), genomes gained and lost since the dump before,
+ * lineages, and the distributions of logo and facing. It also writes
+ * the genomes and lineages of each dump, by size, next to it. Dumps are
+ * memory mapped and parsed by DUMP_ANALYSIS_THREADS threads (0 for one
+ * per processor), and the state file remembers the dumps already done,
+ * so rerunning it over a growing series only reads the new dumps (see
+ * analyzeDumps()). */
+#ifndef DUMP_ANALYSIS
+#define DUMP_ANALYSIS 1
+#endif
+#define DUMP_ANALYSIS_THREADS 0
 
 /* ----------------------------------------------------------------------- */
 
@@ -316,14 +716,123 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <math.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#if ((PARALLEL_THREADS > 0) || DUMP_THREAD || BATCH_PONDS || defined(USE_SDL) || TELEMETRY || DUMP_ANALYSIS)
+#include <pthread.h>
+#endif
+#if ((PARALLEL_THREADS > 0) || BATCH_PONDS || defined(USE_SDL) || TELEMETRY)
+#include <stdatomic.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif /* USE_ZSTD */
+#if (DISTRIBUTED_NODES > 0)
+#include <poll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+#if ((DISTRIBUTED_NODES > 0) || TELEMETRY)
+#include <netdb.h>
+#include <sys/socket.h>
+#endif
+#if PROFILE_CYCLES && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
+#if SIMD_KERNELS && (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#elif SIMD_KERNELS && SIMD_NEON && defined(__aarch64__)
+#include <arm_neon.h>
+#elif SIMD_NEON
+/* Not an AArch64 SIMD_KERNELS build, so there is nothing to use them on */
+#undef SIMD_NEON
+#define SIMD_NEON 0
+#endif
+
+/* Storage class of everything that belongs to one pond: thread-local in
+ * the batch mode, so every batch thread has a pond of its own */
+#if BATCH_PONDS
+#if (defined(USE_SDL) || (PARALLEL_THREADS > 0))
+#error "BATCH_PONDS needs NO_SDL and PARALLEL_THREADS 0"
+#endif
+#define POND_STATE _Thread_local
+#else
+#define POND_STATE
+#endif
+
+/**
+ * Tunables that can be set per pond at run time
+ *
+ * They start out as the compile time values above (see defaultConfig());
+ * batch jobs set their own.
+ */
+struct PondConfig
+{
+  uint64_t seed;
+  uintptr_t mutationRate;
+  uintptr_t inflowRateBase;
+  /* 0 for no variation */
+  uintptr_t inflowRateVariation;
+  uintptr_t reproductionCost;
+  /* UINT64_MAX to run forever */
+  uint64_t stopAt;
+  /* Number of ticks to run from the start or the restored clock if that
+   * comes before stopAt, 0 for no limit */
+  uint64_t runTicks;
+  /* Nonzero to start from a pond full of loop-heavy genomes (see
+   * seedLoopCorpus()) rather than an empty one */
+  int loopCorpus;
+  /* 4, 6 or 8; anything but DIRECTIONS needs VM_SPECIALIZE */
+  uintptr_t directions;
+  /* Prefix of the dump and checkpoint file names */
+  char outputPrefix[256];
+  /* Where reports go */
+  FILE *report;
+};
+
+static POND_STATE struct PondConfig config;
+
+/**
+ * Set a configuration to the compile time tunables
+ *
+ * @param c Configuration
+ */
+static void defaultConfig(struct PondConfig *const c)
+{
+  memset(c, 0, sizeof(struct PondConfig));
+  c->seed = (uint64_t)INIT_SEED;
+  c->mutationRate = MUTATION_RATE;
+  c->inflowRateBase = INFLOW_RATE_BASE;
+#ifdef INFLOW_RATE_VARIATION
+  c->inflowRateVariation = INFLOW_RATE_VARIATION;
+#endif
+  c->reproductionCost = REPRODUCTION_COST;
+#ifdef STOP_AT
+  c->stopAt = STOP_AT;
+#else
+  c->stopAt = UINT64_MAX;
+#endif
+  c->directions = DIRECTIONS;
+  c->report = stdout;
+}
 #ifdef USE_SDL
 #ifdef _MSC_VER
 #include <SDL.h>
 #else
-#include <SDL/SDL.h>
+#include <SDL2/SDL.h>
 #endif /* _MSC_VER */
 #endif /* USE_SDL */
 
+#if (RNG_BACKEND == RNG_MT19937)
+
 /* ----------------------------------------------------------------------- */
 /* This is the Mersenne Twister by Makoto Matsumoto and Takuji Nishimura   */
 /* http://www.math.sci.hiroshima-u.ac.jp/~m-mat/MT/MT2002/emt19937ar.html  */
@@ -381,12 +890,21 @@
 #define UPPER_MASK 0x80000000UL /* most significant w-r bits */
 #define LOWER_MASK 0x7fffffffUL /* least significant r bits */
 
-static unsigned long mt[N]; /* the array for the state vector  */
-static int mti=N+1; /* mti==N+1 means mt[N] is not initialized */
+/* Generator state, kept in a struct so that each worker thread of the
+ * parallel engine can own one. (Originally these were the globals mt[]
+ * and mti.) */
+struct MTState
+{
+    unsigned long mt[N]; /* the array for the state vector  */
+    int mti; /* mti==N+1 means mt[N] is not initialized */
+};
 
 /* initializes mt[N] with a seed */
-static void init_genrand(unsigned long s)
+static void init_genrand(struct MTState *const r, unsigned long s)
 {
+    unsigned long *const mt = r->mt;
+    int mti;
+
     mt[0]= s & 0xffffffffUL;
     for (mti=1; mti<N; mti++) {
         mt[mti] = 
@@ -398,16 +916,18 @@ static void init_genrand(unsigned long s)
         mt[mti] &= 0xffffffffUL;
         /* for >32 bit machines */
     }
+    r->mti = mti;
 }
 
 /* generates a random number on [0,0xffffffff]-interval */
-static inline uint32_t genrand_int32()
+static inline uint32_t genrand_int32(struct MTState *const r)
 {
+    unsigned long *const mt = r->mt;
     uint32_t y;
-    static uint32_t mag01[2]={0x0UL, MATRIX_A};
+    static const uint32_t mag01[2]={0x0UL, MATRIX_A};
     /* mag01[x] = x * MATRIX_A  for x=0,1 */
 
-    if (mti >= N) { /* generate N words at one time */
+    if (r->mti >= N) { /* generate N words at one time */
         int kk;
 
         for (kk=0;kk<N-M;kk++) {
@@ -421,10 +941,10 @@ static inline uint32_t genrand_int32()
         y = (mt[N-1]&UPPER_MASK)|(mt[0]&LOWER_MASK);
         mt[N-1] = mt[M-1] ^ (y >> 1) ^ mag01[y & 0x1UL];
 
-        mti = 0;
+        r->mti = 0;
     }
   
-    y = mt[mti++];
+    y = mt[r->mti++];
 
     /* Tempering */
     y ^= (y >> 11);
@@ -435,6 +955,163 @@ static inline uint32_t genrand_int32()
     return y;
 }
 
+#endif /* RNG_MT19937 */
+
+/* ----------------------------------------------------------------------- */
+/* Random number generator backends                                        */
+/* ----------------------------------------------------------------------- */
+
+/* xoshiro256** and splitmix64 are by David Blackman and Sebastiano Vigna
+ * (public domain, http://prng.di.unimi.it/). PCG64 (XSL-RR 128/64) is by
+ * Melissa O'Neill (http://www.pcg-random.org/). */
+
+/**
+ * State of one random number generator (one per worker, or per tile)
+ */
+struct RandomState
+{
+#if (RNG_BACKEND == RNG_MT19937)
+  struct MTState mt;
+#elif (RNG_BACKEND == RNG_XOSHIRO256SS)
+  uint64_t s[4];
+#elif (RNG_BACKEND == RNG_PCG64)
+  __uint128_t state;
+  __uint128_t inc;
+#elif (RNG_BACKEND == RNG_BATCH)
+  uint64_t s[4][RNG_BATCH_LANES];
+  uintptr_t pos;
+  uint64_t buf[RNG_BATCH_SIZE];
+#else
+#error "Please set RNG_BACKEND to one of the RNG_* values"
+#endif
+};
+
+static inline uint64_t rotl64(const uint64_t x, const int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+/* Used to expand a seed into generator state */
+static inline uint64_t splitmix64(uint64_t *const x)
+{
+  uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+#if (RNG_BACKEND == RNG_BATCH)
+/* Refill the buffer. Each lane is an independent xoshiro256** and the
+ * lanes are stored side by side so this loop vectorizes. */
+static void refillRandom(struct RandomState *const r)
+{
+  uintptr_t i, l;
+  for(i=0;i<RNG_BATCH_SIZE;i+=RNG_BATCH_LANES) {
+    for(l=0;l<RNG_BATCH_LANES;++l) {
+      const uint64_t s1 = r->s[1][l];
+      const uint64_t t = s1 << 17;
+      r->buf[i + l] = rotl64(s1 * 5, 7) * 9;
+      r->s[2][l] ^= r->s[0][l];
+      r->s[3][l] ^= s1;
+      r->s[1][l] ^= r->s[2][l];
+      r->s[0][l] ^= r->s[3][l];
+      r->s[2][l] ^= t;
+      r->s[3][l] = rotl64(r->s[3][l], 45);
+    }
+  }
+  r->pos = 0;
+}
+#endif /* RNG_BATCH */
+
+/**
+ * Seed a random number generator
+ *
+ * @param r Generator
+ * @param seed Seed
+ */
+static void initRandom(struct RandomState *const r, uint64_t seed)
+{
+#if (RNG_BACKEND == RNG_MT19937)
+  init_genrand(&r->mt, (unsigned long)seed);
+#elif (RNG_BACKEND == RNG_XOSHIRO256SS)
+  r->s[0] = splitmix64(&seed);
+  r->s[1] = splitmix64(&seed);
+  r->s[2] = splitmix64(&seed);
+  r->s[3] = splitmix64(&seed);
+#elif (RNG_BACKEND == RNG_PCG64)
+  r->inc = ((((__uint128_t)splitmix64(&seed)) << 64) | splitmix64(&seed)) | 1;
+  r->state = (((__uint128_t)splitmix64(&seed)) << 64) | splitmix64(&seed);
+#elif (RNG_BACKEND == RNG_BATCH)
+  uintptr_t i, l;
+  for(l=0;l<RNG_BATCH_LANES;++l) {
+    for(i=0;i<4;++i)
+      r->s[i][l] = splitmix64(&seed);
+  }
+  refillRandom(r);
+#endif
+}
+
+/**
+ * Get a random number
+ *
+ * @param r Generator
+ * @return Random number
+ */
+static inline uintptr_t getRandom(struct RandomState *const r)
+{
+#if (RNG_BACKEND == RNG_MT19937)
+  /* A good optimizing compiler should optimize out this if */
+  /* This is to make it work on 64-bit boxes */
+  if (sizeof(uintptr_t) == 8)
+    return (uintptr_t)((((uint64_t)genrand_int32(&r->mt)) << 32) ^ ((uint64_t)genrand_int32(&r->mt)));
+  else return (uintptr_t)genrand_int32(&r->mt);
+#elif (RNG_BACKEND == RNG_XOSHIRO256SS)
+  const uint64_t result = rotl64(r->s[1] * 5, 7) * 9;
+  const uint64_t t = r->s[1] << 17;
+  r->s[2] ^= r->s[0];
+  r->s[3] ^= r->s[1];
+  r->s[1] ^= r->s[2];
+  r->s[0] ^= r->s[3];
+  r->s[2] ^= t;
+  r->s[3] = rotl64(r->s[3], 45);
+  return (uintptr_t)result;
+#elif (RNG_BACKEND == RNG_PCG64)
+  const __uint128_t st = r->state;
+  const uint64_t x = (uint64_t)(st >> 64) ^ (uint64_t)st;
+  const int rot = (int)(st >> 122);
+  r->state = st * ((((__uint128_t)0x2360ed051fc65da4ULL) << 64) | 0x4385df649fccf645ULL) + r->inc;
+  return (uintptr_t)((x >> rot) | (x << ((-rot) & 63)));
+#elif (RNG_BACKEND == RNG_BATCH)
+  if (r->pos >= RNG_BATCH_SIZE)
+    refillRandom(r);
+  return (uintptr_t)r->buf[r->pos++];
+#endif
+}
+
+#if SEED_BULK_RANDOM
+/**
+ * Fill a buffer with random bytes, a whole random number at a time
+ *
+ * @param r Generator
+ * @param out Buffer
+ * @param n Bytes to fill
+ */
+static void fillRandomBytes(struct RandomState *const r, uint8_t *out, uintptr_t n)
+{
+  uintptr_t v;
+  while (n >= sizeof(v)) {
+    v = getRandom(r);
+    memcpy(out, &v, sizeof(v));
+    out += sizeof(v);
+    n -= sizeof(v);
+  }
+  if (n) {
+    v = getRandom(r);
+    memcpy(out, &v, n);
+  }
+}
+#endif /* SEED_BULK_RANDOM */
+
 /* ----------------------------------------------------------------------- */
 
 #define INST_BITS 5 
@@ -506,6 +1183,9 @@ enum {
 /* Number of bits in a machine-size word */
 #define SYSWORD_BITS (sizeof(uintptr_t) * 8)
 
+/* Size of a cache line, to keep data written by different threads apart */
+#define CACHE_LINE_BYTES 64
+
 /* allocated RAM per cell */
 #define RAM_SIZE 16 
 /* mask used for direct RAM references */
@@ -521,22 +1201,26 @@ enum {
 /* decay RAM when a cell has no energy  */
 #define DECAY_RAM 0
 
-/* Constants representing neighbors in the 2D grid. */
-#define DIRECTIONS 6
+/* Constants representing neighbors in the 2D grid, for each number of
+ * directions. */
+#if (DIRECTIONS != 4) && (DIRECTIONS != 6) && (DIRECTIONS != 8)
+#error "Please set DIRECTIONS TO 4, 6, or 8"
+#endif
+#if VM_SPECIALIZE && (VM_DISPATCH != VM_DISPATCH_SWITCH)
+#error VM_SPECIALIZE needs VM_DISPATCH_SWITCH
+#endif
 
-#if (DIRECTIONS == 4)
-#define DIR_NORTH 0
-#define DIR_EAST  1
-#define DIR_SOUTH 2
-#define DIR_WEST  3
-
-#elif (DIRECTIONS == 6)
-#define DIR_0 0
-#define DIR_1 1
-#define DIR_2 2
-#define DIR_3 3
-#define DIR_4 4
-#define DIR_5 5
+#define DIR4_NORTH 0
+#define DIR4_EAST  1
+#define DIR4_SOUTH 2
+#define DIR4_WEST  3
+
+#define DIR6_0 0
+#define DIR6_1 1
+#define DIR6_2 2
+#define DIR6_3 3
+#define DIR6_4 4
+#define DIR6_5 5
 static const uint8_t dirmap[NUM_INST] = {
     0, 1, 2, 3, 4, 5,
     0, 1, 2, 3, 3, 4, 5,
@@ -545,19 +1229,33 @@ static const uint8_t dirmap[NUM_INST] = {
     0, 1, 2, 3, 4, 5
 };
 
-#elif (DIRECTIONS == 8)
-#define DIR_NORTH 0
-#define DIR_NE    1
-#define DIR_EAST  2
-#define DIR_SE    3
-#define DIR_SOUTH 4
-#define DIR_SW    5
-#define DIR_WEST  6
-#define DIR_NW    7
-
+#define DIR8_NORTH 0
+#define DIR8_NE    1
+#define DIR8_EAST  2
+#define DIR8_SE    3
+#define DIR8_SOUTH 4
+#define DIR8_SW    5
+#define DIR8_WEST  6
+#define DIR8_NW    7
+
+/* Index of a direction count in tables that cover all of them */
+#define DIR_SET(dirs) (((dirs) >> 1) - 2)
+#define DIR_SETS 3
+
+/* Attribute for the functions that take a direction count, so that each
+ * caller gets a copy with the count folded in */
+#if VM_SPECIALIZE
+#define VM_SPECIALIZED __attribute__((always_inline))
 #else
-#error "Please set DIRECTIONS TO 4, 6, or 8"
+#define VM_SPECIALIZED
+#endif
 
+/* Define this to 1 to look up neighbors in tables built at startup
+ * instead of the branches in getNeighbor(). The tables hold the wrapped
+ * coordinates of each row and column and the offset of each facing for
+ * even and odd rows, so no lookup depends on a branch. */
+#ifndef NEIGHBOR_TABLES
+#define NEIGHBOR_TABLES 0
 #endif
 
 /* Sense to use when checking if combination is allowed */
@@ -570,1173 +1268,8515 @@ static const uint8_t dirmap[NUM_INST] = {
 /* static const uintptr_t BITS_IN_FOURBIT_WORD[16] = { 0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4 }; */
 static const uintptr_t BITS_IN_FIVEBIT_WORD[32] = { 0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,1,2,2,3,2,3,3,4,2,3,3,4,3,4,4,5 };
 
-/**
- * Structure for a cell in the pond
- */
-struct Cell
-{
-  /* Globally unique cell ID */
-  uint64_t ID;
-  
-  /* ID of the cell's parent */
-  uint64_t parentID;
-  
-  /* Counter for original lineages -- equal to the cell ID of
-   * the first cell in the line. */
-  uint64_t lineage;
-  
-  /* Generations start at 0 and are incremented from there. */
-  uintptr_t generation;
-  
-  /* Energy level of this cell */
-  uintptr_t energy;
+/* Number of cells in the pond */
+#define POND_CELLS (POND_SIZE_X * POND_SIZE_Y)
 
-  uintptr_t logo;
-  uintptr_t facing;
+#if (POND_ORDER == POND_ORDER_TILED)
 
-  /* Memory space for cell genome (genome is stored as four
-   * bit instructions packed into machine size words) */
-  uint8_t genome[POND_DEPTH];
+#if ((POND_TILE_BITS < 1) || (POND_TILE_BITS > 8))
+#error POND_TILE_BITS must be between 1 and 8
+#endif
 
-  uint8_t ram[RAM_SIZE];
+#define POND_TILE_SIZE (1 << POND_TILE_BITS)
+#define POND_TILE_MASK (POND_TILE_SIZE - 1)
+#define POND_TILES_X (POND_SIZE_X / POND_TILE_SIZE)
+#define POND_TILE_CELL_MASK ((1 << (2 * POND_TILE_BITS)) - 1)
 
-};
+#if ((POND_SIZE_X % POND_TILE_SIZE) || (POND_SIZE_Y % POND_TILE_SIZE))
+#error POND_SIZE_X and POND_SIZE_Y must be multiples of the tile size for POND_ORDER_TILED
+#endif
 
-/* The pond is a 2D array of cells */
-struct Cell pond[POND_SIZE_X][POND_SIZE_Y];
+/**
+ * Spread the low 8 bits of a value out to the even bits
+ *
+ * @param v Value
+ * @return v with bit i moved to bit 2*i
+ */
+static inline uintptr_t mortonSpread(uintptr_t v)
+{
+  v &= 0xff;
+  v = (v | (v << 4)) & 0x0f0f;
+  v = (v | (v << 2)) & 0x3333;
+  v = (v | (v << 1)) & 0x5555;
+  return v;
+}
 
-/* Currently selected color scheme */
-enum {
-    KINSHIP, LINEAGE,
-    LOGO, FACING,
-    ENERGY1, ENERGY2,
-    RAM0, RAM1,
-    MAX_COLOR_SCHEME
-} colorScheme = KINSHIP;
+/**
+ * Gather the even bits of a value back into the low 8 bits
+ *
+ * @param v Value
+ * @return Inverse of mortonSpread()
+ */
+static inline uintptr_t mortonCompact(uintptr_t v)
+{
+  v &= 0x5555;
+  v = (v | (v >> 1)) & 0x3333;
+  v = (v | (v >> 2)) & 0x0f0f;
+  v = (v | (v >> 4)) & 0x00ff;
+  return v;
+}
 
-const char *colorSchemeName[MAX_COLOR_SCHEME] = {
-    "KINSHIP", "LINEAGE",
-    "LOGO", "FACING",
-    "ENERGY1", "ENERGY2",
-    "RAM0", "RAM1"
-};
+#elif ((POND_ORDER != POND_ORDER_COLUMN) && (POND_ORDER != POND_ORDER_ROW))
+#error Unknown POND_ORDER
+#endif
 
 /**
- * Get a random number
+ * Get the index of a cell in the pond
  *
- * @return Random number
+ * Cells are referred to by index everywhere, so that they can be stored
+ * either as an array of structures or as separate planes, and in any
+ * POND_ORDER. Everything that goes from a position to a cell goes
+ * through here.
+ *
+ * @param x X position
+ * @param y Y position
+ * @return Cell index
  */
-static inline uintptr_t getRandom()
+static inline uintptr_t cellIndex(const uintptr_t x, const uintptr_t y)
 {
-  /* A good optimizing compiler should optimize out this if */
-  /* This is to make it work on 64-bit boxes */
-  if (sizeof(uintptr_t) == 8)
-    return (uintptr_t)((((uint64_t)genrand_int32()) << 32) ^ ((uint64_t)genrand_int32()));
-  else return (uintptr_t)genrand_int32();
+#if (POND_ORDER == POND_ORDER_COLUMN)
+  return (x * POND_SIZE_Y) + y;
+#elif (POND_ORDER == POND_ORDER_ROW)
+  return (y * POND_SIZE_X) + x;
+#else
+  return (((((y >> POND_TILE_BITS) * POND_TILES_X) + (x >> POND_TILE_BITS)) << (2 * POND_TILE_BITS))
+    | mortonSpread(x & POND_TILE_MASK) | (mortonSpread(y & POND_TILE_MASK) << 1));
+#endif
 }
 
 /**
- * Structure for keeping some running tally type statistics
+ * Get the X position of a cell
+ *
+ * @param c Cell index
+ * @return X position
  */
-struct PerReportStatCounters
+static inline uintptr_t cellX(const uintptr_t c)
 {
-  /* Counts for the number of times each instruction was
-   * executed since the last report. */
-  double instructionExecutions[NUM_INST];
-  
-  /* Number of cells executed since last report */
-  double cellExecutions;
+#if (POND_ORDER == POND_ORDER_COLUMN)
+  return c / POND_SIZE_Y;
+#elif (POND_ORDER == POND_ORDER_ROW)
+  return c % POND_SIZE_X;
+#else
+  return (((c >> (2 * POND_TILE_BITS)) % POND_TILES_X) << POND_TILE_BITS) | mortonCompact(c & POND_TILE_CELL_MASK);
+#endif
+}
 
-  /* Number of viable cells replaced by other cells' offspring */
-  uintptr_t viableCellsReplaced;
-  
-  /* Number of viable cells KILLed */
-  uintptr_t viableCellsKilled;
-  
-  /* Number of successful SHARE operations */
-  uintptr_t viableCellShares;
+/**
+ * Get the Y position of a cell
+ *
+ * @param c Cell index
+ * @return Y position
+ */
+static inline uintptr_t cellY(const uintptr_t c)
+{
+#if (POND_ORDER == POND_ORDER_COLUMN)
+  return c % POND_SIZE_Y;
+#elif (POND_ORDER == POND_ORDER_ROW)
+  return c / POND_SIZE_X;
+#else
+  return (((c >> (2 * POND_TILE_BITS)) / POND_TILES_X) << POND_TILE_BITS) | mortonCompact((c & POND_TILE_CELL_MASK) >> 1);
+#endif
+}
 
-  /* memory access stats */
+#if (DISTRIBUTED_NODES > 0)
+
+#if ((DISTRIBUTED_NODES < 2) || (DISTRIBUTED_ROWS < 4) || (DISTRIBUTED_ROWS % 2))
+#error "DISTRIBUTED_NODES must be at least 2, and DISTRIBUTED_ROWS even and at least 4"
+#endif
+#if ((PARALLEL_THREADS > 0) || BATCH_PONDS || defined(USE_SDL) || INCREMENTAL_STATS || ACTIVE_SET_SCHEDULER || defined(CHECKPOINT_FREQUENCY))
+#error "DISTRIBUTED_NODES needs NO_SDL, PARALLEL_THREADS 0, and no BATCH_PONDS, INCREMENTAL_STATS, ACTIVE_SET_SCHEDULER or CHECKPOINT_FREQUENCY"
+#endif
+#if ((REPORT_FREQUENCY % DISTRIBUTED_PHASE) || (defined(DUMP_FREQUENCY) && (DUMP_FREQUENCY % DISTRIBUTED_PHASE)))
+#error "DISTRIBUTED_PHASE must divide REPORT_FREQUENCY and DUMP_FREQUENCY"
+#endif
 
-  uintptr_t memSpecialReads;
-  uintptr_t memPrivateReads;
-  uintptr_t memOutputReads;
-  uintptr_t memInputReads;
+/*
+ * Rows of a process's pond: an unused row, the halo row above the
+ * strip (a copy of the last row of the strip above), the strip itself
+ * (its top half and then its bottom half), the halo row below, and
+ * another unused row. The unused rows keep the rows' parity the same as
+ * in the whole pond, which the 6 direction grid depends on.
+ */
+#define NODE_HALO_TOP 1
+#define NODE_FIRST_ROW 2
+#define NODE_HALF_ROWS (DISTRIBUTED_ROWS / 2)
+#define NODE_HALO_BOTTOM (DISTRIBUTED_ROWS + 2)
 
-  uintptr_t memSpecialWrites;
-  uintptr_t memPrivateWrites;
-  uintptr_t memOutputWrites;
-  uintptr_t memInputWrites;
+/* Nonzero if a cell is in this process's strip rather than in a halo
+ * row, so that it counts in reports and dumps */
+#define CELL_OWNED(c) ((cellY(c) - NODE_FIRST_ROW) < DISTRIBUTED_ROWS)
 
-};
+#else
+#define CELL_OWNED(c) 1
+#endif /* DISTRIBUTED_NODES */
 
-/* Global statistics counters */
-struct PerReportStatCounters statCounters;
+#if GENOME_POOL
 
-/* Highest cell energy seen (updated during report) */
-uintptr_t totalEnergy;
-uintptr_t maxCellEnergy;
-uintptr_t maxLivingCellEnergy;
-  
+#if (PARALLEL_THREADS > 0)
+#error "GENOME_POOL needs PARALLEL_THREADS 0"
+#endif
 
 /**
- * Output a line of comma-seperated statistics data
- *
- * @param clock Current clock
+ * A genome in the pool (see GENOME_POOL)
  */
-static void doReport(const uint64_t clock)
+struct GenomeBlock
 {
-  static uint64_t lastTotalViableReplicators = 0;
-  
-  uintptr_t x,y;
-  
-  uint64_t totalActiveCells = 0;
-  uint64_t totalLivingCells = 0;
-  uint64_t totalViableReplicators = 0;
+  /* Number of cells holding this block, 0 if it is free */
+  uint32_t refs;
 
-  uint64_t totalLivingEnergy = 0;
-  uint64_t totalViableEnergy = 0;
+  /* Next block in the same hash bucket while interned, or the next free
+   * block while free */
+  uint32_t next;
 
-  uintptr_t maxGeneration = 0;
+  /* Nonzero while the block is in the hash table, and so may be shared */
+  uint32_t interned;
 
-  totalEnergy = 0;
-  maxCellEnergy = 0;
-  maxLivingCellEnergy = 0;
-  
-  for(x=0;x<POND_SIZE_X;++x) {
-      for(y=0;y<POND_SIZE_Y;++y) {
-          struct Cell *const c = &pond[x][y];
-          if (c->energy) {
-              ++totalActiveCells;
-              totalEnergy += (uint64_t)c->energy;
-              if (c->energy > maxCellEnergy) {
-                  maxCellEnergy = c->energy;
-              }
-              if (c->generation > 1) {
-                  ++totalLivingCells;
-                  totalLivingEnergy += c->energy;
-                  if (c->energy > maxLivingCellEnergy) {
-                      maxLivingCellEnergy = c->energy;
-                  }
-                  if (c->generation > 2) {
-                      ++totalViableReplicators;
-                      totalViableEnergy += c->energy;
-                  }
-              }
-              if (c->generation > maxGeneration) {
-                  maxGeneration = c->generation;
-              }
-          }
-      }
-  }
-  
-  /* Look here to get the columns in the CSV output */
-  
-  printf("%ju,%ju,%ju,%ju,%.2f,%.2f,|,%ju,%ju,%ju,%ju,|,%ju,%ju,%ju,%ju,%ju,%ju,%ju,%ju,|,%ju,%ju,%ju,|",
-    (uintmax_t)clock,
-    (uintmax_t)totalEnergy,
-    (uintmax_t)maxCellEnergy,
-    (uintmax_t)maxLivingCellEnergy,
-    (double)totalLivingEnergy / (double)totalLivingCells,
-    (double)totalViableEnergy / (double)totalViableReplicators,
-
-    (uintmax_t)totalActiveCells,
-    (uintmax_t)totalLivingCells,
-    (uintmax_t)totalViableReplicators,
-    (uintmax_t)maxGeneration,
-
-    (uintmax_t)statCounters.memSpecialReads,
-    (uintmax_t)statCounters.memPrivateReads,
-    (uintmax_t)statCounters.memOutputReads,
-    (uintmax_t)statCounters.memInputReads,
-    (uintmax_t)statCounters.memSpecialWrites,
-    (uintmax_t)statCounters.memPrivateWrites,
-    (uintmax_t)statCounters.memOutputWrites,
-    (uintmax_t)statCounters.memInputWrites,
-
-    (uintmax_t)statCounters.viableCellsReplaced,
-    (uintmax_t)statCounters.viableCellsKilled,
-    (uintmax_t)statCounters.viableCellShares
-    );
-  
-  /* The next NUM_INST are the average frequencies of execution for each
-   * instruction per cell execution. */
-  double totalMetabolism = 0.0;
-  for(x=0;x<NUM_INST;++x) {
-    totalMetabolism += statCounters.instructionExecutions[x];
-    printf(",%.4f",(statCounters.cellExecutions > 0.0) ? (statCounters.instructionExecutions[x] / statCounters.cellExecutions) : 0.0);
-  }
+  uint64_t hash;
+
+  uint8_t genome[POND_DEPTH];
+};
+
+/* Every cell holds a block, and interning can briefly need one more
+ * before the old one is released. Block 0 is never used, so that 0 can
+ * end a hash chain or the free list. */
+#define GENOME_POOL_BLOCKS ((size_t)POND_CELLS + 2)
+
+/* Buckets in the hash table (a power of two of at least POND_CELLS) */
+#define GENOME_POOL_BUCKETS ((size_t)1 << (64 - __builtin_clzll((unsigned long long)POND_CELLS - 1ULL)))
+
+/* The pool, its hash table, the first free block, and the number of
+ * blocks ever used (past which the pool has never been touched) */
+static POND_STATE struct GenomeBlock *genomePool = (struct GenomeBlock *)0;
+static POND_STATE uint32_t *genomePoolTable = (uint32_t *)0;
+static POND_STATE uint32_t genomePoolFree = 0;
+static POND_STATE uint32_t genomePoolUsed = 0;
+
+#endif /* GENOME_POOL */
+
+#if GENOME_PACKED
+#if GENOME_POOL
+#error "GENOME_PACKED can't be used with GENOME_POOL"
+#endif
+#if (INST_BITS > 8)
+#error "GENOME_PACKED needs instructions of at most 8 bits"
+#endif
+
+/* Words holding a packed genome */
+#define GENOME_WORDS (((POND_DEPTH * INST_BITS) + 63) / 64)
+#endif /* GENOME_PACKED */
+
+#if POND_LAYOUT_SOA
+
+/*
+ * The pond is stored as separate planes, one per field (or group of
+ * fields used together), so that scans such as doReport() only pull the
+ * planes they read through the cache. Logo and facing are only 5 bits
+ * so they're kept as bytes in one plane.
+ */
+
+/* Cell ID, ID of the cell's parent, and lineage (the ID of the first
+ * cell in the line) */
+struct CellIds
+{
+  uint64_t ID;
+  uint64_t parentID;
+  uint64_t lineage;
+};
+
+struct CellLogoFacing
+{
+  uint8_t logo;
+  uint8_t facing;
+};
+
+/* The planes, each POND_CELLS long, see setPondMemory() */
+static POND_STATE uintptr_t *pondEnergy;
+static POND_STATE uintptr_t *pondGeneration;
+static POND_STATE struct CellIds *pondIds;
+#if GENOME_HASH_CACHE
+static POND_STATE uint64_t *pondGenomeHash;
+static POND_STATE uint32_t *pondKinSum;
+#endif
+#if LOOP_JUMP_TABLE
+static POND_STATE uint32_t *pondGenomeVersion;
+#endif
+static POND_STATE struct CellLogoFacing *pondLogoFacing;
+static POND_STATE uint8_t (*pondRam)[RAM_SIZE];
+#if GENOME_POOL
+static POND_STATE uint32_t *pondGenomeRef;
+#elif GENOME_PACKED
+static POND_STATE uint64_t (*pondGenome)[GENOME_WORDS];
+#else
+static POND_STATE uint8_t (*pondGenome)[POND_DEPTH];
+#endif
+
+#if LOOP_JUMP_TABLE
+#define POND_VERSION_BYTES sizeof(uint32_t)
+#else
+#define POND_VERSION_BYTES 0
+#endif
+#if GENOME_HASH_CACHE
+#define POND_HASH_BYTES (sizeof(uint64_t) + sizeof(uint32_t))
+#else
+#define POND_HASH_BYTES 0
+#endif
+#if GENOME_POOL
+#define POND_GENOME_BYTES sizeof(uint32_t)
+#elif GENOME_PACKED
+#define POND_GENOME_BYTES (GENOME_WORDS * sizeof(uint64_t))
+#else
+#define POND_GENOME_BYTES POND_DEPTH
+#endif
+
+/* Size of the memory holding the pond */
+#define POND_BYTES ((size_t)POND_CELLS * ((2 * sizeof(uintptr_t)) + sizeof(struct CellIds) + \
+  POND_HASH_BYTES + POND_VERSION_BYTES + sizeof(struct CellLogoFacing) + RAM_SIZE + POND_GENOME_BYTES))
+
+#define CELL_ID(c)         (pondIds[(c)].ID)
+#define CELL_PARENT_ID(c)  (pondIds[(c)].parentID)
+#define CELL_LINEAGE(c)    (pondIds[(c)].lineage)
+#define CELL_GENERATION(c) (pondGeneration[(c)])
+#define CELL_ENERGY(c)     (pondEnergy[(c)])
+#define CELL_LOGO(c)       (pondLogoFacing[(c)].logo)
+#define CELL_FACING(c)     (pondLogoFacing[(c)].facing)
+#if GENOME_POOL
+#define CELL_GENOME_REF(c) (pondGenomeRef[(c)])
+#elif GENOME_PACKED
+#define CELL_GENOME_WORDS(c) (pondGenome[(c)])
+#else
+#define CELL_GENOME(c)     (pondGenome[(c)])
+#endif
+#define CELL_RAM(c)        (pondRam[(c)])
+#define CELL_GENOME_VERSION(c) (pondGenomeVersion[(c)])
+#define CELL_GENOME_HASH(c) (pondGenomeHash[(c)])
+#define CELL_KIN_SUM(c)    (pondKinSum[(c)])
+
+#else /* !POND_LAYOUT_SOA */
+
+/**
+ * Structure for a cell in the pond
+ */
+struct Cell
+{
+  /* Globally unique cell ID */
+  uint64_t ID;
   
-  /* The last column is the average metabolism per cell execution */
-  printf(",%.4f\n",(statCounters.cellExecutions > 0.0) ? (totalMetabolism / statCounters.cellExecutions) : 0.0);
-  fflush(stdout);
+  /* ID of the cell's parent */
+  uint64_t parentID;
   
-  if ((lastTotalViableReplicators > 0)&&(totalViableReplicators == 0))
-    fprintf(stderr,"[EVENT] Viable replicators have gone extinct. Please reserve a moment of silence.\n");
-  else if ((lastTotalViableReplicators == 0)&&(totalViableReplicators > 0))
-    fprintf(stderr,"[EVENT] Viable replicators have appeared!\n");
+  /* Counter for original lineages -- equal to the cell ID of
+   * the first cell in the line. */
+  uint64_t lineage;
   
-  lastTotalViableReplicators = totalViableReplicators;
+  /* Generations start at 0 and are incremented from there. */
+  uintptr_t generation;
   
-  /* Reset per-report stat counters */
-  for(x=0;x<sizeof(statCounters);++x)
-    ((uint8_t *)&statCounters)[x] = (uint8_t)0;
+  /* Energy level of this cell */
+  uintptr_t energy;
+
+#if GENOME_POOL
+  /* Block in the genome pool holding the cell's genome */
+  uint32_t genomeRef;
+#elif GENOME_PACKED
+  /* Genome packed INST_BITS bits per instruction, see genomeGet() */
+  uint64_t genome[GENOME_WORDS];
+#else
+  /* Memory space for cell genome (genome is stored as one
+   * instruction per byte) */
+  uint8_t genome[POND_DEPTH];
+#endif
+
+  uint8_t ram[RAM_SIZE];
+
+  /* (These are only LOGO_BITS and FACING_BITS wide) */
+  uint8_t logo;
+  uint8_t facing;
+
+#if LOOP_JUMP_TABLE
+  /* Bumped whenever the genome is written, see genomeChanged() */
+  uint32_t genomeVersion;
+#endif
+
+#if GENOME_HASH_CACHE
+  /* Sum of the genome's instructions, kept up to date on every write
+   * (see genomeWrite()) */
+  uint32_t kinSum;
+
+  /* Hash of the genome, kept up to date the same way */
+  uint64_t genomeHash;
+#endif
+};
+
+/* The pond is an array of POND_CELLS cells, see cellIndex() and
+ * setPondMemory() */
+static POND_STATE struct Cell *pond;
+
+/* Size of the memory holding the pond */
+#define POND_BYTES ((size_t)POND_CELLS * sizeof(struct Cell))
+
+#define CELL_ID(c)         (pond[(c)].ID)
+#define CELL_PARENT_ID(c)  (pond[(c)].parentID)
+#define CELL_LINEAGE(c)    (pond[(c)].lineage)
+#define CELL_GENERATION(c) (pond[(c)].generation)
+#define CELL_ENERGY(c)     (pond[(c)].energy)
+#define CELL_LOGO(c)       (pond[(c)].logo)
+#define CELL_FACING(c)     (pond[(c)].facing)
+#if GENOME_POOL
+#define CELL_GENOME_REF(c) (pond[(c)].genomeRef)
+#elif GENOME_PACKED
+#define CELL_GENOME_WORDS(c) (pond[(c)].genome)
+#else
+#define CELL_GENOME(c)     (pond[(c)].genome)
+#endif
+#define CELL_RAM(c)        (pond[(c)].ram)
+#define CELL_GENOME_VERSION(c) (pond[(c)].genomeVersion)
+#define CELL_GENOME_HASH(c) (pond[(c)].genomeHash)
+#define CELL_KIN_SUM(c)    (pond[(c)].kinSum)
+
+#endif /* POND_LAYOUT_SOA */
+
+#if GENOME_POOL
+/* Shared blocks are read-only: genomes are written through genomeWrite()
+ * and genomeSet() */
+#define CELL_GENOME(c) ((const uint8_t *)genomePool[CELL_GENOME_REF(c)].genome)
+#endif
+
+#if GENOME_PACKED
+
+/*
+ * Instruction i of a packed genome is at bit i * INST_BITS of the words
+ * taken as one little-endian bit string, so an instruction can straddle
+ * two words. (This is also how binary dumps store genomes.)
+ */
+
+/**
+ * Read an instruction of a packed genome
+ *
+ * @param g Packed genome
+ * @param i Position
+ * @return Instruction
+ */
+static inline uintptr_t genomeGet(const uint64_t *const g, const uintptr_t i)
+{
+  const uintptr_t b = i * INST_BITS, k = b >> 6, s = b & 63;
+  uint64_t v = g[k] >> s;
+  if (s > (64 - INST_BITS))
+    v |= g[k + 1] << (64 - s);
+  return (uintptr_t)(v & INST_MASK);
 }
 
 /**
- * Dumps the genome of a cell to a file.
+ * Write an instruction of a packed genome
  *
- * @param file Destination
- * @param cell Source
+ * @param g Packed genome
+ * @param i Position
+ * @param inst Instruction
  */
-static void dumpCell(FILE *file, struct Cell *cell)
+static inline void genomePut(uint64_t *const g, const uintptr_t i, const uintptr_t inst)
 {
-    uintptr_t inst, stopCount, i;
+  const uintptr_t b = i * INST_BITS, k = b >> 6, s = b & 63;
+  const uint64_t v = (uint64_t)(inst & INST_MASK);
+  g[k] = (g[k] & ~((uint64_t)INST_MASK << s)) | (v << s);
+  if (s > (64 - INST_BITS))
+    g[k + 1] = (g[k + 1] & ~((uint64_t)INST_MASK >> (64 - s))) | (v >> (64 - s));
+}
 
-    //if (force || (cell->energy && (cell->generation > 2))) {
-    fprintf(file, "%ju,%ju,%ju,%ju,%c,%c,",
-            (uintmax_t)cell->ID,
-            (uintmax_t)cell->parentID,
-            (uintmax_t)cell->lineage,
-            (uintmax_t)cell->generation,
-            inst_chars[cell->logo],
-            inst_chars[cell->facing]);
-    stopCount = 0;
-    for(i = 0; i < POND_DEPTH; ++i) {
-        inst = cell->genome[i];
-        if (inst == OP_STOP) { /* STOP */
-            ++stopCount;
-        }
-        else {
-            stopCount = 0;
-        }
-        if (stopCount < 5) {
-            fprintf(file, "%c", (stopCount > 1) ? '.' : inst_chars[inst]);
-        }
+/**
+ * Unpack a whole genome to one instruction per byte
+ *
+ * @param g Packed genome
+ * @param out POND_DEPTH instructions
+ */
+static void genomeUnpack(const uint64_t *g, uint8_t *const out)
+{
+  uint64_t bits = 0;
+  uintptr_t i, n = 0;
+  for(i=0;i<POND_DEPTH;++i) {
+    if (n < INST_BITS) {
+      const uint64_t w = *(g++);
+      out[i] = (uint8_t)((bits | (w << n)) & INST_MASK);
+      bits = w >> (INST_BITS - n);
+      n += 64 - INST_BITS;
+    } else {
+      out[i] = (uint8_t)(bits & INST_MASK);
+      bits >>= INST_BITS;
+      n -= INST_BITS;
     }
-    //}
-    fprintf(file,"\n");
+  }
 }
 
 /**
- * Dumps all viable (generation > 2) cells to a file called <clock>.dump
+ * Pack a whole genome
  *
- * @param clock Clock value
+ * @param g Packed genome to write
+ * @param in Instructions, one per byte
+ * @param n Number of instructions in, the rest being filled with STOP
  */
-static void doDump(const uint64_t clock)
+static void genomePack(uint64_t *g, const uint8_t *const in, const uintptr_t n)
 {
-    char buf[POND_DEPTH*2];
-    FILE *d;
-    uintptr_t x, y;
-    struct Cell *pptr;
-
-    sprintf(buf,"%ju.dump.csv", (uintmax_t)clock);
-    d = fopen(buf,"w");
-    if (!d) {
-        fprintf(stderr,"[WARNING] Could not open %s for writing.\n",buf);
-        return;
+  uint64_t bits = 0, v;
+  uintptr_t i, k = 0;
+  for(i=0;i<POND_DEPTH;++i) {
+    v = (uint64_t)(((i < n) ? in[i] : OP_STOP) & INST_MASK);
+    bits |= v << k;
+    k += INST_BITS;
+    if (k >= 64) {
+      *(g++) = bits;
+      k -= 64;
+      bits = k ? (v >> (INST_BITS - k)) : 0;
     }
+  }
+  if (k)
+    *g = bits;
+}
 
-    fprintf(stderr,"[INFO] Dumping viable cells to %s\n",buf);
+#define GENOME_AT(c, i) ((uint8_t)genomeGet(CELL_GENOME_WORDS(c), (i)))
 
-    for(x=0;x<POND_SIZE_X;++x) {
-        for(y=0;y<POND_SIZE_Y;++y) {
-            pptr = &pond[x][y];
-            if (pptr->energy&&(pptr->generation > 2)) {
-                dumpCell(d, pptr);
-            }
-        }
-    }
+#else
 
-    fclose(d);
-}
+#define GENOME_AT(c, i) (CELL_GENOME(c)[(i)])
+
+#endif /* GENOME_PACKED */
+
+/* Start of the memory holding the pond */
+static POND_STATE uint8_t *pondMemory;
 
-  
 /**
- * Get a neighbor in the pond
+ * Point the pond at the memory holding it
  *
- * @param x Starting X position
- * @param y Starting Y position
- * @param dir Direction to get neighbor from
- * @return Pointer to neighboring cell
+ * The whole pond lives in one block of POND_BYTES bytes, either
+ * allocated at startup or mapped from a checkpoint file.
+ *
+ * @param p Pond memory
  */
-#define X_EAST  x < (POND_SIZE_X-1) ? x+1 : 0
-#define X_WEST  x ? x-1 : POND_SIZE_X-1
-#define X_NONE  x
-#define Y_SOUTH y < (POND_SIZE_Y-1) ? y+1 : 0
-#define Y_NORTH y ? y-1 : POND_SIZE_Y-1
-#define Y_NONE  y
-static inline struct Cell *getNeighbor(const uintptr_t x, const uintptr_t y, const uintptr_t dir)
+static void setPondMemory(uint8_t *p)
 {
-    /* Space is toroidal; it wraps at edges */
-
-#if (DIRECTIONS == 4)
-    switch(dir & 0x3) {
-        case DIR_NORTH:
-            return &pond[ X_NONE ][ Y_NORTH ];
-        case DIR_EAST:
-            return &pond[ X_EAST ][ Y_NONE  ];
-        case DIR_SOUTH:
-            return &pond[ X_NONE ][ Y_SOUTH ];
-        case DIR_WEST:
-            return &pond[ X_WEST ][ Y_NONE  ];
-    }
-#elif (DIRECTIONS == 6)
-    if (y & 1) {
-        switch(dirmap[dir]) {
-            case DIR_0:
-                return &pond[ X_EAST ][ Y_NORTH ];
-            case DIR_1:
-                return &pond[ X_EAST ][ Y_NONE ];
-            case DIR_2:
-                return &pond[ X_EAST ][ Y_SOUTH ];
-            case DIR_3:
-                return &pond[ X_NONE ][ Y_SOUTH ];
-            case DIR_4:
-                return &pond[ X_WEST ][ Y_NONE  ];
-            case DIR_5:
-                return &pond[ X_NONE ][ Y_NORTH ];
-        }
-    }
-    else {
-        switch(dirmap[dir]) {
-            case DIR_0:
-                return &pond[ X_NONE ][ Y_NORTH ];
-            case DIR_1:
-                return &pond[ X_EAST ][ Y_NONE  ];
-            case DIR_2:
-                return &pond[ X_NONE ][ Y_SOUTH ];
-            case DIR_3:
-                return &pond[ X_WEST ][ Y_SOUTH ];
-            case DIR_4:
-                return &pond[ X_WEST ][ Y_NONE  ];
-            case DIR_5:
-                return &pond[ X_WEST ][ Y_NORTH ];
-        }
-    }
-#elif (DIRECTIONS == 8)
-    switch(dir & 0x7) {
-        case DIR_NORTH:
-            return &pond[ X_NONE ][ Y_NORTH ];
-        case DIR_NE:
-            return &pond[ X_EAST ][ Y_NORTH ];
-        case DIR_EAST:
-            return &pond[ X_EAST ][ Y_NONE  ];
-        case DIR_SE:
-            return &pond[ X_EAST ][ Y_SOUTH ];
-        case DIR_SOUTH:
-            return &pond[ X_NONE ][ Y_SOUTH ];
-        case DIR_SW:
-            return &pond[ X_WEST ][ Y_SOUTH ];
-        case DIR_WEST:
-            return &pond[ X_WEST ][ Y_NONE  ];
-        case DIR_NW:
-            return &pond[ X_WEST ][ Y_NORTH ];
-    }
-#endif
-    return &pond[ X_NONE ][ Y_NONE ]; /* This should never be reached */
+  pondMemory = p;
+#if POND_LAYOUT_SOA
+  pondEnergy = (uintptr_t *)p;
+  p += POND_CELLS * sizeof(uintptr_t);
+  pondGeneration = (uintptr_t *)p;
+  p += POND_CELLS * sizeof(uintptr_t);
+  pondIds = (struct CellIds *)p;
+  p += POND_CELLS * sizeof(struct CellIds);
+#if GENOME_HASH_CACHE
+  pondGenomeHash = (uint64_t *)p;
+  p += POND_CELLS * sizeof(uint64_t);
+  pondKinSum = (uint32_t *)p;
+  p += POND_CELLS * sizeof(uint32_t);
+#endif
+#if LOOP_JUMP_TABLE
+  pondGenomeVersion = (uint32_t *)p;
+  p += POND_CELLS * sizeof(uint32_t);
+#endif
+  pondLogoFacing = (struct CellLogoFacing *)p;
+  p += POND_CELLS * sizeof(struct CellLogoFacing);
+  pondRam = (uint8_t (*)[RAM_SIZE])p;
+  p += POND_CELLS * RAM_SIZE;
+#if GENOME_POOL
+  pondGenomeRef = (uint32_t *)p;
+#elif GENOME_PACKED
+  pondGenome = (uint64_t (*)[GENOME_WORDS])p;
+#else
+  pondGenome = (uint8_t (*)[POND_DEPTH])p;
+#endif
+#else
+  pond = (struct Cell *)p;
+#endif
 }
-#undef X_EAST
-#undef X_WEST
-#undef X_NONE
-#undef Y_SOUTH
-#undef Y_NORTH
-#undef Y_NONE
+
+#if DUMP_DELTA
+/* Per cell: nonzero if its record has changed since the last dump, and
+ * nonzero if it was in the state the last dump left */
+static POND_STATE uint8_t *dumpDirty = (uint8_t *)0;
+static POND_STATE uint8_t *dumpPresent = (uint8_t *)0;
+
+/* Number of dumps until the next full one; the first is always full */
+static POND_STATE uintptr_t dumpsToKeyframe = 0;
+
+/* Clock of the last dump written */
+static POND_STATE uint64_t lastDumpClock = 0;
+#endif /* DUMP_DELTA */
 
 /**
- * Determines if c1 is allowed to access c2
+ * Note that what a cell's dump record would hold has changed (see DUMP_DELTA)
  *
- * @param c2 Cell being accessed
- * @param c1guess c1's "guess"
- * @param sense The "sense" of this interaction
- * @return True or false (1 or 0)
+ * @param c Cell
  */
-static inline int accessAllowed(struct Cell *const c2,const uintptr_t c1guess,int sense)
+static inline void dumpRecordChanged(const uintptr_t c)
 {
-  /* Access permission is more probable if they are more similar in sense 0,
-   * and more probable if they are different in sense 1. Sense 0 is used for
-   * "negative" interactions and sense 1 for "positive" ones. */
-  return sense ?
-      (((getRandom() & 0xf) >= BITS_IN_FIVEBIT_WORD[(c2->logo ^ c1guess) & 0x1f]) || (!c2->parentID)) :
-      (((getRandom() & 0xf) <= BITS_IN_FIVEBIT_WORD[(c2->logo ^ c1guess) & 0x1f]) || (!c2->parentID));
+#if DUMP_DELTA
+  dumpDirty[c] = 1;
+#else
+  (void)c;
+#endif
 }
 
 /**
- * Gets the color that a cell should be
+ * Note that a cell's genome has been written
  *
- * @param c Cell to get color for
- * @return 8-bit color value
+ * Anything that writes to a genome does so through genomeWrite() or
+ * genomeSet(), or calls genomeRewritten() afterwards, which call this, so that cached
+ * LOOP/REP tables for it (see LOOP_JUMP_TABLE) are thrown away and the
+ * next delta dump includes it.
+ *
+ * @param c Cell
  */
-static inline uint8_t getColor(struct Cell *c)
+static inline void genomeChanged(const uintptr_t c)
 {
-  uintptr_t i, sum; /* inst, stopCount, skipnext; */
-
-  if (c->energy) {
-    switch(colorScheme) {
-      case KINSHIP:
-        /*
-         * Kinship color scheme by Christoph Groth
-         *
-         * For cells of generation > 1, saturation and value are set to maximum.
-         * Hue is a hash-value with the property that related genomes will have
-         * similar hue (but of course, as this is a hash function, totally
-         * different genomes can also have a similar or even the same hue).
-         * Therefore the difference in hue should to some extent reflect the grade
-         * of "kinship" of two cells.
-         */
-        if (c->generation > 1) {
-          sum = 0;
-#if 0
-          skipnext = 0;
-          stopCount = 0;
+#if LOOP_JUMP_TABLE
+  ++CELL_GENOME_VERSION(c);
 #endif
-          for(i = 0; i < POND_DEPTH; ++i) {
-              sum += c->genome[i];
+  dumpRecordChanged(c);
+}
 
-#if 0
-              inst = c->genome[i];
+#if (GENOME_HASH_CACHE || DUMP_ANALYSIS)
+/* Weight of each genome position in CELL_GENOME_HASH, see initGenomeHash() */
+static uint64_t genomeHashWeight[POND_DEPTH];
 
-              if (skipnext) {
-                  skipnext = 0;
-              }
-              else {
-                  if (inst != OP_STOP) {
-                      sum += inst;
-                  }
+/**
+ * Set up the genome hash weights (powers of GENOME_HASH_MULTIPLIER)
+ */
+static void initGenomeHash()
+{
+  uint64_t k = 1;
+  uintptr_t i;
+  for(i=0;i<POND_DEPTH;++i) {
+    k *= GENOME_HASH_MULTIPLIER;
+    genomeHashWeight[i] = k;
+  }
+}
+#endif /* GENOME_HASH_CACHE || DUMP_ANALYSIS */
 
-                  if (inst == OP_STOP) { /* STOP */
-                      if (++stopCount >= 4) {
-                          break;
-                      }
-                  }
-                  else {
-                      stopCount = 0;
-                      if (inst == 0xc) /* 0xc == XCHG */
-                          skipnext = 1; /* Skip "operand" after XCHG */
-                  }
-              }
+#if GENOME_POOL
+
+#if (POND_DEPTH % 8)
+#error "GENOME_POOL needs POND_DEPTH to be a multiple of 8"
 #endif
-          }
-          /* For the hash-value use a wrapped around sum of the sum of all
-           * commands and the length of the genome. */
-          return (uint8_t)((sum % 192) + 64);
-        }
-        return 0;
-      case LINEAGE:
-        /*
-         * Cells with generation > 1 are color-coded by lineage.
-         */
-        return (c->generation > 1) ? (((uint8_t)c->lineage) | (uint8_t)1) : 0;
-      case LOGO:
-        return (c->generation > 1) ? (uint8_t)(73 + c->logo) : 0;
-      case FACING:
-        return (c->generation > 1) ? (uint8_t)(157 + c->facing) : 0;
-      case ENERGY1:
-        return (c->generation > 1 && maxLivingCellEnergy > 0) ?
-            (uint8_t)(255.0 * ((double)c->energy / (double)maxLivingCellEnergy)) : 0;
-      case ENERGY2:
-        return (maxCellEnergy > 0) ?
-            (uint8_t)(255.0 * ((double)c->energy / (double)maxCellEnergy)) : 0;
-      case RAM0:
-        if (c->generation > 1) {
+#if (((POND_SIZE_X) * (POND_SIZE_Y)) >= 0xfffffffe)
+#error "GENOME_POOL needs fewer than 2^32 - 2 cells"
+#endif
+
+/**
+ * Hash a whole genome for the genome pool's hash table
+ *
+ * @param g POND_DEPTH instructions
+ * @return Hash
+ */
+static inline uint64_t genomePoolHash(const uint8_t *const g)
+{
+  uint64_t hash = 0, k;
+  uintptr_t i;
+  for(i=0;i<POND_DEPTH;i+=sizeof(uint64_t)) {
+    memcpy(&k, g + i, sizeof(uint64_t));
+    hash = (hash ^ k) * GENOME_HASH_MULTIPLIER;
+    hash ^= hash >> 29;
+  }
+  return hash;
+}
+
+/**
+ * Get the first block of a genome pool hash bucket
+ *
+ * @param hash Genome hash
+ * @return Head of the bucket's chain
+ */
+static inline uint32_t *genomePoolBucket(const uint64_t hash)
+{
+  return &genomePoolTable[(hash ^ (hash >> 32)) & (GENOME_POOL_BUCKETS - 1)];
+}
+
+/**
+ * Take a block from the genome pool
+ *
+ * @return Block, with its fields left for the caller to fill in
+ */
+static inline uint32_t genomePoolTake()
+{
+  uint32_t b = genomePoolFree;
+  if (b)
+    genomePoolFree = genomePool[b].next;
+  else b = genomePoolUsed++;
+  return b;
+}
+
+/**
+ * Take a block out of the hash table, so that it can be written
+ *
+ * @param b Interned block
+ */
+static inline void genomePoolUnintern(const uint32_t b)
+{
+  uint32_t *p = genomePoolBucket(genomePool[b].hash);
+  while (*p != b)
+    p = &genomePool[*p].next;
+  *p = genomePool[b].next;
+  genomePool[b].interned = 0;
+}
+
+/**
+ * Drop a cell's hold on a block, freeing the block if it was the last
+ *
+ * @param b Block
+ */
+static inline void genomePoolRelease(const uint32_t b)
+{
+  if (!--genomePool[b].refs) {
+    if (genomePool[b].interned)
+      genomePoolUnintern(b);
+    genomePool[b].next = genomePoolFree;
+    genomePoolFree = b;
+  }
+}
+
+/**
+ * Get a block holding a genome, sharing an equal one if there is one
+ *
+ * @param g POND_DEPTH instructions
+ * @return Block, with the caller's hold on it counted
+ */
+static uint32_t genomePoolIntern(const uint8_t *const g)
+{
+  const uint64_t hash = genomePoolHash(g);
+  uint32_t *const bucket = genomePoolBucket(hash);
+  uint32_t b;
+
+  for(b=*bucket;b;b=genomePool[b].next) {
+    if ((genomePool[b].hash == hash)&&(!memcmp(genomePool[b].genome, g, POND_DEPTH))) {
+      ++genomePool[b].refs;
+      return b;
+    }
+  }
+  b = genomePoolTake();
+  genomePool[b].refs = 1;
+  genomePool[b].next = *bucket;
+  genomePool[b].interned = 1;
+  genomePool[b].hash = hash;
+  memcpy(genomePool[b].genome, g, POND_DEPTH);
+  *bucket = b;
+  return b;
+}
+
+/**
+ * Allocate the genome pool's memory
+ *
+ * The pool is reserved for GENOME_POOL_BLOCKS blocks up front, so blocks
+ * never move, but only the pages of blocks that get used are ever
+ * backed by memory.
+ *
+ * @return 0 on success, -1 on error
+ */
+static int allocGenomePool()
+{
+  void *p = mmap((void *)0, GENOME_POOL_BLOCKS * sizeof(struct GenomeBlock), PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+  if (p == MAP_FAILED)
+    return -1;
+  genomePool = (struct GenomeBlock *)p;
+  genomePoolTable = (uint32_t *)calloc(GENOME_POOL_BUCKETS, sizeof(uint32_t));
+  if (!genomePoolTable) {
+    munmap(p, GENOME_POOL_BLOCKS * sizeof(struct GenomeBlock));
+    genomePool = (struct GenomeBlock *)0;
+    return -1;
+  }
+  genomePoolFree = 0;
+  genomePoolUsed = 1;
+  return 0;
+}
+
+/**
+ * Set up the genome pool for a new pond, whose cells all share one
+ * genome of all STOPs
+ *
+ * @return 0 on success, -1 on error
+ */
+static int initGenomePool()
+{
+  uint8_t genome[POND_DEPTH];
+  uintptr_t c;
+  uint32_t b;
+
+  if (allocGenomePool())
+    return -1;
+  memset(genome, OP_STOP, POND_DEPTH);
+  b = genomePoolIntern(genome);
+  genomePool[b].refs = POND_CELLS;
+  for(c=0;c<POND_CELLS;++c)
+    CELL_GENOME_REF(c) = b;
+  return 0;
+}
+
+/**
+ * Free the genome pool
+ */
+static void releaseGenomePool()
+{
+  if (genomePool)
+    munmap(genomePool, GENOME_POOL_BLOCKS * sizeof(struct GenomeBlock));
+  genomePool = (struct GenomeBlock *)0;
+  free(genomePoolTable);
+  genomePoolTable = (uint32_t *)0;
+}
+
+#endif /* GENOME_POOL */
+
+/* ----------------------------------------------------------------------- */
+/* Vector kernels                                                          */
+/* ----------------------------------------------------------------------- */
+
+/*
+ * The loops over a whole genome or a whole plane of the pond that are
+ * not plain fills or copies (which go through memset() and memcpy(), and
+ * so through the C library's own vector code) have a scalar version and,
+ * with SIMD_KERNELS, vector versions that give the same results.
+ * initKernels() picks the best set the processor supports at startup.
+ */
+
+struct PopulationTotals;
+
+/**
+ * A set of kernels
+ */
+struct Kernels
+{
+  const char *name;
+
+  /* Sum of the POND_DEPTH instructions of a genome */
+  uint32_t (*genomeSum)(const uint8_t *g);
+
+  /* Sum of the POND_DEPTH instructions of a genome, each times its
+   * weight, wrapping at 64 bits */
+  uint64_t (*genomeHash)(const uint8_t *g, const uint64_t *weights);
+
+  /* Add n cells (given as energy and generation planes) to population
+   * totals, see scanPopulation() */
+  void (*scanPlanes)(const uintptr_t *energy, const uintptr_t *generation, uintptr_t n, struct PopulationTotals *t);
+};
+
+/* Kernels in use, see initKernels() */
+static struct Kernels kernels;
+
+/**
+ * Sum bytes
+ *
+ * @param g Bytes
+ * @param n Number of bytes
+ * @return Sum
+ */
+static inline uint32_t sumBytes(const uint8_t *g, const uintptr_t n)
+{
+  uint32_t sum = 0;
+  uintptr_t i;
+  for(i=0;i<n;++i)
+    sum += g[i];
+  return sum;
+}
+
+/**
+ * Sum bytes times weights, wrapping at 64 bits
+ *
+ * @param g Bytes
+ * @param weights One weight per byte
+ * @param n Number of bytes
+ * @return Sum
+ */
+static inline uint64_t hashBytes(const uint8_t *g, const uint64_t *weights, const uintptr_t n)
+{
+  uint64_t hash = 0;
+  uintptr_t i;
+  for(i=0;i<n;++i)
+    hash += (uint64_t)g[i] * weights[i];
+  return hash;
+}
+
+/* The kernels for each instruction set, see struct Kernels. The vector
+ * ones leave any rest of the genome shorter than a vector to the scalar
+ * loops above. */
+
+static uint32_t genomeSumScalar(const uint8_t *g)
+{
+  return sumBytes(g, POND_DEPTH);
+}
+
+static uint64_t genomeHashScalar(const uint8_t *g, const uint64_t *weights)
+{
+  return hashBytes(g, weights, POND_DEPTH);
+}
+
+#if SIMD_X86
+
+#ifdef __SSE2__
+static uint32_t genomeSumSse2(const uint8_t *g)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc = zero;
+  uintptr_t i;
+  for(i=0;(i+16)<=POND_DEPTH;i+=16)
+    acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i *)(g + i)), zero));
+  return (uint32_t)_mm_cvtsi128_si32(acc) + (uint32_t)_mm_cvtsi128_si32(_mm_unpackhi_epi64(acc, acc)) + sumBytes(g + i, POND_DEPTH - i);
+}
+#endif /* __SSE2__ */
+
+__attribute__((target("avx2")))
+static uint32_t genomeSumAvx2(const uint8_t *g)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i acc = zero;
+  __m128i s;
+  uintptr_t i;
+  for(i=0;(i+32)<=POND_DEPTH;i+=32)
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_loadu_si256((const __m256i *)(g + i)), zero));
+  s = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  return (uint32_t)_mm_cvtsi128_si32(s) + (uint32_t)_mm_cvtsi128_si32(_mm_unpackhi_epi64(s, s)) + sumBytes(g + i, POND_DEPTH - i);
+}
+
+/* 64-bit multiplies are done as two 32-bit ones, which is exact since
+ * the products only need to be right modulo 2^64 */
+__attribute__((target("avx2")))
+static uint64_t genomeHashAvx2(const uint8_t *g, const uint64_t *weights)
+{
+  __m256i acc = _mm256_setzero_si256(), v, w;
+  uint64_t lanes[4];
+  uint32_t k;
+  uintptr_t i;
+  for(i=0;(i+4)<=POND_DEPTH;i+=4) {
+    memcpy(&k, g + i, sizeof(k));
+    v = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128((int)k));
+    w = _mm256_loadu_si256((const __m256i *)(weights + i));
+    acc = _mm256_add_epi64(acc, _mm256_mul_epu32(v, w));
+    acc = _mm256_add_epi64(acc, _mm256_slli_epi64(_mm256_mul_epu32(v, _mm256_srli_epi64(w, 32)), 32));
+  }
+  _mm256_storeu_si256((__m256i *)lanes, acc);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + hashBytes(g + i, weights + i, POND_DEPTH - i);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512dq")))
+static uint32_t genomeSumAvx512(const uint8_t *g)
+{
+  const __m512i zero = _mm512_setzero_si512();
+  __m512i acc = zero;
+  uintptr_t i;
+  for(i=0;(i+64)<=POND_DEPTH;i+=64)
+    acc = _mm512_add_epi64(acc, _mm512_sad_epu8(_mm512_loadu_si512((const void *)(g + i)), zero));
+  return (uint32_t)_mm512_reduce_add_epi64(acc) + sumBytes(g + i, POND_DEPTH - i);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512dq")))
+static uint64_t genomeHashAvx512(const uint8_t *g, const uint64_t *weights)
+{
+  __m512i acc = _mm512_setzero_si512();
+  uintptr_t i;
+  for(i=0;(i+8)<=POND_DEPTH;i+=8)
+    acc = _mm512_add_epi64(acc, _mm512_mullo_epi64(_mm512_cvtepu8_epi64(_mm_loadl_epi64((const __m128i *)(g + i))), _mm512_loadu_si512((const void *)(weights + i))));
+  return (uint64_t)_mm512_reduce_add_epi64(acc) + hashBytes(g + i, weights + i, POND_DEPTH - i);
+}
+
+#elif SIMD_NEON
+
+static uint32_t genomeSumNeon(const uint8_t *g)
+{
+  uint32x4_t acc = vdupq_n_u32(0);
+  uintptr_t i;
+  for(i=0;(i+16)<=POND_DEPTH;i+=16)
+    acc = vpadalq_u16(acc, vpaddlq_u8(vld1q_u8(g + i)));
+  return vaddvq_u32(acc) + sumBytes(g + i, POND_DEPTH - i);
+}
+
+/* As for AVX2, 64-bit multiplies are done as two 32-bit ones */
+static uint64_t genomeHashNeon(const uint8_t *g, const uint64_t *weights)
+{
+  uint64x2_t acc = vdupq_n_u64(0), w;
+  uint32x4_t v[2];
+  uint16x8_t b;
+  uintptr_t i, k;
+  for(i=0;(i+8)<=POND_DEPTH;i+=8) {
+    b = vmovl_u8(vld1_u8(g + i));
+    v[0] = vmovl_u16(vget_low_u16(b));
+    v[1] = vmovl_u16(vget_high_u16(b));
+    for(k=0;k<4;++k) {
+      const uint32x2_t pair = (k & 1) ? vget_high_u32(v[k >> 1]) : vget_low_u32(v[k >> 1]);
+      w = vld1q_u64(weights + i + (k * 2));
+      acc = vaddq_u64(acc, vmull_u32(pair, vmovn_u64(w)));
+      acc = vaddq_u64(acc, vshlq_n_u64(vmull_u32(pair, vshrn_n_u64(w, 32)), 32));
+    }
+  }
+  return vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1) + hashBytes(g + i, weights + i, POND_DEPTH - i);
+}
+
+#endif /* SIMD_X86 / SIMD_NEON */
+
+/**
+ * Write one instruction of a cell's genome
+ *
+ * @param c Cell
+ * @param i Position in the genome
+ * @param inst Instruction
+ */
+static inline void genomeWrite(const uintptr_t c, const uintptr_t i, const uintptr_t inst)
+{
+#if GENOME_HASH_CACHE
+  const uint64_t delta = (uint64_t)inst - (uint64_t)GENOME_AT(c, i);
+  CELL_KIN_SUM(c) += (uint32_t)delta;
+  CELL_GENOME_HASH(c) += delta * genomeHashWeight[i];
+#endif
+#if GENOME_POOL
+  uint32_t b = CELL_GENOME_REF(c);
+  if (genomePool[b].genome[i] != (uint8_t)inst) {
+    if (genomePool[b].refs > 1) { /* Shared, so make a private copy */
+      const uint32_t shared = b;
+      b = genomePoolTake();
+      genomePool[b].refs = 1;
+      genomePool[b].interned = 0;
+      memcpy(genomePool[b].genome, genomePool[shared].genome, POND_DEPTH);
+      --genomePool[shared].refs;
+      CELL_GENOME_REF(c) = b;
+    } else if (genomePool[b].interned) {
+      genomePoolUnintern(b);
+    }
+    genomePool[b].genome[i] = (uint8_t)inst;
+  }
+#elif GENOME_PACKED
+  genomePut(CELL_GENOME_WORDS(c), i, inst);
+#else
+  CELL_GENOME(c)[i] = (uint8_t)inst;
+#endif
+  genomeChanged(c);
+}
+
+/**
+ * Note that a cell's whole genome has been written
+ *
+ * @param c Cell
+ */
+static inline void genomeRewritten(const uintptr_t c)
+{
+#if GENOME_HASH_CACHE
+#if GENOME_PACKED
+  uint8_t g[POND_DEPTH];
+  genomeUnpack(CELL_GENOME_WORDS(c), g);
+#else
+  const uint8_t *const g = CELL_GENOME(c);
+#endif
+  CELL_KIN_SUM(c) = kernels.genomeSum(g);
+  CELL_GENOME_HASH(c) = kernels.genomeHash(g, genomeHashWeight);
+#endif
+  genomeChanged(c);
+}
+
+/**
+ * Replace a cell's whole genome
+ *
+ * @param c Cell
+ * @param g Start of the new genome
+ * @param n Number of instructions in g, the rest being filled with STOP
+ */
+static inline void genomeSet(const uintptr_t c, const uint8_t *const g, const uintptr_t n)
+{
+#if GENOME_POOL
+  uint8_t genome[POND_DEPTH];
+  const uint32_t old = CELL_GENOME_REF(c);
+  if (n)
+    memcpy(genome, g, n);
+  memset(genome + n, OP_STOP, POND_DEPTH - n);
+  CELL_GENOME_REF(c) = genomePoolIntern(genome);
+  genomePoolRelease(old);
+#elif GENOME_PACKED
+  genomePack(CELL_GENOME_WORDS(c), g, n);
+#else
+  if (n)
+    memcpy(CELL_GENOME(c), g, n);
+  memset(CELL_GENOME(c) + n, OP_STOP, POND_DEPTH - n);
+#endif
+  genomeRewritten(c);
+}
+
+/* Currently selected color scheme */
+enum {
+    KINSHIP, LINEAGE,
+    LOGO, FACING,
+    ENERGY1, ENERGY2,
+    RAM0, RAM1,
+    MAX_COLOR_SCHEME
+} colorScheme = KINSHIP;
+
+const char *colorSchemeName[MAX_COLOR_SCHEME] = {
+    "KINSHIP", "LINEAGE",
+    "LOGO", "FACING",
+    "ENERGY1", "ENERGY2",
+    "RAM0", "RAM1"
+};
+
+/**
+ * Structure for keeping some running tally type statistics
+ *
+ * Every worker counts into its own copy (see struct Worker), which is
+ * on cache lines of its own, and the copies are summed at report time
+ * while the workers are stopped, so counting is a plain integer add.
+ */
+struct PerReportStatCounters
+{
+  /* Counts for the number of times each instruction was
+   * executed since the last report. */
+  uint64_t instructionExecutions[NUM_INST];
+  
+  /* Number of cells executed since last report */
+  uint64_t cellExecutions;
+
+  /* Number of viable cells replaced by other cells' offspring */
+  uint64_t viableCellsReplaced;
+  
+  /* Number of viable cells KILLed */
+  uint64_t viableCellsKilled;
+  
+  /* Number of successful SHARE operations */
+  uint64_t viableCellShares;
+
+  /* memory access stats */
+
+  uint64_t memSpecialReads;
+  uint64_t memPrivateReads;
+  uint64_t memOutputReads;
+  uint64_t memInputReads;
+
+  uint64_t memSpecialWrites;
+  uint64_t memPrivateWrites;
+  uint64_t memOutputWrites;
+  uint64_t memInputWrites;
+
+};
+
+/**
+ * Population totals shown in each report
+ */
+struct PopulationTotals
+{
+  /* Cells with energy, and those of them of generation > 1 (living) and
+   * generation > 2 (viable replicators) */
+  uint64_t activeCells;
+  uint64_t livingCells;
+  uint64_t viableReplicators;
+
+  /* Energy in each of those groups of cells */
+  uint64_t totalEnergy;
+  uint64_t livingEnergy;
+  uint64_t viableEnergy;
+
+  uintptr_t maxCellEnergy;
+  uintptr_t maxLivingCellEnergy;
+  uintptr_t maxGeneration;
+};
+
+#if INCREMENTAL_STATS
+
+/**
+ * Count of cells with each value, grown as needed. Counts in a worker
+ * are changes since the last merge and can be negative.
+ */
+struct Histogram
+{
+  int32_t *count;
+  uintptr_t size;
+};
+
+/**
+ * Running population totals, kept up to date by populationRemove() and
+ * populationAdd() around every change to a cell's energy or generation.
+ * The maxima are found from histograms of active cells' energies (all,
+ * and living only) and generations.
+ */
+struct PopulationStats
+{
+  int64_t activeCells;
+  int64_t livingCells;
+  int64_t viableReplicators;
+  int64_t totalEnergy;
+  int64_t livingEnergy;
+  int64_t viableEnergy;
+  struct Histogram energyHist;
+  struct Histogram livingEnergyHist;
+  struct Histogram generationHist;
+};
+
+#endif /* INCREMENTAL_STATS */
+
+/* Global statistics counters (the sum of all workers' counters, merged
+ * at report time) */
+POND_STATE struct PerReportStatCounters statCounters;
+
+/* Instructions executed up to the last report, and the number of reports
+ * and the time spent making them */
+static POND_STATE uint64_t instructionsExecuted = 0;
+static POND_STATE uint64_t reportCount = 0;
+static POND_STATE double reportSeconds = 0.0;
+
+/**
+ * Source of cell IDs. The serial engine has one, starting at 0 with a
+ * stride of 1. The parallel engine gives each worker (or each tile, if
+ * PARALLEL_DETERMINISTIC) its own, interleaved by the stride, so IDs stay
+ * unique without any locking.
+ */
+struct CellIdCounter
+{
+  uint64_t next;
+  uint64_t stride;
+};
+
+/* Take the current ID and advance (used by KILL and inflow) */
+static inline uint64_t takeCellId(struct CellIdCounter *const ids)
+{
+  const uint64_t id = ids->next;
+  ids->next += ids->stride;
+  return id;
+}
+
+/* Advance and take the new ID (used for offspring) */
+static inline uint64_t advanceCellId(struct CellIdCounter *const ids)
+{
+  ids->next += ids->stride;
+  return ids->next;
+}
+
+#if LOOP_JUMP_TABLE
+
+#if (LOOP_JUMP_CACHE_SIZE & (LOOP_JUMP_CACHE_SIZE - 1))
+#error "LOOP_JUMP_CACHE_SIZE must be a power of two"
+#endif
+#if (POND_DEPTH >= 0xffff)
+#error "LOOP_JUMP_TABLE needs POND_DEPTH below 65535"
+#endif
+
+/* Distance value for a LOOP that has no matching REP */
+#define LOOP_JUMP_NONE 0xffff
+
+/**
+ * Matching-bracket table for one cell's genome. distance[p] is the
+ * number of instructions from the LOOP at p to its matching REP, 0 if
+ * not worked out yet, or LOOP_JUMP_NONE if there is none.
+ */
+struct LoopJumpEntry
+{
+  uintptr_t cell;
+  uint32_t version;
+  uint16_t distance[POND_DEPTH];
+};
+
+#endif /* LOOP_JUMP_TABLE */
+
+#if PROFILE_CYCLES
+
+/* Buckets of the log2 histograms; the last also counts anything larger */
+#define PROFILE_HIST_BUCKETS 24
+
+/* Phases of a cell execution */
+#define PROFILE_RESET     0
+#define PROFILE_RUN       1
+#define PROFILE_REPRODUCE 2
+#define PROFILE_PHASES    3
+
+/* Instruction classes timed besides the instructions themselves:
+ * skipping through a false LOOP/REP block (the THREADED interpreter
+ * counts that as part of LOOP), and the start of a run */
+#define PROFILE_OP_SKIP NUM_INST
+#define PROFILE_OP_NONE (NUM_INST + 1)
+#define PROFILE_OPS     (NUM_INST + 2)
+
+/**
+ * Cycle counters and histograms kept when PROFILE_CYCLES is set
+ */
+struct ProfileCounters
+{
+  uint64_t executions;
+  uint64_t phaseCycles[PROFILE_PHASES];
+  /* Cycles from the start of each instruction to the start of the next */
+  uint64_t opCycles[PROFILE_OPS];
+  uint64_t opCount[PROFILE_OPS];
+  /* Instructions run per execution, by 1 + floor(log2(n)) (0 for none) */
+  uint64_t instructionHist[PROFILE_HIST_BUCKETS];
+  /* Energy left at the end of the run, bucketed the same way */
+  uint64_t energyHist[PROFILE_HIST_BUCKETS];
+};
+
+#endif /* PROFILE_CYCLES */
+
+#if BIRTH_LOG
+
+#if (!GENOME_HASH_CACHE)
+#error "BIRTH_LOG needs GENOME_HASH_CACHE"
+#endif
+#if ((POND_SIZE_X > 65536) || (POND_SIZE_Y > 65536))
+#error "BIRTH_LOG positions are 16 bits"
+#endif
+
+/* Size of a record in the birth log */
+#define BIRTH_RECORD_BYTES 48
+
+/**
+ * A birth waiting in a worker to be written to the log
+ */
+struct BirthRecord
+{
+  uint64_t id;
+  uint64_t parentId;
+  uint64_t lineage;
+  uint64_t clock;
+  uint64_t genomeHash;
+  uint32_t generation;
+  uint16_t x;
+  uint16_t y;
+};
+
+#endif /* BIRTH_LOG */
+
+#if EXEC_TRACE
+
+#if (!GENOME_HASH_CACHE)
+#error "EXEC_TRACE needs GENOME_HASH_CACHE"
+#endif
+#if ((POND_DEPTH << INST_BITS) > 65536)
+#error "EXEC_TRACE steps are 16 bits"
+#endif
+#if ((EXEC_TRACE_SAMPLE < 1) || (EXEC_TRACE_STEPS > 65535))
+#error "EXEC_TRACE_SAMPLE must be at least 1 and EXEC_TRACE_STEPS at most 65535"
+#endif
+
+/* Banks of the memory seen by read_mem() and write_mem(), 8 bytes each */
+#define TRACE_BANKS (MEM_SIZE / 8)
+
+/* How a traced execution ended */
+#define TRACE_STOPPED   0
+#define TRACE_EXHAUSTED 1
+#define TRACE_OVERFLOW  2
+
+/**
+ * A traced execution, see execCell()
+ */
+struct TraceRecord
+{
+  uint64_t genomeHash;
+  uint64_t id;
+  uint64_t lineage;
+  uint64_t clock;
+  uint32_t generation;
+  /* Instructions run, including any past EXEC_TRACE_STEPS */
+  uint32_t instructions;
+  /* LOOPs entered with a nonzero register, REPs that jumped back and
+   * LOOPs skipped to their REP */
+  uint32_t loopEntries;
+  uint32_t loopRepeats;
+  uint32_t loopSkips;
+  uint32_t memReads[TRACE_BANKS];
+  uint32_t memWrites[TRACE_BANKS];
+  uint8_t outcome;
+  uint8_t reproduced;
+  uint16_t stepCount;
+  /* Position << INST_BITS | instruction, for each instruction run */
+  uint16_t steps[EXEC_TRACE_STEPS];
+};
+
+#endif /* EXEC_TRACE */
+
+/**
+ * Per-thread execution context
+ */
+struct Worker
+{
+  /* Random number generator and cell ID source currently in use. These
+   * point at the worker's own below, or at the tile being run when
+   * PARALLEL_DETERMINISTIC is set. */
+  struct RandomState *rng;
+  struct CellIdCounter *ids;
+
+  /* Statistics for this worker, merged into statCounters by doReport().
+   * Aligned so that no two workers' counters share a cache line. */
+  _Alignas(CACHE_LINE_BYTES) struct PerReportStatCounters stats;
+
+#if INCREMENTAL_STATS
+  /* Changes to the population totals since the last merge */
+  struct PopulationStats population;
+#endif
+
+#if MUTATION_SKIP_AHEAD
+  /* Instructions left to execute before the next mutation */
+  uintptr_t mutationCountdown;
+#endif
+
+#if PROFILE_CYCLES
+  /* Merged and written out by writeProfile() */
+  struct ProfileCounters profile;
+#endif
+
+  struct RandomState ownRng;
+  struct CellIdCounter ownIds;
+
+#if LOOP_JUMP_TABLE
+  /* Direct-mapped by cell index; all zero is a valid empty state since
+   * a distance of 0 means "not worked out yet" */
+  struct LoopJumpEntry loopJumps[LOOP_JUMP_CACHE_SIZE];
+#endif
+
+#if BIRTH_LOG
+  /* Births not yet copied into the log, see logBirth() */
+  struct BirthRecord births[BIRTH_LOG_BATCH];
+  uintptr_t birthCount;
+#endif
+
+#if EXEC_TRACE
+  /* The trace of the execution being run, or NULL if it is not traced,
+   * executions left until the next traced one, and the number traced
+   * since the ring was last written out by flushTraces() (the ring holds
+   * the last EXEC_TRACE_RING of them) */
+  struct TraceRecord *trace;
+  uintptr_t traceCountdown;
+  uint64_t traceCount;
+  struct TraceRecord traces[EXEC_TRACE_RING];
+#endif
+
+#if (PARALLEL_THREADS > 0)
+  pthread_t thread;
+#endif
+};
+
+#if (PARALLEL_THREADS > 0)
+#define NUM_WORKERS PARALLEL_THREADS
+#else
+#define NUM_WORKERS 1
+#endif
+
+/* Worker 0 is the main thread */
+static POND_STATE struct Worker workers[NUM_WORKERS];
+
+#if MUTATION_SKIP_AHEAD
+#if (MUTATION_RATE <= 0)
+#error "MUTATION_SKIP_AHEAD needs a nonzero MUTATION_RATE"
+#endif
+
+/**
+ * Get the number of instructions to execute before the next mutation
+ *
+ * Each instruction mutates with probability p = MUTATION_RATE / 2^32, so
+ * the number of unmutated instructions before one that mutates follows a
+ * geometric distribution, sampled here by inversion.
+ *
+ * @param r Generator
+ * @return Number of instructions that will not be mutated
+ */
+static uintptr_t nextMutationDistance(struct RandomState *const r)
+{
+  /* log(1-p), computed on first use (before any workers are started) */
+  static POND_STATE double logq = 0.0;
+  double u, k;
+
+  if (logq == 0.0)
+    logq = log1p(-((double)config.mutationRate / 4294967296.0));
+
+  /* Uniform in (0,1] from the top 53 bits */
+  u = ((double)((((uint64_t)getRandom(r)) >> 11) + 1)) * (1.0 / 9007199254740992.0);
+  k = floor(log(u) / logq);
+  return (k < (double)UINTPTR_MAX) ? (uintptr_t)k : UINTPTR_MAX;
+}
+#endif /* MUTATION_SKIP_AHEAD */
+
+/**
+ * Zero a set of stat counters
+ *
+ * @param s Counters to clear
+ */
+static void clearStatCounters(struct PerReportStatCounters *const s)
+{
+  memset(s, 0, sizeof(struct PerReportStatCounters));
+}
+
+/**
+ * Add a set of stat counters to another
+ *
+ * @param d Counters to add to
+ * @param s Counters to add
+ */
+static void addStatCounters(struct PerReportStatCounters *const d, const struct PerReportStatCounters *const s)
+{
+  uintptr_t i;
+  for(i=0;i<NUM_INST;++i)
+    d->instructionExecutions[i] += s->instructionExecutions[i];
+  d->cellExecutions += s->cellExecutions;
+  d->viableCellsReplaced += s->viableCellsReplaced;
+  d->viableCellsKilled += s->viableCellsKilled;
+  d->viableCellShares += s->viableCellShares;
+  d->memSpecialReads += s->memSpecialReads;
+  d->memPrivateReads += s->memPrivateReads;
+  d->memOutputReads += s->memOutputReads;
+  d->memInputReads += s->memInputReads;
+  d->memSpecialWrites += s->memSpecialWrites;
+  d->memPrivateWrites += s->memPrivateWrites;
+  d->memOutputWrites += s->memOutputWrites;
+  d->memInputWrites += s->memInputWrites;
+}
+
+/**
+ * Sum all workers' stat counters into statCounters and clear them
+ */
+static void mergeStatCounters()
+{
+  uintptr_t k;
+  for(k=0;k<NUM_WORKERS;++k) {
+    addStatCounters(&statCounters, &workers[k].stats);
+    clearStatCounters(&workers[k].stats);
+  }
+}
+
+#if PROFILE_CYCLES
+
+/* Where writeProfile() writes, opened by the first report */
+static POND_STATE FILE *profileFile = (FILE *)0;
+
+/**
+ * Read the cycle counter
+ *
+ * @return Cycles (nanoseconds where there is no rdtsc)
+ */
+static inline uint64_t profileNow()
+{
+#if (defined(__x86_64__) || defined(__i386__))
+  return (uint64_t)__rdtsc();
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return ((uint64_t)t.tv_sec * 1000000000ULL) + (uint64_t)t.tv_nsec;
+#endif
+}
+
+/**
+ * Get the histogram bucket of a value
+ *
+ * @param n Value
+ * @return 1 + floor(log2(n)), 0 for 0, at most PROFILE_HIST_BUCKETS - 1
+ */
+static inline uintptr_t profileBucket(uintptr_t n)
+{
+  uintptr_t b = 0;
+  while ((n)&&(b < (PROFILE_HIST_BUCKETS - 1))) {
+    n >>= 1;
+    ++b;
+  }
+  return b;
+}
+
+/**
+ * Sum all workers' profile counters, write them to profile.csv as one
+ * line and clear them (call while no workers are running)
+ *
+ * The columns are the clock, the number of executions, the cycles per
+ * execution of each phase, the cycles per instruction of each
+ * instruction and of false loop skipping, and the two histograms; the
+ * first line of the file names them.
+ *
+ * @param clock Current clock
+ */
+static void writeProfile(const uint64_t clock)
+{
+  struct ProfileCounters t;
+  char path[sizeof(config.outputPrefix) + 16];
+  uintptr_t i, k;
+
+  memset(&t, 0, sizeof(t));
+  for(k=0;k<NUM_WORKERS;++k) {
+    const struct ProfileCounters *const p = &workers[k].profile;
+    t.executions += p->executions;
+    for(i=0;i<PROFILE_PHASES;++i)
+      t.phaseCycles[i] += p->phaseCycles[i];
+    for(i=0;i<PROFILE_OPS;++i) {
+      t.opCycles[i] += p->opCycles[i];
+      t.opCount[i] += p->opCount[i];
+    }
+    for(i=0;i<PROFILE_HIST_BUCKETS;++i) {
+      t.instructionHist[i] += p->instructionHist[i];
+      t.energyHist[i] += p->energyHist[i];
+    }
+    memset(&workers[k].profile, 0, sizeof(struct ProfileCounters));
+  }
+
+  if (!profileFile) {
+    snprintf(path, sizeof(path), "%sprofile.csv", config.outputPrefix);
+    profileFile = fopen(path, "w");
+    if (!profileFile) {
+      fprintf(stderr,"[WARNING] Could not open %s for writing.\n", path);
+      return;
+    }
+    fprintf(profileFile, "clock,executions,reset_cycles,run_cycles,reproduce_cycles");
+    for(i=0;i<NUM_INST;++i)
+      fprintf(profileFile, ",op_%c_cycles", inst_chars[i]);
+    fprintf(profileFile, ",skip_cycles");
+    for(i=0;i<PROFILE_HIST_BUCKETS;++i)
+      fprintf(profileFile, ",instructions_hist_%u", (unsigned int)i);
+    for(i=0;i<PROFILE_HIST_BUCKETS;++i)
+      fprintf(profileFile, ",energy_hist_%u", (unsigned int)i);
+    fprintf(profileFile, "\n");
+  }
+
+  fprintf(profileFile, "%ju,%ju", (uintmax_t)clock, (uintmax_t)t.executions);
+  for(i=0;i<PROFILE_PHASES;++i)
+    fprintf(profileFile, ",%.1f", t.executions ? ((double)t.phaseCycles[i] / (double)t.executions) : 0.0);
+  for(i=0;i<=PROFILE_OP_SKIP;++i)
+    fprintf(profileFile, ",%.1f", t.opCount[i] ? ((double)t.opCycles[i] / (double)t.opCount[i]) : 0.0);
+  for(i=0;i<PROFILE_HIST_BUCKETS;++i)
+    fprintf(profileFile, ",%ju", (uintmax_t)t.instructionHist[i]);
+  for(i=0;i<PROFILE_HIST_BUCKETS;++i)
+    fprintf(profileFile, ",%ju", (uintmax_t)t.energyHist[i]);
+  fprintf(profileFile, "\n");
+  fflush(profileFile);
+}
+
+#endif /* PROFILE_CYCLES */
+
+#if INCREMENTAL_STATS
+
+/* Population totals as of the last merge */
+static POND_STATE struct PopulationStats population;
+
+/**
+ * Add to the count of a value in a histogram
+ *
+ * @param h Histogram
+ * @param v Value
+ * @param d Amount to add to its count
+ */
+static void histogramAdd(struct Histogram *const h, const uintptr_t v, const int32_t d)
+{
+  if (v >= h->size) {
+    uintptr_t size = h->size ? h->size : 1024;
+    while (size <= v)
+      size <<= 1;
+    h->count = (int32_t *)realloc(h->count, size * sizeof(int32_t));
+    if (!h->count) {
+      fprintf(stderr,"[ERROR] Out of memory growing a population histogram\n");
+      exit(1);
+    }
+    memset(h->count + h->size, 0, (size - h->size) * sizeof(int32_t));
+    h->size = size;
+  }
+  h->count[v] += d;
+}
+
+/**
+ * Get the highest value with a count in a histogram
+ *
+ * @param h Histogram
+ * @return Highest value, or 0 if empty
+ */
+static uintptr_t histogramMax(const struct Histogram *const h)
+{
+  uintptr_t v;
+  for(v=h->size;v>0;--v) {
+    if (h->count[v - 1] > 0)
+      return v - 1;
+  }
+  return 0;
+}
+
+/**
+ * Add or remove a cell's contribution to a worker's population totals
+ *
+ * @param s Totals
+ * @param c Cell
+ * @param sign 1 to add, -1 to remove
+ */
+static inline void populationUpdate(struct PopulationStats *const s, const uintptr_t c, const int32_t sign)
+{
+  const uintptr_t e = CELL_ENERGY(c);
+  const uintptr_t g = CELL_GENERATION(c);
+  if (e) {
+    s->activeCells += sign;
+    s->totalEnergy += sign * (int64_t)e;
+    histogramAdd(&s->energyHist, e, sign);
+    histogramAdd(&s->generationHist, g, sign);
+    if (g > 1) {
+      s->livingCells += sign;
+      s->livingEnergy += sign * (int64_t)e;
+      histogramAdd(&s->livingEnergyHist, e, sign);
+      if (g > 2) {
+        s->viableReplicators += sign;
+        s->viableEnergy += sign * (int64_t)e;
+      }
+    }
+  }
+}
+
+/**
+ * Merge all workers' changes into the population totals
+ *
+ * Only the main thread may call this, while no workers are running.
+ *
+ * @param histograms Nonzero to also merge the histograms (needed for
+ * the maxima); otherwise only the sums are merged
+ */
+static void mergePopulation(const int histograms)
+{
+  uintptr_t k, v;
+  for(k=0;k<NUM_WORKERS;++k) {
+    struct PopulationStats *const s = &workers[k].population;
+    population.activeCells += s->activeCells;
+    population.livingCells += s->livingCells;
+    population.viableReplicators += s->viableReplicators;
+    population.totalEnergy += s->totalEnergy;
+    population.livingEnergy += s->livingEnergy;
+    population.viableEnergy += s->viableEnergy;
+    s->activeCells = s->livingCells = s->viableReplicators = 0;
+    s->totalEnergy = s->livingEnergy = s->viableEnergy = 0;
+    if (histograms) {
+      for(v=0;v<s->energyHist.size;++v) {
+        if (s->energyHist.count[v]) {
+          histogramAdd(&population.energyHist, v, s->energyHist.count[v]);
+          s->energyHist.count[v] = 0;
+        }
+      }
+      for(v=0;v<s->livingEnergyHist.size;++v) {
+        if (s->livingEnergyHist.count[v]) {
+          histogramAdd(&population.livingEnergyHist, v, s->livingEnergyHist.count[v]);
+          s->livingEnergyHist.count[v] = 0;
+        }
+      }
+      for(v=0;v<s->generationHist.size;++v) {
+        if (s->generationHist.count[v]) {
+          histogramAdd(&population.generationHist, v, s->generationHist.count[v]);
+          s->generationHist.count[v] = 0;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Read the population totals (after a full mergePopulation())
+ *
+ * @param t Totals to fill in
+ */
+static void readPopulation(struct PopulationTotals *const t)
+{
+  memset(t, 0, sizeof(struct PopulationTotals));
+  t->activeCells = (uint64_t)population.activeCells;
+  t->livingCells = (uint64_t)population.livingCells;
+  t->viableReplicators = (uint64_t)population.viableReplicators;
+  t->totalEnergy = (uint64_t)population.totalEnergy;
+  t->livingEnergy = (uint64_t)population.livingEnergy;
+  t->viableEnergy = (uint64_t)population.viableEnergy;
+  t->maxCellEnergy = histogramMax(&population.energyHist);
+  t->maxLivingCellEnergy = histogramMax(&population.livingEnergyHist);
+  t->maxGeneration = histogramMax(&population.generationHist);
+}
+
+#endif /* INCREMENTAL_STATS */
+
+#if ACTIVE_SET_SCHEDULER
+
+#if (PARALLEL_THREADS > 0)
+#error "ACTIVE_SET_SCHEDULER needs PARALLEL_THREADS 0"
+#endif
+
+/* Position in activeCells of a cell that isn't in it */
+#define ACTIVE_NONE 0xffffffffU
+
+/* The cells with energy, in no particular order, their number, and the
+ * position of each cell in activeCells */
+static POND_STATE uint32_t *activeCells = (uint32_t *)0;
+static POND_STATE uintptr_t activeCount = 0;
+static POND_STATE uint32_t *activePosition = (uint32_t *)0;
+
+/* Ticks still to skip before the next pick (see skippedPicks()); kept
+ * here rather than in the main loop so that checkpoints include it */
+static POND_STATE uint64_t activeSkip = 0;
+
+/**
+ * Add a cell to or remove it from the active set as its energy says
+ *
+ * @param c Cell
+ */
+static inline void activeSetUpdate(const uintptr_t c)
+{
+  const uint32_t pos = activePosition[c];
+  uint32_t last;
+
+  if (CELL_ENERGY(c)) {
+    if (pos == ACTIVE_NONE) {
+      activePosition[c] = (uint32_t)activeCount;
+      activeCells[activeCount++] = (uint32_t)c;
+    }
+  } else if (pos != ACTIVE_NONE) {
+    last = activeCells[--activeCount];
+    activeCells[pos] = last;
+    activePosition[last] = pos;
+    activePosition[c] = ACTIVE_NONE;
+  }
+}
+
+/**
+ * Allocate an empty active set
+ *
+ * @return 0 on success, -1 on error
+ */
+static int allocActiveSet()
+{
+  uintptr_t c;
+
+  activeCells = (uint32_t *)malloc(POND_CELLS * sizeof(uint32_t));
+  activePosition = (uint32_t *)malloc(POND_CELLS * sizeof(uint32_t));
+  if ((!activeCells)||(!activePosition))
+    return -1;
+  activeCount = 0;
+  for(c=0;c<POND_CELLS;++c)
+    activePosition[c] = ACTIVE_NONE;
+  return 0;
+}
+
+/**
+ * Allocate the active set and fill it from the pond
+ *
+ * @return 0 on success, -1 on error
+ */
+static int initActiveSet()
+{
+  uintptr_t c;
+
+  if (allocActiveSet())
+    return -1;
+  for(c=0;c<POND_CELLS;++c)
+    activeSetUpdate(c);
+  return 0;
+}
+
+/**
+ * Draw how many picks of a random cell in a row would find one without
+ * energy, given how many have energy now
+ *
+ * The first pick is tried as the uniform engine would make it, so a
+ * pond where most cells have energy mostly gets by with one random
+ * number. Only when it misses is the rest of the run (which, the picks
+ * being independent, is geometric again) drawn with logarithms.
+ *
+ * @param r Random number generator
+ * @return Number of ticks to skip, or UINT64_MAX if no cell has energy
+ */
+static uint64_t skippedPicks(struct RandomState *const r)
+{
+  static POND_STATE uintptr_t lastCount = 0;
+  static POND_STATE double scale = 0.0;
+  double u, k;
+
+  if (!activeCount)
+    return UINT64_MAX;
+  if ((((uintptr_t)getRandom(r)) % POND_CELLS) < activeCount)
+    return 0;
+
+  /* 1 / log(chance of a miss), kept while the count stays the same */
+  if (activeCount != lastCount) {
+    lastCount = activeCount;
+    scale = 1.0 / log1p(-((double)activeCount / (double)POND_CELLS));
+  }
+
+  /* Uniform in (0,1] from the top 53 bits */
+  u = ((double)((((uint64_t)getRandom(r)) >> 11) + 1)) * (1.0 / 9007199254740992.0);
+  k = floor(log(u) * scale);
+  return (k < (double)(UINT64_MAX - 1)) ? ((uint64_t)k + 1) : UINT64_MAX;
+}
+
+/**
+ * Work out the first clock after this one at which the main loop has
+ * more to do than skip a pick: an inflow, or any of the housekeeping
+ *
+ * @param clock Current clock
+ * @return Next clock with work to do
+ */
+static uint64_t nextBusyClock(const uint64_t clock)
+{
+  uint64_t next = config.stopAt;
+
+#define NEXT_MULTIPLE(f) { const uint64_t m = clock - (clock % (f)) + (f); if (m < next) next = m; }
+  NEXT_MULTIPLE(INFLOW_FREQUENCY);
+  NEXT_MULTIPLE(REPORT_FREQUENCY);
+#ifdef USE_SDL
+  NEXT_MULTIPLE(REFRESH_FREQUENCY);
+#endif
+#ifdef DUMP_FREQUENCY
+  NEXT_MULTIPLE(DUMP_FREQUENCY);
+#endif
+#ifdef CHECKPOINT_FREQUENCY
+  NEXT_MULTIPLE(CHECKPOINT_FREQUENCY);
+#endif
+#undef NEXT_MULTIPLE
+
+  return (next > clock) ? next : (clock + 1);
+}
+
+#endif /* ACTIVE_SET_SCHEDULER */
+
+/**
+ * Remove a cell from the population totals before changing it
+ *
+ * @param w Worker making the change
+ * @param c Cell
+ */
+static inline void populationRemove(struct Worker *const w, const uintptr_t c)
+{
+#if INCREMENTAL_STATS
+  populationUpdate(&w->population, c, -1);
+#else
+  (void)w;
+  (void)c;
+#endif
+}
+
+/**
+ * Add a cell back to the population totals after changing it
+ *
+ * This also keeps the active set up to date (see ACTIVE_SET_SCHEDULER).
+ *
+ * @param w Worker making the change
+ * @param c Cell
+ */
+static inline void populationAdd(struct Worker *const w, const uintptr_t c)
+{
+#if ACTIVE_SET_SCHEDULER
+  activeSetUpdate(c);
+#endif
+#if INCREMENTAL_STATS
+  populationUpdate(&w->population, c, 1);
+#else
+  (void)w;
+  (void)c;
+#endif
+}
+
+/* Highest cell energy seen (updated during report) */
+POND_STATE uintptr_t totalEnergy;
+POND_STATE uintptr_t maxCellEnergy;
+POND_STATE uintptr_t maxLivingCellEnergy;
+
+/* Viable replicator count at the last report */
+static POND_STATE uint64_t lastTotalViableReplicators = 0;
+
+/**
+ * Get the total energy in the pond, for TOTAL_ENERGY_CAP
+ *
+ * @param w Worker asking
+ * @return Total energy as of the last report, or with INCREMENTAL_STATS
+ * as of now (as of the last merge plus this worker's own changes, when
+ * running in parallel)
+ */
+static inline uint64_t currentTotalEnergy(struct Worker *const w)
+{
+#if INCREMENTAL_STATS
+  return (uint64_t)(population.totalEnergy + w->population.totalEnergy);
+#else
+  (void)w;
+  return totalEnergy;
+#endif
+}
+
+/**
+ * Add cells to population totals, the scalar way
+ *
+ * @param energy Energy of each cell
+ * @param generation Generation of each cell
+ * @param n Number of cells
+ * @param t Totals to add to
+ */
+static void scanPlanesScalar(const uintptr_t *energy, const uintptr_t *generation, const uintptr_t n, struct PopulationTotals *t)
+{
+  uintptr_t c;
+  for(c=0;c<n;++c) {
+    if (energy[c]) {
+      ++t->activeCells;
+      t->totalEnergy += (uint64_t)energy[c];
+      if (energy[c] > t->maxCellEnergy)
+        t->maxCellEnergy = energy[c];
+      if (generation[c] > 1) {
+        ++t->livingCells;
+        t->livingEnergy += energy[c];
+        if (energy[c] > t->maxLivingCellEnergy)
+          t->maxLivingCellEnergy = energy[c];
+        if (generation[c] > 2) {
+          ++t->viableReplicators;
+          t->viableEnergy += energy[c];
+        }
+      }
+      if (generation[c] > t->maxGeneration)
+        t->maxGeneration = generation[c];
+    }
+  }
+}
+
+/* The vector versions work on 64-bit lanes */
+#if (UINTPTR_MAX == UINT64_MAX)
+
+#if SIMD_X86
+
+/* AVX2 only compares signed 64-bit integers, so both sides of an
+ * unsigned comparison get their top bits flipped first */
+__attribute__((target("avx2")))
+static inline __m256i maxEpu64Avx2(const __m256i a, const __m256i b, const __m256i sign)
+{
+  return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(_mm256_xor_si256(b, sign), _mm256_xor_si256(a, sign)));
+}
+
+__attribute__((target("avx2")))
+static inline uint64_t sumLanesAvx2(const __m256i v)
+{
+  uint64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, v);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+__attribute__((target("avx2")))
+static inline uint64_t maxLanesAvx2(const __m256i v, const uint64_t m)
+{
+  uint64_t lanes[4], r = m;
+  uintptr_t k;
+  _mm256_storeu_si256((__m256i *)lanes, v);
+  for(k=0;k<4;++k)
+    r = (lanes[k] > r) ? lanes[k] : r;
+  return r;
+}
+
+__attribute__((target("avx2")))
+static void scanPlanesAvx2(const uintptr_t *energy, const uintptr_t *generation, const uintptr_t n, struct PopulationTotals *t)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+  const __m256i one = _mm256_xor_si256(_mm256_set1_epi64x(1), sign);
+  const __m256i two = _mm256_xor_si256(_mm256_set1_epi64x(2), sign);
+  __m256i active = zero, living = zero, viable = zero;
+  __m256i total = zero, livingEnergy = zero, viableEnergy = zero;
+  __m256i maxEnergy = zero, maxLivingEnergy = zero, maxGeneration = zero;
+  __m256i e, g, isActive, isLiving, isViable;
+  uintptr_t c;
+
+  for(c=0;(c+4)<=n;c+=4) {
+    e = _mm256_loadu_si256((const __m256i *)(energy + c));
+    g = _mm256_loadu_si256((const __m256i *)(generation + c));
+    isActive = _mm256_xor_si256(_mm256_cmpeq_epi64(e, zero), _mm256_set1_epi64x(-1));
+    isLiving = _mm256_and_si256(isActive, _mm256_cmpgt_epi64(_mm256_xor_si256(g, sign), one));
+    isViable = _mm256_and_si256(isLiving, _mm256_cmpgt_epi64(_mm256_xor_si256(g, sign), two));
+    active = _mm256_sub_epi64(active, isActive);
+    living = _mm256_sub_epi64(living, isLiving);
+    viable = _mm256_sub_epi64(viable, isViable);
+    total = _mm256_add_epi64(total, e);
+    livingEnergy = _mm256_add_epi64(livingEnergy, _mm256_and_si256(e, isLiving));
+    viableEnergy = _mm256_add_epi64(viableEnergy, _mm256_and_si256(e, isViable));
+    maxEnergy = maxEpu64Avx2(maxEnergy, e, sign);
+    maxLivingEnergy = maxEpu64Avx2(maxLivingEnergy, _mm256_and_si256(e, isLiving), sign);
+    maxGeneration = maxEpu64Avx2(maxGeneration, _mm256_and_si256(g, isActive), sign);
+  }
+
+  t->activeCells += sumLanesAvx2(active);
+  t->livingCells += sumLanesAvx2(living);
+  t->viableReplicators += sumLanesAvx2(viable);
+  t->totalEnergy += sumLanesAvx2(total);
+  t->livingEnergy += sumLanesAvx2(livingEnergy);
+  t->viableEnergy += sumLanesAvx2(viableEnergy);
+  t->maxCellEnergy = maxLanesAvx2(maxEnergy, t->maxCellEnergy);
+  t->maxLivingCellEnergy = maxLanesAvx2(maxLivingEnergy, t->maxLivingCellEnergy);
+  t->maxGeneration = maxLanesAvx2(maxGeneration, t->maxGeneration);
+  scanPlanesScalar(energy + c, generation + c, n - c, t);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512dq")))
+static void scanPlanesAvx512(const uintptr_t *energy, const uintptr_t *generation, const uintptr_t n, struct PopulationTotals *t)
+{
+  const __m512i zero = _mm512_setzero_si512();
+  const __m512i one = _mm512_set1_epi64(1);
+  const __m512i two = _mm512_set1_epi64(2);
+  __m512i total = zero, livingEnergy = zero, viableEnergy = zero;
+  __m512i maxEnergy = zero, maxLivingEnergy = zero, maxGeneration = zero;
+  __m512i e, g;
+  __mmask8 isActive, isLiving, isViable;
+  uint64_t m;
+  uintptr_t c;
+
+  for(c=0;(c+8)<=n;c+=8) {
+    e = _mm512_loadu_si512((const void *)(energy + c));
+    g = _mm512_loadu_si512((const void *)(generation + c));
+    isActive = _mm512_test_epi64_mask(e, e);
+    isLiving = _mm512_mask_cmpgt_epu64_mask(isActive, g, one);
+    isViable = _mm512_mask_cmpgt_epu64_mask(isLiving, g, two);
+    t->activeCells += (uint64_t)__builtin_popcount((unsigned int)isActive);
+    t->livingCells += (uint64_t)__builtin_popcount((unsigned int)isLiving);
+    t->viableReplicators += (uint64_t)__builtin_popcount((unsigned int)isViable);
+    total = _mm512_add_epi64(total, e);
+    livingEnergy = _mm512_mask_add_epi64(livingEnergy, isLiving, livingEnergy, e);
+    viableEnergy = _mm512_mask_add_epi64(viableEnergy, isViable, viableEnergy, e);
+    maxEnergy = _mm512_max_epu64(maxEnergy, e);
+    maxLivingEnergy = _mm512_mask_max_epu64(maxLivingEnergy, isLiving, maxLivingEnergy, e);
+    maxGeneration = _mm512_mask_max_epu64(maxGeneration, isActive, maxGeneration, g);
+  }
+
+  t->totalEnergy += (uint64_t)_mm512_reduce_add_epi64(total);
+  t->livingEnergy += (uint64_t)_mm512_reduce_add_epi64(livingEnergy);
+  t->viableEnergy += (uint64_t)_mm512_reduce_add_epi64(viableEnergy);
+  m = (uint64_t)_mm512_reduce_max_epu64(maxEnergy);
+  if (m > t->maxCellEnergy)
+    t->maxCellEnergy = m;
+  m = (uint64_t)_mm512_reduce_max_epu64(maxLivingEnergy);
+  if (m > t->maxLivingCellEnergy)
+    t->maxLivingCellEnergy = m;
+  m = (uint64_t)_mm512_reduce_max_epu64(maxGeneration);
+  if (m > t->maxGeneration)
+    t->maxGeneration = m;
+  scanPlanesScalar(energy + c, generation + c, n - c, t);
+}
+
+#elif SIMD_NEON
+
+static inline uint64x2_t maxU64Neon(const uint64x2_t a, const uint64x2_t b)
+{
+  return vbslq_u64(vcgtq_u64(b, a), b, a);
+}
+
+static inline uint64_t maxLanesNeon(const uint64x2_t v, const uint64_t m)
+{
+  const uint64_t a = vgetq_lane_u64(v, 0), b = vgetq_lane_u64(v, 1);
+  const uint64_t r = (a > b) ? a : b;
+  return (r > m) ? r : m;
+}
+
+static void scanPlanesNeon(const uintptr_t *energy, const uintptr_t *generation, const uintptr_t n, struct PopulationTotals *t)
+{
+  const uint64x2_t zero = vdupq_n_u64(0);
+  const uint64x2_t one = vdupq_n_u64(1);
+  const uint64x2_t two = vdupq_n_u64(2);
+  uint64x2_t active = zero, living = zero, viable = zero;
+  uint64x2_t total = zero, livingEnergy = zero, viableEnergy = zero;
+  uint64x2_t maxEnergy = zero, maxLivingEnergy = zero, maxGeneration = zero;
+  uint64x2_t e, g, isActive, isLiving, isViable;
+  uintptr_t c;
+
+  for(c=0;(c+2)<=n;c+=2) {
+    e = vld1q_u64((const uint64_t *)(energy + c));
+    g = vld1q_u64((const uint64_t *)(generation + c));
+    isActive = vtstq_u64(e, e);
+    isLiving = vandq_u64(isActive, vcgtq_u64(g, one));
+    isViable = vandq_u64(isLiving, vcgtq_u64(g, two));
+    active = vsubq_u64(active, isActive);
+    living = vsubq_u64(living, isLiving);
+    viable = vsubq_u64(viable, isViable);
+    total = vaddq_u64(total, e);
+    livingEnergy = vaddq_u64(livingEnergy, vandq_u64(e, isLiving));
+    viableEnergy = vaddq_u64(viableEnergy, vandq_u64(e, isViable));
+    maxEnergy = maxU64Neon(maxEnergy, e);
+    maxLivingEnergy = maxU64Neon(maxLivingEnergy, vandq_u64(e, isLiving));
+    maxGeneration = maxU64Neon(maxGeneration, vandq_u64(g, isActive));
+  }
+
+  t->activeCells += vaddvq_u64(active);
+  t->livingCells += vaddvq_u64(living);
+  t->viableReplicators += vaddvq_u64(viable);
+  t->totalEnergy += vaddvq_u64(total);
+  t->livingEnergy += vaddvq_u64(livingEnergy);
+  t->viableEnergy += vaddvq_u64(viableEnergy);
+  t->maxCellEnergy = maxLanesNeon(maxEnergy, t->maxCellEnergy);
+  t->maxLivingCellEnergy = maxLanesNeon(maxLivingEnergy, t->maxLivingCellEnergy);
+  t->maxGeneration = maxLanesNeon(maxGeneration, t->maxGeneration);
+  scanPlanesScalar(energy + c, generation + c, n - c, t);
+}
+
+#endif /* SIMD_X86 / SIMD_NEON */
+
+#endif /* UINTPTR_MAX == UINT64_MAX */
+
+/* Most kernel sets there can be */
+#define MAX_KERNEL_SETS 4
+
+/**
+ * Get the kernel sets this processor can run, from slowest to fastest
+ *
+ * Each set starts out as the one before it, so a set only replaces the
+ * kernels it has its own versions of.
+ *
+ * @param sets MAX_KERNEL_SETS sets to fill in
+ * @return Number of sets, at least 1 (the scalar kernels)
+ */
+static uintptr_t getKernelSets(struct Kernels *const sets)
+{
+  uintptr_t n = 1;
+
+  sets[0].name = "scalar";
+  sets[0].genomeSum = genomeSumScalar;
+  sets[0].genomeHash = genomeHashScalar;
+  sets[0].scanPlanes = scanPlanesScalar;
+
+#if SIMD_X86
+#ifdef __SSE2__
+  sets[n] = sets[n - 1];
+  sets[n].name = "sse2";
+  sets[n].genomeSum = genomeSumSse2;
+  ++n;
+#endif
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    sets[n] = sets[n - 1];
+    sets[n].name = "avx2";
+    sets[n].genomeSum = genomeSumAvx2;
+    sets[n].genomeHash = genomeHashAvx2;
+#if (UINTPTR_MAX == UINT64_MAX)
+    sets[n].scanPlanes = scanPlanesAvx2;
+#endif
+    ++n;
+  }
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq")) {
+    sets[n] = sets[n - 1];
+    sets[n].name = "avx512";
+    sets[n].genomeSum = genomeSumAvx512;
+    sets[n].genomeHash = genomeHashAvx512;
+#if (UINTPTR_MAX == UINT64_MAX)
+    sets[n].scanPlanes = scanPlanesAvx512;
+#endif
+    ++n;
+  }
+#elif SIMD_NEON
+  sets[n] = sets[n - 1];
+  sets[n].name = "neon";
+  sets[n].genomeSum = genomeSumNeon;
+  sets[n].genomeHash = genomeHashNeon;
+#if (UINTPTR_MAX == UINT64_MAX)
+  sets[n].scanPlanes = scanPlanesNeon;
+#endif
+  ++n;
+#endif /* SIMD_X86 / SIMD_NEON */
+
+  return n;
+}
+
+/**
+ * Pick the fastest kernels this processor can run
+ */
+static void initKernels()
+{
+  struct Kernels sets[MAX_KERNEL_SETS];
+  kernels = sets[getKernelSets(sets) - 1];
+}
+
+#if ((!INCREMENTAL_STATS) || INCREMENTAL_STATS_CHECK)
+/**
+ * Scan the pond for population totals
+ *
+ * @param t Totals to fill in
+ */
+static void scanPopulation(struct PopulationTotals *const t)
+{
+  memset(t, 0, sizeof(struct PopulationTotals));
+
+#if (POND_LAYOUT_SOA && (DISTRIBUTED_NODES == 0))
+  kernels.scanPlanes(pondEnergy, pondGeneration, POND_CELLS, t);
+#else
+  uintptr_t c;
+
+  /* Walk the pond in storage order */
+  for(c=0;c<POND_CELLS;++c) {
+          if (CELL_ENERGY(c)&&CELL_OWNED(c)) {
+              ++t->activeCells;
+              t->totalEnergy += (uint64_t)CELL_ENERGY(c);
+              if (CELL_ENERGY(c) > t->maxCellEnergy) {
+                  t->maxCellEnergy = CELL_ENERGY(c);
+              }
+              if (CELL_GENERATION(c) > 1) {
+                  ++t->livingCells;
+                  t->livingEnergy += CELL_ENERGY(c);
+                  if (CELL_ENERGY(c) > t->maxLivingCellEnergy) {
+                      t->maxLivingCellEnergy = CELL_ENERGY(c);
+                  }
+                  if (CELL_GENERATION(c) > 2) {
+                      ++t->viableReplicators;
+                      t->viableEnergy += CELL_ENERGY(c);
+                  }
+              }
+              if (CELL_GENERATION(c) > t->maxGeneration) {
+                  t->maxGeneration = CELL_GENERATION(c);
+              }
+          }
+  }
+#endif /* POND_LAYOUT_SOA */
+}
+#endif
+
+#if (DISTRIBUTED_NODES > 0)
+
+/* ----------------------------------------------------------------------- */
+/* Distributed ponds                                                       */
+/* ----------------------------------------------------------------------- */
+
+/*
+ * With DISTRIBUTED_NODES, the pond is split into horizontal strips, one
+ * per process (node), and the nodes are connected in a ring by TCP: each
+ * has a connection down to the node whose strip is below its own and
+ * one up to the node above (the pond wraps, so the last node's strip is
+ * above the first's). Each node runs the cells of its strip on its own
+ * and swaps border rows with its neighbors between phases, see
+ * runDistributed(). Reports add up all nodes' counters around the ring,
+ * and each node dumps its own strip.
+ */
+
+/* This node's number (0 at the top), and its connections to the nodes
+ * above and below it */
+static int nodeRank = -1;
+static int nodeUp = -1;
+static int nodeDown = -1;
+
+/**
+ * Send to one connection while receiving from another
+ *
+ * Both go on at the same time, so that the nodes of a ring can all send
+ * to their neighbors at once without waiting on each other.
+ *
+ * @param sendFd Connection to send to
+ * @param out Data to send
+ * @param outBytes Number of bytes to send (can be 0)
+ * @param recvFd Connection to receive from
+ * @param in Buffer to receive into
+ * @param inBytes Number of bytes to receive (can be 0)
+ */
+static void nodeTransfer(const int sendFd, const void *out, size_t outBytes, const int recvFd, void *in, size_t inBytes)
+{
+  const uint8_t *o = (const uint8_t *)out;
+  uint8_t *i = (uint8_t *)in;
+  struct pollfd p[2];
+  ssize_t k;
+
+  while (outBytes || inBytes) {
+    p[0].fd = outBytes ? sendFd : -1;
+    p[0].events = POLLOUT;
+    p[0].revents = 0;
+    p[1].fd = inBytes ? recvFd : -1;
+    p[1].events = POLLIN;
+    p[1].revents = 0;
+    if (poll(p, 2, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    if (p[0].revents & (POLLERR|POLLHUP|POLLNVAL))
+      break;
+    if (p[0].revents & POLLOUT) {
+      k = send(sendFd, o, outBytes, MSG_DONTWAIT|MSG_NOSIGNAL);
+      if (k > 0) {
+        o += k;
+        outBytes -= (size_t)k;
+      } else if ((errno != EAGAIN)&&(errno != EWOULDBLOCK)&&(errno != EINTR)) {
+        break;
+      }
+    }
+    if (p[1].revents & (POLLIN|POLLERR|POLLHUP|POLLNVAL)) {
+      k = recv(recvFd, i, inBytes, MSG_DONTWAIT);
+      if (k > 0) {
+        i += k;
+        inBytes -= (size_t)k;
+      } else if ((k == 0)||((errno != EAGAIN)&&(errno != EWOULDBLOCK)&&(errno != EINTR))) {
+        break;
+      }
+    }
+  }
+  if (outBytes || inBytes) {
+    fprintf(stderr,"*** Node %d lost its connection to a neighbor ***\n", nodeRank);
+    exit(1);
+  }
+}
+
+/**
+ * What each node adds to a report
+ */
+struct NodeReport
+{
+  struct PopulationTotals t;
+  struct PerReportStatCounters stats;
+};
+
+/**
+ * Add up all nodes' population totals and statCounters for a report
+ *
+ * The sums go down the ring from node 0 and back to it, and then round
+ * once more so that every node ends up with them. Every node has to
+ * call this at the same clock.
+ *
+ * @param t This node's totals, replaced with the totals of the pond
+ */
+static void nodeReduceReport(struct PopulationTotals *const t)
+{
+  struct NodeReport mine, sum;
+
+  memset(&mine, 0, sizeof(mine));
+  memset(&sum, 0, sizeof(sum));
+  mine.t = *t;
+  mine.stats = statCounters;
+  if (nodeRank == 0) {
+    nodeTransfer(nodeDown, &mine, sizeof(mine), nodeUp, &sum, 0);
+    nodeTransfer(nodeDown, &sum, 0, nodeUp, &sum, sizeof(sum));
+  } else {
+    nodeTransfer(nodeDown, &sum, 0, nodeUp, &sum, sizeof(sum));
+    sum.t.activeCells += mine.t.activeCells;
+    sum.t.livingCells += mine.t.livingCells;
+    sum.t.viableReplicators += mine.t.viableReplicators;
+    sum.t.totalEnergy += mine.t.totalEnergy;
+    sum.t.livingEnergy += mine.t.livingEnergy;
+    sum.t.viableEnergy += mine.t.viableEnergy;
+    if (mine.t.maxCellEnergy > sum.t.maxCellEnergy)
+      sum.t.maxCellEnergy = mine.t.maxCellEnergy;
+    if (mine.t.maxLivingCellEnergy > sum.t.maxLivingCellEnergy)
+      sum.t.maxLivingCellEnergy = mine.t.maxLivingCellEnergy;
+    if (mine.t.maxGeneration > sum.t.maxGeneration)
+      sum.t.maxGeneration = mine.t.maxGeneration;
+    addStatCounters(&sum.stats, &mine.stats);
+    nodeTransfer(nodeDown, &sum, sizeof(sum), nodeUp, &sum, 0);
+  }
+
+  /* Send the sums round again, except from the last node back to 0 */
+  if (nodeRank == 0) {
+    nodeTransfer(nodeDown, &sum, sizeof(sum), nodeUp, &sum, 0);
+  } else {
+    nodeTransfer(nodeDown, &sum, 0, nodeUp, &sum, sizeof(sum));
+    if (nodeRank != (DISTRIBUTED_NODES - 1))
+      nodeTransfer(nodeDown, &sum, sizeof(sum), nodeUp, &sum, 0);
+  }
+
+  *t = sum.t;
+  statCounters = sum.stats;
+}
+
+#endif /* DISTRIBUTED_NODES */
+
+#if TELEMETRY
+
+/* ----------------------------------------------------------------------- */
+/* Telemetry                                                               */
+/* ----------------------------------------------------------------------- */
+
+/*
+ * With TELEMETRY, doReport() only copies the totals and counters of a
+ * report (and the events it sees) into a record in a ring that an
+ * exporter thread drains, see telemetryMain(). There is one producer
+ * and one consumer, so the ring needs nothing more than a head the
+ * producer advances and a tail the consumer does. If the exporter falls
+ * TELEMETRY_RING records behind, the simulation waits for it rather than
+ * lose a report.
+ */
+
+#if (TELEMETRY_RING & (TELEMETRY_RING - 1))
+#error "TELEMETRY_RING must be a power of two"
+#endif
+
+/* Kinds of telemetry records */
+#define TELEMETRY_REPORT   0
+#define TELEMETRY_APPEARED 1
+#define TELEMETRY_EXTINCT  2
+
+/* How long the exporter sleeps when the ring is empty, and the
+ * simulation when it is full (microseconds) */
+#define TELEMETRY_POLL_US 1000
+
+/**
+ * A report or event as handed to the exporter
+ */
+struct TelemetryRecord
+{
+  uint64_t kind;
+  uint64_t clock;
+  struct PopulationTotals t;
+  struct PerReportStatCounters stats;
+};
+
+/**
+ * The ring and the exporter's state
+ */
+struct Telemetry
+{
+  struct TelemetryRecord ring[TELEMETRY_RING];
+  /* Records pushed and records exported, each only written by one side */
+  _Alignas(CACHE_LINE_BYTES) atomic_uint_fast64_t head;
+  _Alignas(CACHE_LINE_BYTES) atomic_uint_fast64_t tail;
+  /* Set when the simulation is done and the exporter should finish */
+  atomic_int quit;
+  /* Times the simulation found the ring full */
+  uint64_t stalls;
+  pthread_t thread;
+  FILE *report;
+  FILE *log;
+  int udp;
+};
+
+/* Exporter of the current pond, see startTelemetry() */
+static POND_STATE struct Telemetry *telemetry = (struct Telemetry *)0;
+
+/**
+ * Hand a record over to the exporter
+ *
+ * @param kind TELEMETRY_REPORT or an event
+ * @param clock Current clock
+ * @param t Population totals
+ */
+static void telemetryPush(const uint64_t kind, const uint64_t clock, const struct PopulationTotals *const t)
+{
+  const uint_fast64_t head = atomic_load_explicit(&telemetry->head, memory_order_relaxed);
+  struct TelemetryRecord *r;
+
+  while ((head - atomic_load_explicit(&telemetry->tail, memory_order_acquire)) >= TELEMETRY_RING) {
+    ++telemetry->stalls;
+    usleep(TELEMETRY_POLL_US);
+  }
+  r = &telemetry->ring[head & (TELEMETRY_RING - 1)];
+  r->kind = kind;
+  r->clock = clock;
+  r->t = *t;
+  r->stats = statCounters;
+  atomic_store_explicit(&telemetry->head, head + 1, memory_order_release);
+}
+
+#endif /* TELEMETRY */
+
+/**
+ * Write a report as a line of comma-seperated statistics data
+ *
+ * @param f File to write to
+ * @param clock Clock of the report
+ * @param t Population totals
+ * @param s Counters since the report before
+ */
+static void writeReportCsv(FILE *const f, const uint64_t clock, const struct PopulationTotals *const t, const struct PerReportStatCounters *const s)
+{
+  uintptr_t x;
+  uint64_t totalMetabolism = 0;
+
+  /* Look here to get the columns in the CSV output */
+  
+  fprintf(f, "%ju,%ju,%ju,%ju,%.2f,%.2f,|,%ju,%ju,%ju,%ju,|,%ju,%ju,%ju,%ju,%ju,%ju,%ju,%ju,|,%ju,%ju,%ju,|",
+    (uintmax_t)clock,
+    (uintmax_t)t->totalEnergy,
+    (uintmax_t)t->maxCellEnergy,
+    (uintmax_t)t->maxLivingCellEnergy,
+    (double)t->livingEnergy / (double)t->livingCells,
+    (double)t->viableEnergy / (double)t->viableReplicators,
+
+    (uintmax_t)t->activeCells,
+    (uintmax_t)t->livingCells,
+    (uintmax_t)t->viableReplicators,
+    (uintmax_t)t->maxGeneration,
+
+    (uintmax_t)s->memSpecialReads,
+    (uintmax_t)s->memPrivateReads,
+    (uintmax_t)s->memOutputReads,
+    (uintmax_t)s->memInputReads,
+    (uintmax_t)s->memSpecialWrites,
+    (uintmax_t)s->memPrivateWrites,
+    (uintmax_t)s->memOutputWrites,
+    (uintmax_t)s->memInputWrites,
+
+    (uintmax_t)s->viableCellsReplaced,
+    (uintmax_t)s->viableCellsKilled,
+    (uintmax_t)s->viableCellShares
+    );
+  
+  /* The next NUM_INST are the average frequencies of execution for each
+   * instruction per cell execution. */
+  for(x=0;x<NUM_INST;++x) {
+    totalMetabolism += s->instructionExecutions[x];
+    fprintf(f, ",%.4f",s->cellExecutions ? ((double)s->instructionExecutions[x] / (double)s->cellExecutions) : 0.0);
+  }
+
+  /* The last column is the average metabolism per cell execution */
+  fprintf(f, ",%.4f\n",s->cellExecutions ? ((double)totalMetabolism / (double)s->cellExecutions) : 0.0);
+  fflush(f);
+}
+
+/**
+ * Output a line of comma-seperated statistics data
+ *
+ * @param clock Current clock
+ */
+static void doReport(const uint64_t clock)
+{
+  uintptr_t x;
+  struct PopulationTotals t;
+
+  mergeStatCounters();
+#if PROFILE_CYCLES
+  writeProfile(clock);
+#endif
+
+#if INCREMENTAL_STATS
+  mergePopulation(1);
+  readPopulation(&t);
+#if INCREMENTAL_STATS_CHECK
+  {
+    struct PopulationTotals scanned;
+    scanPopulation(&scanned);
+    if (memcmp(&t, &scanned, sizeof(struct PopulationTotals))) {
+      fprintf(stderr,"[ERROR] Incremental population stats differ from a scan of the pond at clock %ju\n", (uintmax_t)clock);
+      abort();
+    }
+  }
+#endif /* INCREMENTAL_STATS_CHECK */
+#else
+  scanPopulation(&t);
+#endif /* INCREMENTAL_STATS */
+#if (DISTRIBUTED_NODES > 0)
+  nodeReduceReport(&t);
+#endif
+
+  totalEnergy = t.totalEnergy;
+  maxCellEnergy = t.maxCellEnergy;
+  maxLivingCellEnergy = t.maxLivingCellEnergy;
+  
+#if TELEMETRY
+  telemetryPush(TELEMETRY_REPORT, clock, &t);
+#else
+  writeReportCsv(config.report, clock, &t, &statCounters);
+#endif
+
+  for(x=0;x<NUM_INST;++x)
+    instructionsExecuted += statCounters.instructionExecutions[x];
+
+#if TELEMETRY
+  if ((lastTotalViableReplicators > 0)&&(t.viableReplicators == 0))
+    telemetryPush(TELEMETRY_EXTINCT, clock, &t);
+  else if ((lastTotalViableReplicators == 0)&&(t.viableReplicators > 0))
+    telemetryPush(TELEMETRY_APPEARED, clock, &t);
+#else
+  if ((lastTotalViableReplicators > 0)&&(t.viableReplicators == 0))
+    fprintf(stderr,"[EVENT] Viable replicators have gone extinct. Please reserve a moment of silence.\n");
+  else if ((lastTotalViableReplicators == 0)&&(t.viableReplicators > 0))
+    fprintf(stderr,"[EVENT] Viable replicators have appeared!\n");
+#endif
+  
+  lastTotalViableReplicators = t.viableReplicators;
+  
+  /* Reset per-report stat counters */
+  clearStatCounters(&statCounters);
+}
+
+/* ----------------------------------------------------------------------- */
+/* Genome dumps                                                            */
+/* ----------------------------------------------------------------------- */
+
+/*
+ * A dump is taken by packing every viable cell into a fixed-width record
+ * in a snapshot buffer, which is then written out (as CSV, or as is for
+ * DUMP_BINARY) by a writer thread while the simulation carries on.
+ *
+ * A record is the cell's index in the pond as a little-endian 32-bit
+ * integer, its ID, parent ID, lineage and generation as little-endian
+ * 64-bit integers, then its logo and facing bytes, then its genome
+ * packed INST_BITS bits per instruction, least significant bit first.
+ *
+ * A binary dump is a DUMP_HEADER_BYTES header, the records, and then
+ * (in delta dumps) the 32-bit indices of cells that were in the
+ * previous dump but are no longer viable. The header's base clock is
+ * the clock of the dump a delta applies to, or the dump's own clock for
+ * a full dump. With USE_ZSTD the whole file is one zstd frame.
+ */
+
+#define DUMP_MAGIC "NPONDDMP"
+#define DUMP_VERSION 2
+#define DUMP_GENOME_BYTES (((POND_DEPTH * INST_BITS) + 7) / 8)
+#define DUMP_RECORD_BYTES (38 + DUMP_GENOME_BYTES)
+
+/* Magic, version, pond depth, instruction bits, record bytes (uint32),
+ * clock, record count, tombstone count, base clock (uint64) */
+#define DUMP_HEADER_BYTES 56
+
+#if (!DUMP_BINARY)
+#define DUMP_EXTENSION "dump.csv"
+#elif defined(USE_ZSTD)
+#define DUMP_EXTENSION "dump.bin.zst"
+#define DUMP_DELTA_EXTENSION "delta.bin.zst"
+#else
+#define DUMP_EXTENSION "dump.bin"
+#define DUMP_DELTA_EXTENSION "delta.bin"
+#endif
+
+/**
+ * Store a little-endian integer
+ *
+ * @param p Destination
+ * @param v Value
+ * @param n Number of bytes
+ */
+static void putLe(uint8_t *p, uint64_t v, uintptr_t n)
+{
+  while (n--) {
+    *(p++) = (uint8_t)v;
+    v >>= 8;
+  }
+}
+
+/**
+ * Load a little-endian integer
+ *
+ * @param p Source
+ * @param n Number of bytes
+ * @return Value
+ */
+static uint64_t getLe(const uint8_t *p, uintptr_t n)
+{
+  uint64_t v = 0;
+  while (n--)
+    v = (v << 8) | p[n];
+  return v;
+}
+
+/**
+ * Pack a cell into a dump record
+ *
+ * @param rec Destination, DUMP_RECORD_BYTES long
+ * @param cell Source
+ */
+static void packDumpRecord(uint8_t *rec, const uintptr_t cell)
+{
+  uintptr_t i, bits = 0, nbits = 0;
+
+  putLe(rec, (uint64_t)cell, 4);
+  putLe(rec + 4, (uint64_t)CELL_ID(cell), 8);
+  putLe(rec + 12, (uint64_t)CELL_PARENT_ID(cell), 8);
+  putLe(rec + 20, (uint64_t)CELL_LINEAGE(cell), 8);
+  putLe(rec + 28, (uint64_t)CELL_GENERATION(cell), 8);
+  rec[36] = (uint8_t)CELL_LOGO(cell);
+  rec[37] = (uint8_t)CELL_FACING(cell);
+  rec += 38;
+  for(i = 0; i < POND_DEPTH; ++i) {
+    bits |= (uintptr_t)(GENOME_AT(cell, i) & (NUM_INST - 1)) << nbits;
+    nbits += INST_BITS;
+    while (nbits >= 8) {
+      *(rec++) = (uint8_t)bits;
+      bits >>= 8;
+      nbits -= 8;
+    }
+  }
+  if (nbits)
+    *rec = (uint8_t)bits;
+}
+
+/**
+ * Write the genome of a dump record as in the CSV dump format: one
+ * character per instruction, with runs of STOP shortened
+ *
+ * @param line Destination, at least POND_DEPTH long
+ * @param genome Genome, packed as in a dump record
+ * @return Number of characters written
+ */
+static uintptr_t formatDumpGenome(char *line, const uint8_t *genome)
+{
+    uintptr_t inst, stopCount, i, bits = 0, nbits = 0, len = 0;
+
+    stopCount = 0;
+    for(i = 0; i < POND_DEPTH; ++i) {
+        if (nbits < INST_BITS) {
+            bits |= (uintptr_t)*(genome++) << nbits;
+            nbits += 8;
+        }
+        inst = bits & (NUM_INST - 1);
+        bits >>= INST_BITS;
+        nbits -= INST_BITS;
+        if (inst == OP_STOP) { /* STOP */
+            ++stopCount;
+        }
+        else {
+            stopCount = 0;
+        }
+        if (stopCount < 5) {
+            line[len++] = (stopCount > 1) ? '.' : inst_chars[inst];
+        }
+    }
+    return len;
+}
+
+/**
+ * Write a dump record as a line of the CSV dump format
+ *
+ * @param file Destination
+ * @param rec Record
+ */
+static void writeDumpRecordCsv(FILE *file, const uint8_t *rec)
+{
+    char line[POND_DEPTH + 2];
+    uintptr_t len;
+
+    fprintf(file, "%ju,%ju,%ju,%ju,%c,%c,",
+            (uintmax_t)getLe(rec + 4, 8),
+            (uintmax_t)getLe(rec + 12, 8),
+            (uintmax_t)getLe(rec + 20, 8),
+            (uintmax_t)getLe(rec + 28, 8),
+            inst_chars[rec[36] & (NUM_INST - 1)],
+            inst_chars[rec[37] & (NUM_INST - 1)]);
+    len = formatDumpGenome(line, rec + 38);
+    line[len++] = '\n';
+    fwrite(line, 1, len, file);
+}
+
+#ifdef USE_SDL
+/**
+ * Dumps the genome of a cell to a file.
+ *
+ * @param file Destination
+ * @param cell Source
+ */
+static void dumpCell(FILE *file, const uintptr_t cell)
+{
+    uint8_t rec[DUMP_RECORD_BYTES];
+
+    packDumpRecord(rec, cell);
+    writeDumpRecordCsv(file, rec);
+}
+#endif /* USE_SDL */
+
+/**
+ * A dump waiting to be written
+ */
+struct DumpSnapshot
+{
+  FILE *file;
+  uint64_t clock;
+  uint64_t baseClock;
+  uintptr_t count;
+  uintptr_t tombstones;
+  /* DUMP_HEADER_BYTES of header, count records, tombstones indices */
+  uint8_t *buf;
+  size_t capacity;
+  /* Totals for all dumps written so far, for the benchmark mode */
+  uint64_t bytesWritten;
+  double secondsWriting;
+};
+
+static POND_STATE struct DumpSnapshot dumpSnapshot = { (FILE *)0, 0, 0, 0, 0, (uint8_t *)0, 0, 0, 0.0 };
+
+#if DUMP_THREAD
+static POND_STATE pthread_t dumpThread;
+static POND_STATE int dumpThreadRunning = 0;
+#endif
+
+/**
+ * Write a snapshot to its file and close it
+ *
+ * @param s Snapshot
+ */
+static void writeDump(struct DumpSnapshot *const s)
+{
+  struct timespec t0, t1;
+  long bytes;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+#if DUMP_BINARY
+  size_t n = DUMP_HEADER_BYTES + ((size_t)s->count * DUMP_RECORD_BYTES) + ((size_t)s->tombstones * 4);
+  const void *out = s->buf;
+
+  memcpy(s->buf, DUMP_MAGIC, 8);
+  putLe(s->buf + 8, DUMP_VERSION, 4);
+  putLe(s->buf + 12, POND_DEPTH, 4);
+  putLe(s->buf + 16, INST_BITS, 4);
+  putLe(s->buf + 20, DUMP_RECORD_BYTES, 4);
+  putLe(s->buf + 24, s->clock, 8);
+  putLe(s->buf + 32, (uint64_t)s->count, 8);
+  putLe(s->buf + 40, (uint64_t)s->tombstones, 8);
+  putLe(s->buf + 48, s->baseClock, 8);
+#ifdef USE_ZSTD
+  const size_t bound = ZSTD_compressBound(n);
+  void *const z = malloc(bound);
+  if (z) {
+    const size_t zn = ZSTD_compress(z, bound, s->buf, n, DUMP_ZSTD_LEVEL);
+    if (!ZSTD_isError(zn)) {
+      out = z;
+      n = zn;
+    }
+  }
+#endif /* USE_ZSTD */
+  if (fwrite(out, 1, n, s->file) != n)
+    fprintf(stderr,"[WARNING] Could not write dump at %ju.\n", (uintmax_t)s->clock);
+#ifdef USE_ZSTD
+  free(z);
+#endif
+#else
+  uintptr_t i;
+  for(i=0;i<s->count;++i)
+    writeDumpRecordCsv(s->file, s->buf + DUMP_HEADER_BYTES + (i * DUMP_RECORD_BYTES));
+#endif /* DUMP_BINARY */
+  bytes = ftell(s->file);
+  fclose(s->file);
+  s->file = (FILE *)0;
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  if (bytes > 0)
+    s->bytesWritten += (uint64_t)bytes;
+  s->secondsWriting += (double)(t1.tv_sec - t0.tv_sec) + ((double)(t1.tv_nsec - t0.tv_nsec) / 1.0e9);
+}
+
+#if DUMP_THREAD
+/**
+ * Dump writer thread
+ *
+ * @param arg Snapshot to write
+ * @return Nothing
+ */
+static void *dumpWriterMain(void *arg)
+{
+  writeDump((struct DumpSnapshot *)arg);
+  return (void *)0;
+}
+#endif
+
+/**
+ * Wait for the last dump to be written
+ */
+static void finishDump()
+{
+#if DUMP_THREAD
+  if (dumpThreadRunning) {
+    pthread_join(dumpThread, (void **)0);
+    dumpThreadRunning = 0;
+  }
+#endif
+}
+
+/**
+ * Dumps all viable (generation > 2) cells to a file called <clock>.dump
+ *
+ * Only the snapshot is taken here; with DUMP_THREAD the file is written
+ * in the background. The previous dump is waited for first, since its
+ * snapshot buffer is reused.
+ *
+ * With DUMP_DELTA only every DUMP_KEYFRAME_INTERVAL'th dump holds all
+ * viable cells. The others, called <clock>.delta, hold the viable cells
+ * whose records changed or that were not in the previous dump, and
+ * tombstones for the cells of the previous dump that are gone.
+ *
+ * @param clock Clock value
+ */
+static void doDump(const uint64_t clock)
+{
+    char buf[320];
+    struct DumpSnapshot *const s = &dumpSnapshot;
+    uintptr_t pcell, count, tombstones;
+    size_t bytes;
+    uint8_t *rec, *tomb;
+#if DUMP_DELTA
+    const int full = (dumpsToKeyframe == 0);
+#define DUMP_WANTED(c) (CELL_ENERGY(c)&&(CELL_GENERATION(c) > 2)&&CELL_OWNED(c)&&(full||dumpDirty[c]||(!dumpPresent[c])))
+#define DUMP_GONE(c) ((!full)&&dumpPresent[c]&&(!(CELL_ENERGY(c)&&(CELL_GENERATION(c) > 2))))
+#else
+#define DUMP_WANTED(c) (CELL_ENERGY(c)&&(CELL_GENERATION(c) > 2)&&CELL_OWNED(c))
+#define DUMP_GONE(c) 0
+#endif
+
+    finishDump();
+
+#if DUMP_DELTA
+    sprintf(buf,"%s%ju.%s", config.outputPrefix, (uintmax_t)clock, full ? DUMP_EXTENSION : DUMP_DELTA_EXTENSION);
+#else
+    sprintf(buf,"%s%ju.%s", config.outputPrefix, (uintmax_t)clock, DUMP_EXTENSION);
+#endif
+    s->file = fopen(buf,DUMP_BINARY ? "wb" : "w");
+    if (!s->file) {
+        fprintf(stderr,"[WARNING] Could not open %s for writing.\n",buf);
+        return;
+    }
+
+    fprintf(stderr,"[INFO] Dumping viable cells to %s\n",buf);
+
+    count = 0;
+    tombstones = 0;
+    for(pcell=0;pcell<POND_CELLS;++pcell) {
+        if (DUMP_WANTED(pcell))
+            ++count;
+        else if (DUMP_GONE(pcell))
+            ++tombstones;
+    }
+    bytes = DUMP_HEADER_BYTES + ((size_t)count * DUMP_RECORD_BYTES) + ((size_t)tombstones * 4);
+    if (bytes > s->capacity) {
+        rec = (uint8_t *)realloc(s->buf, bytes);
+        if (!rec) {
+            fprintf(stderr,"[WARNING] Could not allocate dump of %ju cells.\n",(uintmax_t)count);
+            fclose(s->file);
+            s->file = (FILE *)0;
+            return;
+        }
+        s->buf = rec;
+        s->capacity = bytes;
+    }
+    s->clock = clock;
+    s->baseClock = clock;
+    s->count = count;
+    s->tombstones = tombstones;
+
+    /* Cells are written in storage order, see POND_ORDER */
+    rec = s->buf + DUMP_HEADER_BYTES;
+    tomb = rec + ((size_t)count * DUMP_RECORD_BYTES);
+    for(pcell=0;pcell<POND_CELLS;++pcell) {
+        if (DUMP_WANTED(pcell)) {
+            packDumpRecord(rec, pcell);
+            rec += DUMP_RECORD_BYTES;
+        } else if (DUMP_GONE(pcell)) {
+            putLe(tomb, (uint64_t)pcell, 4);
+            tomb += 4;
+        }
+    }
+#undef DUMP_WANTED
+#undef DUMP_GONE
+
+#if DUMP_DELTA
+    /* What the reader has after applying this dump */
+    for(pcell=0;pcell<POND_CELLS;++pcell) {
+        dumpPresent[pcell] = CELL_ENERGY(pcell)&&(CELL_GENERATION(pcell) > 2)&&CELL_OWNED(pcell);
+        dumpDirty[pcell] = 0;
+    }
+    if (!full)
+        s->baseClock = lastDumpClock;
+    lastDumpClock = clock;
+    dumpsToKeyframe = (full ? DUMP_KEYFRAME_INTERVAL : dumpsToKeyframe) - 1;
+#endif /* DUMP_DELTA */
+
+#if DUMP_THREAD
+    if (!pthread_create(&dumpThread, (const pthread_attr_t *)0, dumpWriterMain, s)) {
+        dumpThreadRunning = 1;
+        return;
+    }
+#endif
+    writeDump(s);
+}
+
+/**
+ * Check that a binary dump in memory is complete and from this build
+ *
+ * @param path Where it came from, for messages
+ * @param data Its contents, decompressed
+ * @param n Its size
+ * @return 0 if it is, 1 if not (with a message printed)
+ */
+static int checkDump(const char *path, const uint8_t *data, const size_t n)
+{
+  size_t k;
+
+  if ((n < DUMP_HEADER_BYTES)||(memcmp(data, DUMP_MAGIC, 8))||(getLe(data + 8, 4) != DUMP_VERSION)) {
+    fprintf(stderr,"*** %s is not a binary dump ***\n", path);
+    return 1;
+  }
+  if ((getLe(data + 12, 4) != POND_DEPTH)||(getLe(data + 16, 4) != INST_BITS)||(getLe(data + 20, 4) != DUMP_RECORD_BYTES)) {
+    fprintf(stderr,"*** %s is from a build with a different POND_DEPTH ***\n", path);
+    return 1;
+  }
+  k = (size_t)getLe(data + 32, 8);
+  if ((k > ((n - DUMP_HEADER_BYTES) / DUMP_RECORD_BYTES))||(getLe(data + 40, 8) > ((n - DUMP_HEADER_BYTES - (k * DUMP_RECORD_BYTES)) / 4))) {
+    fprintf(stderr,"*** %s is truncated ***\n", path);
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * Read a binary dump into memory, decompressing it if need be
+ *
+ * @param path Binary dump
+ * @param n Set to its size
+ * @return Its contents (free with free()), or NULL on error (with a message printed)
+ */
+static uint8_t *readDump(const char *path, size_t *const n)
+{
+  FILE *f;
+  uint8_t *data, *p;
+  size_t capacity = 1 << 20, k;
+
+  *n = 0;
+  f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr,"*** Unable to open dump %s ***\n", path);
+    return (uint8_t *)0;
+  }
+  data = (uint8_t *)malloc(capacity);
+  while (data) {
+    k = fread(data + *n, 1, capacity - *n, f);
+    *n += k;
+    if (*n < capacity)
+      break;
+    capacity <<= 1;
+    p = (uint8_t *)realloc(data, capacity);
+    if (!p)
+      free(data);
+    data = p;
+  }
+  fclose(f);
+  if (!data) {
+    fprintf(stderr,"*** Unable to read dump %s ***\n", path);
+    return (uint8_t *)0;
+  }
+
+#ifdef USE_ZSTD
+  if ((*n >= 4)&&(getLe(data, 4) == ZSTD_MAGICNUMBER)) {
+    const unsigned long long zn = ZSTD_getFrameContentSize(data, *n);
+    p = ((zn == ZSTD_CONTENTSIZE_ERROR)||(zn == ZSTD_CONTENTSIZE_UNKNOWN)) ? (uint8_t *)0 : (uint8_t *)malloc((size_t)zn);
+    if ((!p)||(ZSTD_isError(ZSTD_decompress(p, (size_t)zn, data, *n)))) {
+      fprintf(stderr,"*** Unable to decompress dump %s ***\n", path);
+      free(p);
+      free(data);
+      return (uint8_t *)0;
+    }
+    free(data);
+    data = p;
+    *n = (size_t)zn;
+  }
+#endif /* USE_ZSTD */
+
+  if (checkDump(path, data, *n)) {
+    free(data);
+    return (uint8_t *)0;
+  }
+  return data;
+}
+
+/**
+ * Convert binary dumps to the CSV dump format on standard output
+ *
+ * The first dump must be a full one; each of the others must be a full
+ * dump or a delta against the one before it. The CSV is of the pond as
+ * of the last one, as a full dump at that time would have written it.
+ *
+ * @param paths Binary dumps (compressed or not), in order
+ * @param count Number of dumps
+ * @return 0 on success, nonzero on error (with a message printed)
+ */
+static int convertDumps(char **paths, const uintptr_t count)
+{
+  uint8_t *state, *present, *data, *p;
+  uint64_t clock = 0, records, tombstones, k, cell;
+  uintptr_t i;
+  size_t n;
+
+  state = (uint8_t *)malloc((size_t)POND_CELLS * DUMP_RECORD_BYTES);
+  present = (uint8_t *)calloc(1, POND_CELLS);
+  if ((!state)||(!present)) {
+    fprintf(stderr,"*** Unable to allocate memory ***\n");
+    return 1;
+  }
+
+  for(i=0;i<count;++i) {
+    data = readDump(paths[i], &n);
+    if (!data)
+      return 1;
+    if (getLe(data + 48, 8) == getLe(data + 24, 8)) {
+      memset(present, 0, POND_CELLS);
+    } else if ((!i)||(getLe(data + 48, 8) != clock)) {
+      fprintf(stderr,"*** %s is a delta against %ju, which is not the dump before it ***\n", paths[i], (uintmax_t)getLe(data + 48, 8));
+      return 1;
+    }
+    clock = getLe(data + 24, 8);
+    records = getLe(data + 32, 8);
+    tombstones = getLe(data + 40, 8);
+
+    p = data + DUMP_HEADER_BYTES;
+    for(k=0;k<records;++k,p+=DUMP_RECORD_BYTES) {
+      cell = getLe(p, 4);
+      if (cell >= POND_CELLS) {
+        fprintf(stderr,"*** %s has a bad cell index ***\n", paths[i]);
+        return 1;
+      }
+      memcpy(state + (cell * DUMP_RECORD_BYTES), p, DUMP_RECORD_BYTES);
+      present[cell] = 1;
+    }
+    for(k=0;k<tombstones;++k,p+=4) {
+      cell = getLe(p, 4);
+      if (cell < POND_CELLS)
+        present[cell] = 0;
+    }
+    free(data);
+  }
+
+  for(cell=0;cell<POND_CELLS;++cell) {
+    if (present[cell])
+      writeDumpRecordCsv(stdout, state + (cell * DUMP_RECORD_BYTES));
+  }
+  free(state);
+  free(present);
+  return 0;
+}
+
+#if DUMP_ANALYSIS
+
+/* ----------------------------------------------------------------------- */
+/* Dump analysis                                                           */
+/* ----------------------------------------------------------------------- */
+
+/*
+ * analyzeDumps() maps each dump and splits it between threads, a binary
+ * dump by records and a CSV dump by lines. Each thread decodes its cells
+ * and hashes their genomes as CELL_GENOME_HASH does; the main thread then
+ * sorts the cells to group them by genome and by lineage. A CSV dump only
+ * has its genomes with runs of STOP shortened (see formatDumpGenome()),
+ * which are read back as such, so a genome with a long run of STOP inside
+ * it gets a different hash from a CSV dump than from a binary one.
+ *
+ * The state file is text: a line "NPONDANL <version> <POND_DEPTH>
+ * <INST_BITS>", then for each dump done a line "D <size> <mtime> <path>"
+ * followed by its summary line, then "H <count>" and the genome hashes
+ * of the last dump, one per line in hex.
+ */
+
+#define ANALYSIS_MAGIC "NPONDANL"
+#define ANALYSIS_VERSION 1
+
+/* Number of logo and facing values */
+#define ANALYSIS_LOGOS (LOGO_MASK + 1)
+#define ANALYSIS_FACINGS (FACING_MASK + 1)
+
+/* Longest line of the state file, and most threads used */
+#define ANALYSIS_LINE_BYTES 16384
+#define ANALYSIS_MAX_THREADS 256
+
+/**
+ * A cell of the dump being analyzed
+ */
+struct AnalysisCell
+{
+  uint64_t genomeHash;
+  uint64_t lineage;
+  uint64_t generation;
+  /* Its record (binary) or the start of its line (CSV) */
+  const uint8_t *rec;
+  uint8_t logo;
+  uint8_t facing;
+};
+
+/**
+ * A genome or a lineage of the dump being analyzed
+ */
+struct AnalysisGroup
+{
+  uint64_t key;
+  uint64_t cells;
+  /* Lineages with the genome, or genomes in the lineage */
+  uint64_t distinct;
+  uint64_t maxGeneration;
+  const uint8_t *rec;
+};
+
+/**
+ * Part of a dump, parsed by one thread
+ */
+struct AnalysisChunk
+{
+  const uint8_t *begin;
+  const uint8_t *end;
+  int binary;
+  struct AnalysisCell *cells;
+  uintptr_t count;
+  /* Lines of a CSV dump that could not be parsed */
+  uintptr_t skipped;
+  pthread_t thread;
+  int started;
+};
+
+/**
+ * A dump in the state file
+ */
+struct AnalysisEntry
+{
+  uint64_t size;
+  int64_t mtime;
+  char *path;
+  char *summary;
+};
+
+/* Instruction of each character of a CSV genome, or -1 if it is not
+ * one (a '.' is a STOP in a shortened run), see analyzeDumps() */
+static int8_t analysisInst[256];
+
+/**
+ * Parse an unsigned decimal field of a CSV dump line and its comma
+ *
+ * @param p Start of the field
+ * @param end End of the line
+ * @param v Set to its value
+ * @return Start of the next field, or NULL if there is no such field
+ */
+static const uint8_t *parseAnalysisField(const uint8_t *p, const uint8_t *const end, uint64_t *const v)
+{
+  const uint8_t *const start = p;
+
+  *v = 0;
+  while ((p < end)&&(*p >= '0')&&(*p <= '9'))
+    *v = (*v * 10) + (uint64_t)(*(p++) - '0');
+  return ((p > start)&&(p < end)&&(*p == ',')) ? (p + 1) : (const uint8_t *)0;
+}
+
+/**
+ * Parse the cells of part of a dump
+ *
+ * @param arg Chunk (struct AnalysisChunk), whose cells are allocated here
+ * @return Nothing
+ */
+static void *analysisChunkMain(void *arg)
+{
+  struct AnalysisChunk *const k = (struct AnalysisChunk *)arg;
+  uint8_t genome[POND_DEPTH];
+  const uint8_t *p, *q, *lineEnd;
+  uint64_t v[4];
+  uintptr_t n, i, bits, nbits;
+  struct AnalysisCell *c;
+
+  /* Size the cells for the records or lines there are */
+  if (k->binary) {
+    n = (uintptr_t)(k->end - k->begin) / DUMP_RECORD_BYTES;
+  } else {
+    for(n=0,p=k->begin;(p<k->end)&&((p = (const uint8_t *)memchr(p, '\n', (size_t)(k->end - p))));++p)
+      ++n;
+    ++n;
+  }
+  k->cells = (struct AnalysisCell *)malloc((n ? n : 1) * sizeof(struct AnalysisCell));
+  if (!k->cells)
+    return (void *)0;
+
+  for(p=k->begin;p<k->end;) {
+    c = &k->cells[k->count];
+    c->rec = p;
+    if (k->binary) {
+      c->lineage = getLe(p + 20, 8);
+      c->generation = getLe(p + 28, 8);
+      c->logo = p[36] & LOGO_MASK;
+      c->facing = p[37] & FACING_MASK;
+      q = p + 38;
+      for(i=0,bits=0,nbits=0;i<POND_DEPTH;++i) {
+        if (nbits < INST_BITS) {
+          bits |= (uintptr_t)*(q++) << nbits;
+          nbits += 8;
+        }
+        genome[i] = (uint8_t)(bits & (NUM_INST - 1));
+        bits >>= INST_BITS;
+        nbits -= INST_BITS;
+      }
+      p += DUMP_RECORD_BYTES;
+    } else {
+      lineEnd = (const uint8_t *)memchr(p, '\n', (size_t)(k->end - p));
+      if (!lineEnd)
+        lineEnd = k->end;
+      q = p;
+      p = lineEnd + 1;
+      if ((lineEnd > q)&&(lineEnd[-1] == '\r'))
+        --lineEnd;
+      if (lineEnd == q)
+        continue;
+
+      /* ID, parent ID, lineage, generation, logo, facing, genome */
+      q = parseAnalysisField(q, lineEnd, &v[0]);
+      for(i=1;(q)&&(i<4);++i)
+        q = parseAnalysisField(q, lineEnd, &v[i]);
+      if ((!q)||((lineEnd - q) < 4)||(q[1] != ',')||(q[3] != ',')||(analysisInst[q[0]] < 0)||(analysisInst[q[2]] < 0)) {
+        ++k->skipped;
+        continue;
+      }
+      c->lineage = v[2];
+      c->generation = v[3];
+      c->logo = (uint8_t)analysisInst[q[0]] & LOGO_MASK;
+      c->facing = (uint8_t)analysisInst[q[2]] & FACING_MASK;
+      for(q+=4,i=0;(q<lineEnd)&&(i<POND_DEPTH)&&(analysisInst[*q] >= 0);++q,++i)
+        genome[i] = (uint8_t)analysisInst[*q];
+      if (q != lineEnd) {
+        ++k->skipped;
+        continue;
+      }
+      memset(genome + i, OP_STOP, POND_DEPTH - i);
+    }
+    c->genomeHash = kernels.genomeHash(genome, genomeHashWeight);
+    ++k->count;
+  }
+  return (void *)0;
+}
+
+/**
+ * Order cells by genome hash, then by lineage
+ */
+static int compareAnalysisGenomes(const void *a, const void *b)
+{
+  const struct AnalysisCell *const x = (const struct AnalysisCell *)a, *const y = (const struct AnalysisCell *)b;
+  if (x->genomeHash != y->genomeHash)
+    return (x->genomeHash < y->genomeHash) ? -1 : 1;
+  return (x->lineage < y->lineage) ? -1 : ((x->lineage > y->lineage) ? 1 : 0);
+}
+
+/**
+ * Order cells by lineage, then by genome hash
+ */
+static int compareAnalysisLineages(const void *a, const void *b)
+{
+  const struct AnalysisCell *const x = (const struct AnalysisCell *)a, *const y = (const struct AnalysisCell *)b;
+  if (x->lineage != y->lineage)
+    return (x->lineage < y->lineage) ? -1 : 1;
+  return (x->genomeHash < y->genomeHash) ? -1 : ((x->genomeHash > y->genomeHash) ? 1 : 0);
+}
+
+/**
+ * Order groups by cells, most first, then by key
+ */
+static int compareAnalysisGroups(const void *a, const void *b)
+{
+  const struct AnalysisGroup *const x = (const struct AnalysisGroup *)a, *const y = (const struct AnalysisGroup *)b;
+  if (x->cells != y->cells)
+    return (x->cells > y->cells) ? -1 : 1;
+  return (x->key < y->key) ? -1 : ((x->key > y->key) ? 1 : 0);
+}
+
+/**
+ * Group sorted cells by genome or by lineage
+ *
+ * @param cells Cells, sorted with compareAnalysisGenomes() or
+ *   compareAnalysisLineages()
+ * @param n Number of cells
+ * @param byLineage Nonzero to group by lineage
+ * @param groups Set to the groups, in the order of the cells (free with free())
+ * @return Number of groups, or -1 if out of memory
+ */
+static intptr_t groupAnalysisCells(const struct AnalysisCell *const cells, const uintptr_t n, const int byLineage, struct AnalysisGroup **const groups)
+{
+  struct AnalysisGroup *g = (struct AnalysisGroup *)0;
+  uintptr_t i, count = 0;
+  uint64_t key, other, lastOther = 0;
+
+  *groups = (struct AnalysisGroup *)malloc((n ? n : 1) * sizeof(struct AnalysisGroup));
+  if (!*groups)
+    return -1;
+  for(i=0;i<n;++i) {
+    key = byLineage ? cells[i].lineage : cells[i].genomeHash;
+    other = byLineage ? cells[i].genomeHash : cells[i].lineage;
+    if ((!g)||(g->key != key)) {
+      g = &(*groups)[count++];
+      g->key = key;
+      g->cells = 0;
+      g->distinct = 0;
+      g->maxGeneration = 0;
+      g->rec = cells[i].rec;
+    }
+    if ((!g->cells)||(other != lastOther))
+      ++g->distinct;
+    lastOther = other;
+    ++g->cells;
+    if (cells[i].generation > g->maxGeneration)
+      g->maxGeneration = cells[i].generation;
+  }
+  return (intptr_t)count;
+}
+
+/**
+ * Write the genomes or the lineages of a dump to <dump>.genomes.csv or
+ * <dump>.lineages.csv, largest first
+ *
+ * @param path Dump
+ * @param groups Groups, put in order here
+ * @param n Number of groups
+ * @param binary Nonzero if the dump is binary
+ * @param byLineage Nonzero if the groups are lineages
+ */
+static void writeAnalysisGroups(const char *path, struct AnalysisGroup *const groups, const uintptr_t n, const int binary, const int byLineage)
+{
+  char name[4096], genome[POND_DEPTH + 1];
+  const uint8_t *p;
+  uintptr_t i, len, commas;
+  FILE *f;
+
+  snprintf(name, sizeof(name), "%s.%s.csv", path, byLineage ? "lineages" : "genomes");
+  f = fopen(name, "w");
+  if (!f) {
+    fprintf(stderr,"[WARNING] Could not open %s for writing.\n", name);
+    return;
+  }
+  qsort(groups, n, sizeof(struct AnalysisGroup), compareAnalysisGroups);
+  fprintf(f, byLineage ? "lineage,cells,genomes,max_generation\n" : "genome_hash,cells,lineages,max_generation,genome\n");
+  for(i=0;i<n;++i) {
+    if (byLineage) {
+      fprintf(f, "%ju,%ju,%ju,%ju\n", (uintmax_t)groups[i].key, (uintmax_t)groups[i].cells, (uintmax_t)groups[i].distinct, (uintmax_t)groups[i].maxGeneration);
+      continue;
+    }
+    if (binary) {
+      len = formatDumpGenome(genome, groups[i].rec + 38);
+    } else {
+      /* The genome is the seventh field of the cell's line */
+      for(p=groups[i].rec,commas=0;commas<6;++p) {
+        if (*p == ',')
+          ++commas;
+      }
+      for(len=0;(len<POND_DEPTH)&&(analysisInst[p[len]] >= 0);++len)
+        genome[len] = (char)p[len];
+    }
+    genome[len] = (char)0;
+    fprintf(f, "%016jx,%ju,%ju,%ju,%s\n", (uintmax_t)groups[i].key, (uintmax_t)groups[i].cells, (uintmax_t)groups[i].distinct, (uintmax_t)groups[i].maxGeneration, genome);
+  }
+  fclose(f);
+}
+
+/**
+ * Analyze a dump, writing its genomes and lineages next to it
+ *
+ * @param path CSV dump or full binary dump
+ * @param prev Sorted genome hashes of the dump before, or NULL for none
+ * @param prevCount Number of hashes in prev
+ * @param hashes Set to the sorted genome hashes of this dump (free with free())
+ * @param hashCount Set to the number of hashes
+ * @param summary Set to the summary line, without a newline (free with free())
+ * @return 0 on success, nonzero on error (with a message printed)
+ */
+static int analyzeDump(const char *path, const uint64_t *const prev, const uintptr_t prevCount, uint64_t **const hashes, uintptr_t *const hashCount, char **const summary)
+{
+  struct AnalysisChunk chunks[ANALYSIS_MAX_THREADS];
+  struct AnalysisCell *cells;
+  struct AnalysisGroup *genomes, *lineages;
+  const uint8_t *data = (const uint8_t *)0, *begin, *end, *p;
+  uint8_t *owned = (uint8_t *)0;
+  uint64_t logos[ANALYSIS_LOGOS], facings[ANALYSIS_FACINGS], gained = 0, lost = 0, skipped = 0;
+  uintptr_t threads = DUMP_ANALYSIS_THREADS, n = 0, i, j, k, used;
+  intptr_t genomeCount, lineageCount;
+  size_t size = 0, bufSize;
+  double diversity = 0.0, share;
+  struct stat st;
+  int fd, binary = 0;
+  char *line;
+
+  *hashes = (uint64_t *)0;
+  *hashCount = 0;
+  *summary = (char *)0;
+
+  fd = open(path, O_RDONLY);
+  if ((fd < 0)||(fstat(fd, &st))) {
+    fprintf(stderr,"*** Unable to open dump %s ***\n", path);
+    if (fd >= 0)
+      close(fd);
+    return 1;
+  }
+  size = (size_t)st.st_size;
+  if (size) {
+    data = (const uint8_t *)mmap((void *)0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if ((void *)data == MAP_FAILED) {
+      fprintf(stderr,"*** Unable to read dump %s ***\n", path);
+      close(fd);
+      return 1;
+    }
+  }
+  close(fd);
+  begin = data;
+  end = data + size;
+
+#ifdef USE_ZSTD
+  if ((size >= 4)&&(getLe(data, 4) == ZSTD_MAGICNUMBER)) {
+    munmap((void *)data, size);
+    data = (const uint8_t *)0;
+    owned = readDump(path, &size);
+    if (!owned)
+      return 1;
+    begin = owned;
+    end = owned + size;
+  }
+#endif /* USE_ZSTD */
+  if ((size >= 8)&&(!memcmp(begin, DUMP_MAGIC, 8))) {
+    if (checkDump(path, begin, size)) {
+      if (data)
+        munmap((void *)data, size);
+      free(owned);
+      return 1;
+    }
+    if (getLe(begin + 48, 8) != getLe(begin + 24, 8)) {
+      fprintf(stderr,"*** %s is a delta dump; convert the series to CSV with -d first ***\n", path);
+      if (data)
+        munmap((void *)data, size);
+      free(owned);
+      return 1;
+    }
+    binary = 1;
+    end = begin + DUMP_HEADER_BYTES + ((size_t)getLe(begin + 32, 8) * DUMP_RECORD_BYTES);
+    begin += DUMP_HEADER_BYTES;
+  }
+
+  /* Split the dump between the threads, at records or lines */
+  if (!threads) {
+    const long np = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = (np > 0) ? (uintptr_t)np : 1;
+  }
+  if (threads > ANALYSIS_MAX_THREADS)
+    threads = ANALYSIS_MAX_THREADS;
+  for(i=0,p=begin;i<threads;++i) {
+    memset(&chunks[i], 0, sizeof(struct AnalysisChunk));
+    chunks[i].binary = binary;
+    chunks[i].begin = p;
+    if (i == (threads - 1)) {
+      p = end;
+    } else if (binary) {
+      p = begin + ((((size_t)(end - begin) / DUMP_RECORD_BYTES) * (i + 1) / threads) * DUMP_RECORD_BYTES);
+    } else {
+      p = begin + ((size_t)(end - begin) * (i + 1) / threads);
+      if (p < chunks[i].begin)
+        p = chunks[i].begin;
+      while ((p < end)&&(p > begin)&&(p[-1] != '\n'))
+        ++p;
+    }
+    chunks[i].end = p;
+  }
+  for(i=1;i<threads;++i)
+    chunks[i].started = !pthread_create(&chunks[i].thread, (const pthread_attr_t *)0, analysisChunkMain, &chunks[i]);
+  analysisChunkMain(&chunks[0]);
+  for(i=0;i<threads;++i) {
+    if (chunks[i].started)
+      pthread_join(chunks[i].thread, (void **)0);
+    else if (i)
+      analysisChunkMain(&chunks[i]);
+    n += chunks[i].count;
+    skipped += chunks[i].skipped;
+  }
+
+  /* Gather the cells and count logos and facings */
+  cells = (struct AnalysisCell *)malloc((n ? n : 1) * sizeof(struct AnalysisCell));
+  for(i=0;(cells)&&(i<threads);++i) {
+    if (!chunks[i].cells) {
+      free(cells);
+      cells = (struct AnalysisCell *)0;
+    }
+  }
+  if (!cells) {
+    fprintf(stderr,"*** Unable to allocate memory ***\n");
+    for(i=0;i<threads;++i)
+      free(chunks[i].cells);
+    if (data)
+      munmap((void *)data, size);
+    free(owned);
+    return 1;
+  }
+  for(i=0,k=0;i<threads;++i) {
+    memcpy(cells + k, chunks[i].cells, chunks[i].count * sizeof(struct AnalysisCell));
+    k += chunks[i].count;
+    free(chunks[i].cells);
+  }
+  if (skipped)
+    fprintf(stderr,"[WARNING] %s: %ju lines could not be parsed.\n", path, (uintmax_t)skipped);
+  memset(logos, 0, sizeof(logos));
+  memset(facings, 0, sizeof(facings));
+  for(i=0;i<n;++i) {
+    ++logos[cells[i].logo];
+    ++facings[cells[i].facing];
+  }
+
+  /* Genomes, and those gained and lost since the dump before */
+  qsort(cells, n, sizeof(struct AnalysisCell), compareAnalysisGenomes);
+  genomeCount = groupAnalysisCells(cells, n, 0, &genomes);
+  *hashes = (uint64_t *)malloc((size_t)((genomeCount > 0) ? genomeCount : 1) * sizeof(uint64_t));
+  if ((genomeCount < 0)||(!*hashes)) {
+    fprintf(stderr,"*** Unable to allocate memory ***\n");
+    free(*hashes);
+    *hashes = (uint64_t *)0;
+    free(genomes);
+    free(cells);
+    if (data)
+      munmap((void *)data, size);
+    free(owned);
+    return 1;
+  }
+  for(i=0;i<(uintptr_t)genomeCount;++i) {
+    (*hashes)[i] = genomes[i].key;
+    share = (double)genomes[i].cells / (double)n;
+    diversity -= share * log(share);
+  }
+  *hashCount = (uintptr_t)genomeCount;
+  for(i=0,j=0;(prev)&&((i<(uintptr_t)genomeCount)||(j<prevCount));) {
+    if ((j >= prevCount)||((i < (uintptr_t)genomeCount)&&((*hashes)[i] < prev[j]))) {
+      ++gained;
+      ++i;
+    } else if ((i >= (uintptr_t)genomeCount)||(prev[j] < (*hashes)[i])) {
+      ++lost;
+      ++j;
+    } else {
+      ++i;
+      ++j;
+    }
+  }
+  if (!prev)
+    gained = (uint64_t)genomeCount;
+
+  /* Lineages */
+  qsort(cells, n, sizeof(struct AnalysisCell), compareAnalysisLineages);
+  lineageCount = groupAnalysisCells(cells, n, 1, &lineages);
+  if (lineageCount < 0) {
+    fprintf(stderr,"*** Unable to allocate memory ***\n");
+    free(*hashes);
+    *hashes = (uint64_t *)0;
+    free(genomes);
+    free(cells);
+    if (data)
+      munmap((void *)data, size);
+    free(owned);
+    return 1;
+  }
+  writeAnalysisGroups(path, genomes, (uintptr_t)genomeCount, binary, 0);
+  writeAnalysisGroups(path, lineages, (uintptr_t)lineageCount, binary, 1);
+
+  /* The groups are now largest first */
+  bufSize = strlen(path) + 512 + (24 * (ANALYSIS_LOGOS + ANALYSIS_FACINGS));
+  line = (char *)malloc(bufSize);
+  if (line) {
+    used = (uintptr_t)snprintf(line, bufSize, "%s,%ju,%ju,%ju,%ju,%.4f,%016jx,%ju,%ju,%ju,%ju",
+      path,
+      (uintmax_t)n,
+      (uintmax_t)genomeCount,
+      (uintmax_t)gained,
+      (uintmax_t)lost,
+      diversity,
+      (uintmax_t)(genomeCount ? genomes[0].key : 0),
+      (uintmax_t)(genomeCount ? genomes[0].cells : 0),
+      (uintmax_t)lineageCount,
+      (uintmax_t)(lineageCount ? lineages[0].key : 0),
+      (uintmax_t)(lineageCount ? lineages[0].cells : 0));
+    for(i=0;i<ANALYSIS_LOGOS;++i)
+      used += (uintptr_t)snprintf(line + used, bufSize - used, ",%ju", (uintmax_t)logos[i]);
+    for(i=0;i<ANALYSIS_FACINGS;++i)
+      used += (uintptr_t)snprintf(line + used, bufSize - used, ",%ju", (uintmax_t)facings[i]);
+  }
+  *summary = line;
+
+  free(lineages);
+  free(genomes);
+  free(cells);
+  if (data)
+    munmap((void *)data, size);
+  free(owned);
+  if (!line) {
+    fprintf(stderr,"*** Unable to allocate memory ***\n");
+    free(*hashes);
+    *hashes = (uint64_t *)0;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * Free what readAnalysisState() read
+ *
+ * @param entries Dumps
+ * @param n Number of dumps
+ */
+static void freeAnalysisEntries(struct AnalysisEntry *const entries, const uintptr_t n)
+{
+  uintptr_t i;
+  for(i=0;i<n;++i) {
+    free(entries[i].path);
+    free(entries[i].summary);
+  }
+  free(entries);
+}
+
+/**
+ * Read a state file written by writeAnalysisState()
+ *
+ * A missing state file is an empty one.
+ *
+ * @param statePath State file
+ * @param entries Set to the dumps done (free with freeAnalysisEntries())
+ * @param entryCount Set to the number of dumps
+ * @param hashes Set to the genome hashes of the last one (free with free())
+ * @param hashCount Set to the number of hashes
+ * @return 0 on success, nonzero on error (with a message printed)
+ */
+static int readAnalysisState(const char *statePath, struct AnalysisEntry **const entries, uintptr_t *const entryCount, uint64_t **const hashes, uintptr_t *const hashCount)
+{
+  static char line[ANALYSIS_LINE_BYTES];
+  unsigned long long size, count, i;
+  unsigned int version, depth, bits;
+  long long mtime;
+  struct AnalysisEntry *p;
+  uintptr_t capacity = 0;
+  int offset, ok = 0;
+  FILE *f;
+
+  *entries = (struct AnalysisEntry *)0;
+  *entryCount = 0;
+  *hashes = (uint64_t *)0;
+  *hashCount = 0;
+  f = fopen(statePath, "r");
+  if (!f)
+    return 0;
+
+  if ((!fgets(line, sizeof(line), f))||(sscanf(line, ANALYSIS_MAGIC " %u %u %u", &version, &depth, &bits) != 3)||(version != ANALYSIS_VERSION)||(depth != POND_DEPTH)||(bits != INST_BITS)) {
+    fprintf(stderr,"*** %s is not an analysis state file of this build ***\n", statePath);
+    fclose(f);
+    return 1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    line[strcspn(line, "\r\n")] = (char)0;
+    if (sscanf(line, "D %llu %lld %n", &size, &mtime, &offset) == 2) {
+      if (*entryCount == capacity) {
+        capacity = capacity ? (capacity << 1) : 64;
+        p = (struct AnalysisEntry *)realloc(*entries, capacity * sizeof(struct AnalysisEntry));
+        if (!p)
+          break;
+        *entries = p;
+      }
+      p = &(*entries)[*entryCount];
+      p->size = (uint64_t)size;
+      p->mtime = (int64_t)mtime;
+      p->path = strdup(line + offset);
+      p->summary = (char *)0;
+      ++*entryCount;
+      if ((!p->path)||(!fgets(line, sizeof(line), f)))
+        break;
+      line[strcspn(line, "\r\n")] = (char)0;
+      if (!(p->summary = strdup(line)))
+        break;
+    } else if (sscanf(line, "H %llu", &count) == 1) {
+      *hashes = (uint64_t *)malloc((size_t)(count ? count : 1) * sizeof(uint64_t));
+      for(i=0;(*hashes)&&(i<count)&&(fgets(line, sizeof(line), f));++i)
+        (*hashes)[i] = (uint64_t)strtoull(line, (char **)0, 16);
+      *hashCount = (uintptr_t)i;
+      ok = (*hashes)&&(i == count);
+      break;
+    } else {
+      break;
+    }
+  }
+  fclose(f);
+
+  if (!ok) {
+    fprintf(stderr,"*** Unable to read analysis state file %s ***\n", statePath);
+    freeAnalysisEntries(*entries, *entryCount);
+    free(*hashes);
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * Replace the state file
+ *
+ * @param statePath State file
+ * @param entries Dumps done, in order
+ * @param entryCount Number of dumps
+ * @param hashes Sorted genome hashes of the last one
+ * @param hashCount Number of hashes
+ * @return 0 on success, nonzero on error (with a message printed)
+ */
+static int writeAnalysisState(const char *statePath, const struct AnalysisEntry *const entries, const uintptr_t entryCount, const uint64_t *const hashes, const uintptr_t hashCount)
+{
+  char tmp[4096];
+  uintptr_t i;
+  FILE *f;
+  int failed;
+
+  snprintf(tmp, sizeof(tmp), "%s.tmp", statePath);
+  f = fopen(tmp, "w");
+  if (!f) {
+    fprintf(stderr,"*** Unable to write analysis state file %s ***\n", tmp);
+    return 1;
+  }
+  fprintf(f, "%s %u %u %u\n", ANALYSIS_MAGIC, (unsigned int)ANALYSIS_VERSION, (unsigned int)POND_DEPTH, (unsigned int)INST_BITS);
+  for(i=0;i<entryCount;++i)
+    fprintf(f, "D %ju %jd %s\n%s\n", (uintmax_t)entries[i].size, (intmax_t)entries[i].mtime, entries[i].path, entries[i].summary);
+  fprintf(f, "H %ju\n", (uintmax_t)hashCount);
+  for(i=0;i<hashCount;++i)
+    fprintf(f, "%016jx\n", (uintmax_t)hashes[i]);
+  failed = ferror(f);
+  if ((fclose(f))||(failed)||(rename(tmp, statePath))) {
+    fprintf(stderr,"*** Unable to write analysis state file %s ***\n", statePath);
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * Summarize a series of dumps as CSV on standard output
+ *
+ * Each line is a dump: its path, cells, genomes, genomes not in the dump
+ * before and genomes of the dump before that are gone, the Shannon
+ * diversity of genomes (in nats), the most common genome and its cells,
+ * lineages, the largest lineage and its cells, then the cells with each
+ * logo and with each facing. The genomes of each dump (hash, cells,
+ * lineages, highest generation and genome as in a CSV dump) and its
+ * lineages (lineage, cells, genomes and highest generation) are written,
+ * largest first, to <dump>.genomes.csv and <dump>.lineages.csv.
+ *
+ * Dumps already in the state file, with the same size and time and in
+ * the same place in the series, are not read again: their lines come
+ * from the state file, which is then rewritten for this series. So
+ * rerunning it as dumps are added reads only the new ones.
+ *
+ * @param statePath State file (created if missing)
+ * @param paths Dumps, CSV or full binary (compressed or not), in order
+ * @param count Number of dumps
+ * @return 0 on success, nonzero on error (with a message printed)
+ */
+static int analyzeDumps(const char *statePath, char **paths, const uintptr_t count)
+{
+  struct AnalysisEntry *old, *entries;
+  uintptr_t oldCount, oldHashCount, hashCount = 0, prevCount = 0, cached, i;
+  uint64_t *oldHashes, *hashes = (uint64_t *)0, *prev = (uint64_t *)0;
+  struct stat st;
+  char *summary;
+  int failed = 0;
+
+  memset(analysisInst, -1, sizeof(analysisInst));
+  for(i=0;i<NUM_INST;++i)
+    analysisInst[(uint8_t)inst_chars[i]] = (int8_t)i;
+  analysisInst['.'] = OP_STOP;
+
+  if (readAnalysisState(statePath, &old, &oldCount, &oldHashes, &oldHashCount))
+    return 1;
+  entries = (struct AnalysisEntry *)calloc(count, sizeof(struct AnalysisEntry));
+  if (!entries) {
+    fprintf(stderr,"*** Unable to allocate memory ***\n");
+    freeAnalysisEntries(old, oldCount);
+    free(oldHashes);
+    return 1;
+  }
+
+  fprintf(stdout,"dump,cells,genomes,new_genomes,lost_genomes,genome_diversity,top_genome,top_genome_cells,lineages,top_lineage,top_lineage_cells");
+  for(i=0;i<ANALYSIS_LOGOS;++i)
+    fprintf(stdout,",logo_%c", inst_chars[i]);
+  for(i=0;i<ANALYSIS_FACINGS;++i)
+    fprintf(stdout,",facing_%c", inst_chars[i]);
+  fprintf(stdout,"\n");
+
+  /* The dumps that start the series as they did last time are done */
+  for(i=0;i<count;++i) {
+    if (stat(paths[i], &st)) {
+      fprintf(stderr,"*** Unable to open dump %s ***\n", paths[i]);
+      failed = 1;
+      break;
+    }
+    entries[i].size = (uint64_t)st.st_size;
+    entries[i].mtime = (int64_t)st.st_mtime;
+    entries[i].path = paths[i];
+  }
+  for(cached=0;(!failed)&&(cached<count)&&(cached<oldCount);++cached) {
+    if ((strcmp(old[cached].path, paths[cached]))||(old[cached].size != entries[cached].size)||(old[cached].mtime != entries[cached].mtime))
+      break;
+    entries[cached].summary = old[cached].summary;
+    fprintf(stdout,"%s\n", entries[cached].summary);
+  }
+  if ((!failed)&&(cached)) {
+    if (cached == oldCount) {
+      /* The last dump done is the one before the first new one */
+      prev = oldHashes;
+      prevCount = oldHashCount;
+      oldHashes = (uint64_t *)0;
+    } else if (analyzeDump(paths[cached - 1], (const uint64_t *)0, 0, &prev, &prevCount, &summary)) {
+      /* The series went another way after it, so its genomes are needed */
+      failed = 1;
+    } else {
+      free(summary);
+    }
+  }
+  if ((!failed)&&(cached == count)&&(cached)) {
+    hashes = prev;
+    hashCount = prevCount;
+    prev = (uint64_t *)0;
+  }
+  if ((!failed)&&(cached < count))
+    fprintf(stderr,"[INFO] %ju dumps done before, %ju to analyze\n", (uintmax_t)cached, (uintmax_t)(count - cached));
+
+  for(i=cached;(!failed)&&(i<count);++i) {
+    if (analyzeDump(paths[i], prev, prevCount, &hashes, &hashCount, &summary)) {
+      failed = 1;
+      break;
+    }
+    fprintf(stdout,"%s\n", summary);
+    fflush(stdout);
+    entries[i].summary = summary;
+    free(prev);
+    prev = hashes;
+    prevCount = hashCount;
+  }
+  if (!failed) {
+    prev = (uint64_t *)0;
+    failed = writeAnalysisState(statePath, entries, count, hashes, hashCount);
+  }
+
+  for(i=cached;i<count;++i)
+    free(entries[i].summary);
+  free(entries);
+  freeAnalysisEntries(old, oldCount);
+  free(oldHashes);
+  free(prev);
+  free(hashes);
+  return failed;
+}
+
+#endif /* DUMP_ANALYSIS */
+
+#if TELEMETRY
+
+/* ----------------------------------------------------------------------- */
+/* Telemetry exporter                                                      */
+/* ----------------------------------------------------------------------- */
+
+/*
+ * The binary log (TELEMETRY_LOG) starts with a header of
+ * TELEMETRY_HEADER_BYTES followed by records of TELEMETRY_RECORD_BYTES,
+ * all integers little-endian. A record has a kind and a reserved field
+ * (uint32), the clock, the population totals in the order of struct
+ * PopulationTotals, the counters of struct PerReportStatCounters after
+ * the instruction counts, and then the NUM_INST instruction counts (all
+ * uint64). Events have the totals and counters of the report they were
+ * seen at. Each UDP datagram (TELEMETRY_UDP_PORT) is one record.
+ */
+
+#define TELEMETRY_MAGIC "NPONDTLM"
+#define TELEMETRY_VERSION 1
+
+/* Magic, version, NUM_INST, record bytes, reserved (uint32) */
+#define TELEMETRY_HEADER_BYTES 24
+#define TELEMETRY_RECORD_BYTES (16 + (8 * (21 + NUM_INST)))
+
+#if defined(TELEMETRY_UDP_PORT) && (!defined(TELEMETRY_UDP_HOST))
+#define TELEMETRY_UDP_HOST "127.0.0.1"
+#endif
+
+/**
+ * Encode a record as in the binary log
+ *
+ * @param p TELEMETRY_RECORD_BYTES to write to
+ * @param r Record
+ */
+static void packTelemetryRecord(uint8_t *p, const struct TelemetryRecord *const r)
+{
+  const uint64_t v[21] = {
+    r->clock,
+    r->t.activeCells,
+    r->t.livingCells,
+    r->t.viableReplicators,
+    r->t.totalEnergy,
+    r->t.livingEnergy,
+    r->t.viableEnergy,
+    (uint64_t)r->t.maxCellEnergy,
+    (uint64_t)r->t.maxLivingCellEnergy,
+    (uint64_t)r->t.maxGeneration,
+    r->stats.cellExecutions,
+    r->stats.viableCellsReplaced,
+    r->stats.viableCellsKilled,
+    r->stats.viableCellShares,
+    r->stats.memSpecialReads,
+    r->stats.memPrivateReads,
+    r->stats.memOutputReads,
+    r->stats.memInputReads,
+    r->stats.memSpecialWrites,
+    r->stats.memPrivateWrites,
+    r->stats.memOutputWrites
+  };
+  uintptr_t i;
+
+  putLe(p, r->kind, 4);
+  putLe(p + 4, 0, 4);
+  p += 8;
+  for(i=0;i<21;++i,p+=8)
+    putLe(p, v[i], 8);
+  putLe(p, r->stats.memInputWrites, 8);
+  p += 8;
+  for(i=0;i<NUM_INST;++i,p+=8)
+    putLe(p, r->stats.instructionExecutions[i], 8);
+}
+
+/**
+ * Write a record to everywhere it goes
+ *
+ * @param tm Telemetry
+ * @param r Record
+ */
+static void exportTelemetryRecord(struct Telemetry *const tm, const struct TelemetryRecord *const r)
+{
+  uint8_t buf[TELEMETRY_RECORD_BYTES];
+
+  switch (r->kind) {
+    case TELEMETRY_REPORT:
+#if TELEMETRY_CSV
+      writeReportCsv(tm->report, r->clock, &r->t, &r->stats);
+#endif
+      break;
+    case TELEMETRY_EXTINCT:
+      fprintf(stderr,"[EVENT] Viable replicators have gone extinct. Please reserve a moment of silence.\n");
+      break;
+    case TELEMETRY_APPEARED:
+      fprintf(stderr,"[EVENT] Viable replicators have appeared!\n");
+      break;
+  }
+
+  if ((tm->log)||(tm->udp >= 0))
+    packTelemetryRecord(buf, r);
+  if (tm->log)
+    fwrite(buf, 1, TELEMETRY_RECORD_BYTES, tm->log);
+#ifdef TELEMETRY_UDP_PORT
+  if (tm->udp >= 0)
+    send(tm->udp, buf, TELEMETRY_RECORD_BYTES, MSG_DONTWAIT|MSG_NOSIGNAL);
+#endif
+}
+
+/**
+ * Exporter thread, which drains the ring until told to quit
+ *
+ * @param arg Telemetry
+ * @return Nothing
+ */
+static void *telemetryMain(void *arg)
+{
+  struct Telemetry *const tm = (struct Telemetry *)arg;
+  uint_fast64_t tail = atomic_load_explicit(&tm->tail, memory_order_relaxed), head;
+  int quit;
+
+  for(;;) {
+    /* (quit is read first, so once it is set head has every record) */
+    quit = atomic_load_explicit(&tm->quit, memory_order_acquire);
+    head = atomic_load_explicit(&tm->head, memory_order_acquire);
+    if (tail == head) {
+      if (quit)
+        break;
+      if (tm->log)
+        fflush(tm->log);
+      usleep(TELEMETRY_POLL_US);
+      continue;
+    }
+    for(;tail!=head;++tail) {
+      exportTelemetryRecord(tm, &tm->ring[tail & (TELEMETRY_RING - 1)]);
+      atomic_store_explicit(&tm->tail, tail + 1, memory_order_release);
+    }
+  }
+  return (void *)0;
+}
+
+/**
+ * Open the telemetry outputs and start the exporter thread
+ *
+ * @return 0 on success, 1 on failure
+ */
+static int startTelemetry()
+{
+  /* (Aligned, so that head and tail are on cache lines of their own) */
+  struct Telemetry *const tm = (struct Telemetry *)aligned_alloc(CACHE_LINE_BYTES, sizeof(struct Telemetry));
+
+  if (!tm) {
+    fprintf(stderr,"*** Unable to allocate the telemetry ring ***\n");
+    return 1;
+  }
+  memset(tm, 0, sizeof(struct Telemetry));
+  atomic_init(&tm->head, 0);
+  atomic_init(&tm->tail, 0);
+  atomic_init(&tm->quit, 0);
+  tm->report = config.report;
+  tm->log = (FILE *)0;
+  tm->udp = -1;
+
+#ifdef TELEMETRY_LOG
+  {
+    char path[sizeof(config.outputPrefix) + sizeof(TELEMETRY_LOG)];
+    uint8_t h[TELEMETRY_HEADER_BYTES];
+
+    snprintf(path, sizeof(path), "%s%s", config.outputPrefix, TELEMETRY_LOG);
+    tm->log = fopen(path, "wb");
+    if (!tm->log) {
+      fprintf(stderr,"*** Unable to open %s for writing ***\n", path);
+      free(tm);
+      return 1;
+    }
+    memcpy(h, TELEMETRY_MAGIC, 8);
+    putLe(h + 8, TELEMETRY_VERSION, 4);
+    putLe(h + 12, NUM_INST, 4);
+    putLe(h + 16, TELEMETRY_RECORD_BYTES, 4);
+    putLe(h + 20, 0, 4);
+    fwrite(h, 1, TELEMETRY_HEADER_BYTES, tm->log);
+  }
+#endif /* TELEMETRY_LOG */
+
+#ifdef TELEMETRY_UDP_PORT
+  {
+    struct addrinfo hints, *ai, *a;
+    char port[16];
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    snprintf(port, sizeof(port), "%d", (int)(TELEMETRY_UDP_PORT));
+    if (!getaddrinfo(TELEMETRY_UDP_HOST, port, &hints, &ai)) {
+      for(a=ai;a;a=a->ai_next) {
+        tm->udp = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (tm->udp < 0)
+          continue;
+        if (!connect(tm->udp, a->ai_addr, a->ai_addrlen))
+          break;
+        close(tm->udp);
+        tm->udp = -1;
+      }
+      freeaddrinfo(ai);
+    }
+    if (tm->udp < 0)
+      fprintf(stderr,"[WARNING] Unable to send telemetry to %s port %s.\n", TELEMETRY_UDP_HOST, port);
+  }
+#endif /* TELEMETRY_UDP_PORT */
+
+  if (pthread_create(&tm->thread, (const pthread_attr_t *)0, telemetryMain, tm)) {
+    fprintf(stderr,"*** Unable to create the telemetry thread ***\n");
+    if (tm->log)
+      fclose(tm->log);
+    if (tm->udp >= 0)
+      close(tm->udp);
+    free(tm);
+    return 1;
+  }
+  telemetry = tm;
+  return 0;
+}
+
+/**
+ * Export what is left in the ring and stop the exporter thread
+ */
+static void stopTelemetry()
+{
+  struct Telemetry *const tm = telemetry;
+
+  if (!tm)
+    return;
+  atomic_store_explicit(&tm->quit, 1, memory_order_release);
+  pthread_join(tm->thread, (void **)0);
+  if (tm->log)
+    fclose(tm->log);
+  if (tm->udp >= 0)
+    close(tm->udp);
+  if (tm->stalls)
+    fprintf(stderr,"[INFO] Reports waited for the telemetry exporter %ju times\n", (uintmax_t)tm->stalls);
+  free(tm);
+  telemetry = (struct Telemetry *)0;
+}
+
+#endif /* TELEMETRY */
+
+#if BIRTH_LOG
+
+/* ----------------------------------------------------------------------- */
+/* Birth log                                                               */
+/* ----------------------------------------------------------------------- */
+
+/*
+ * The log starts with a header of BIRTH_HEADER_BYTES followed by records
+ * of BIRTH_RECORD_BYTES, all integers little-endian: the offspring's ID,
+ * its parent's ID, its lineage, the clock and its genome hash (uint64),
+ * its generation (uint32) and its X and Y position (uint16). With
+ * PARALLEL_THREADS the clock is that of the epoch, and records are in
+ * no particular order.
+ */
+
+#define BIRTH_MAGIC "NPONDBRT"
+#define BIRTH_VERSION 1
+
+/* Magic, version, record bytes, POND_SIZE_X, POND_SIZE_Y (uint32) */
+#define BIRTH_HEADER_BYTES 24
+
+/**
+ * The log being written
+ */
+struct BirthLog
+{
+  /* -1 if there is no log (or it failed) */
+  int fd;
+  /* BIRTH_LOG_CHUNK bytes of the file mapped at mapOffset, of which the
+   * first mapUsed are written */
+  uint8_t *map;
+  uint64_t mapOffset;
+  size_t mapUsed;
+#if (PARALLEL_THREADS > 0)
+  pthread_mutex_t lock;
+#endif
+};
+
+static POND_STATE struct BirthLog birthLog = { -1, (uint8_t *)0, 0, 0
+#if (PARALLEL_THREADS > 0)
+  , PTHREAD_MUTEX_INITIALIZER
+#endif
+};
+
+/* Clock of the current tick (or epoch), set by doHousekeeping() */
+static POND_STATE uint64_t birthClock = 0;
+
+/**
+ * Unmap the log and cut the file off after what was written
+ */
+static void endBirthLog()
+{
+  if (birthLog.map)
+    munmap(birthLog.map, BIRTH_LOG_CHUNK);
+  if (ftruncate(birthLog.fd, (off_t)(birthLog.mapOffset + birthLog.mapUsed)))
+    fprintf(stderr,"[WARNING] Could not truncate the birth log.\n");
+  close(birthLog.fd);
+  birthLog.fd = -1;
+  birthLog.map = (uint8_t *)0;
+}
+
+/**
+ * Append bytes to the log, mapping the next chunk of the file as needed
+ *
+ * @param p Bytes
+ * @param n Number of bytes
+ */
+static void birthLogWrite(const uint8_t *p, size_t n)
+{
+  size_t k;
+  void *m;
+
+  while ((n)&&(birthLog.fd >= 0)) {
+    if (birthLog.mapUsed == BIRTH_LOG_CHUNK) {
+      munmap(birthLog.map, BIRTH_LOG_CHUNK);
+      birthLog.map = (uint8_t *)0;
+      birthLog.mapOffset += BIRTH_LOG_CHUNK;
+      birthLog.mapUsed = 0;
+      m = MAP_FAILED;
+      if (!ftruncate(birthLog.fd, (off_t)(birthLog.mapOffset + BIRTH_LOG_CHUNK)))
+        m = mmap((void *)0, BIRTH_LOG_CHUNK, PROT_READ|PROT_WRITE, MAP_SHARED, birthLog.fd, (off_t)birthLog.mapOffset);
+      if (m == MAP_FAILED) {
+        fprintf(stderr,"[WARNING] Could not write the birth log, no more births will be logged.\n");
+        endBirthLog();
+        return;
+      }
+      birthLog.map = (uint8_t *)m;
+    }
+    k = BIRTH_LOG_CHUNK - birthLog.mapUsed;
+    if (k > n)
+      k = n;
+    memcpy(birthLog.map + birthLog.mapUsed, p, k);
+    birthLog.mapUsed += k;
+    p += k;
+    n -= k;
+  }
+}
+
+/**
+ * Copy a worker's batch of births into the log
+ *
+ * @param w Worker
+ */
+static void flushBirths(struct Worker *const w)
+{
+  uint8_t rec[BIRTH_RECORD_BYTES];
+  uintptr_t i;
+
+#if (PARALLEL_THREADS > 0)
+  pthread_mutex_lock(&birthLog.lock);
+#endif
+  for(i=0;i<w->birthCount;++i) {
+    const struct BirthRecord *const b = &w->births[i];
+    putLe(rec, b->id, 8);
+    putLe(rec + 8, b->parentId, 8);
+    putLe(rec + 16, b->lineage, 8);
+    putLe(rec + 24, b->clock, 8);
+    putLe(rec + 32, b->genomeHash, 8);
+    putLe(rec + 40, b->generation, 4);
+    putLe(rec + 44, b->x, 2);
+    putLe(rec + 46, b->y, 2);
+    birthLogWrite(rec, BIRTH_RECORD_BYTES);
+  }
+#if (PARALLEL_THREADS > 0)
+  pthread_mutex_unlock(&birthLog.lock);
+#endif
+  w->birthCount = 0;
+}
+
+/**
+ * Note a birth, called once the offspring has been placed
+ *
+ * @param w Worker
+ * @param c Offspring
+ */
+static inline void logBirth(struct Worker *const w, const uintptr_t c)
+{
+  struct BirthRecord *const b = &w->births[w->birthCount];
+  b->id = CELL_ID(c);
+  b->parentId = CELL_PARENT_ID(c);
+  b->lineage = CELL_LINEAGE(c);
+  b->clock = birthClock;
+  b->genomeHash = CELL_GENOME_HASH(c);
+  b->generation = (uint32_t)CELL_GENERATION(c);
+  b->x = (uint16_t)cellX(c);
+  b->y = (uint16_t)cellY(c);
+  if (++w->birthCount == BIRTH_LOG_BATCH)
+    flushBirths(w);
+}
+
+/**
+ * Start the log of a pond, named after the clock it starts at
+ *
+ * @param clock Starting clock
+ * @return 0 on success, 1 on failure
+ */
+static int openBirthLog(const uint64_t clock)
+{
+  char path[sizeof(config.outputPrefix) + 48];
+  uint8_t h[BIRTH_HEADER_BYTES];
+  uintptr_t i;
+  void *m;
+
+  for(i=0;i<NUM_WORKERS;++i)
+    workers[i].birthCount = 0;
+  snprintf(path, sizeof(path), "%s%ju.births.bin", config.outputPrefix, (uintmax_t)clock);
+  birthLog.fd = open(path, O_RDWR|O_CREAT|O_TRUNC, 0644);
+  m = MAP_FAILED;
+  if ((birthLog.fd >= 0)&&(!ftruncate(birthLog.fd, BIRTH_LOG_CHUNK)))
+    m = mmap((void *)0, BIRTH_LOG_CHUNK, PROT_READ|PROT_WRITE, MAP_SHARED, birthLog.fd, 0);
+  if (m == MAP_FAILED) {
+    fprintf(stderr,"*** Unable to create the birth log %s ***\n", path);
+    if (birthLog.fd >= 0)
+      close(birthLog.fd);
+    birthLog.fd = -1;
+    return 1;
+  }
+  birthLog.map = (uint8_t *)m;
+  birthLog.mapOffset = 0;
+  birthLog.mapUsed = 0;
+
+  memcpy(h, BIRTH_MAGIC, 8);
+  putLe(h + 8, BIRTH_VERSION, 4);
+  putLe(h + 12, BIRTH_RECORD_BYTES, 4);
+  putLe(h + 16, POND_SIZE_X, 4);
+  putLe(h + 20, POND_SIZE_Y, 4);
+  birthLogWrite(h, BIRTH_HEADER_BYTES);
+  fprintf(stderr,"[INFO] Logging births to %s\n", path);
+  return 0;
+}
+
+/**
+ * Write out the workers' last births and close the log (call while no
+ * workers are running)
+ */
+static void closeBirthLog()
+{
+  uintptr_t i;
+
+  for(i=0;i<NUM_WORKERS;++i)
+    flushBirths(&workers[i]);
+  if (birthLog.fd >= 0)
+    endBirthLog();
+}
+
+/**
+ * A birth in the phylogeny tool, see buildPhylogeny()
+ */
+struct PhyloNode
+{
+  uint64_t id;
+  uint64_t parentId;
+  const uint8_t *rec;
+  /* Index of the parent's node, or -1 if it is not in the logs */
+  intptr_t parent;
+  /* Tips at or below this node, and kept children not yet counted */
+  uint64_t tips;
+  uint64_t pending;
+  int kept;
+};
+
+/**
+ * Order nodes by ID
+ */
+static int comparePhyloNodes(const void *a, const void *b)
+{
+  const uint64_t x = ((const struct PhyloNode *)a)->id, y = ((const struct PhyloNode *)b)->id;
+  return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+/**
+ * Find a node by ID
+ *
+ * @param nodes Nodes sorted by ID
+ * @param n Number of nodes
+ * @param id ID
+ * @return Index of the node, or -1 if there is none
+ */
+static intptr_t findPhyloNode(const struct PhyloNode *const nodes, const uintptr_t n, const uint64_t id)
+{
+  uintptr_t lo = 0, hi = n, mid;
+  while (lo < hi) {
+    mid = lo + ((hi - lo) >> 1);
+    if (nodes[mid].id < id)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return ((lo < n)&&(nodes[lo].id == id)) ? (intptr_t)lo : -1;
+}
+
+/**
+ * Build the phylogenetic tree of a set of cells from birth logs, and
+ * write it as CSV on standard output
+ *
+ * The tips are the cells in a CSV dump (its first column is the cell
+ * ID), or every logged birth if the dump is given as "-". The tree is
+ * pruned to the tips and their ancestors, so lines that died out are
+ * left out. Each line is a birth: ID, parent ID, lineage, clock,
+ * generation, X, Y, genome hash (hex), children kept and tips at or
+ * below it, parents before children. Parents that are not in the logs
+ * (inflow cells, or births from before the log started) are the roots.
+ * A birth that is in more than one log (after resuming a checkpoint)
+ * is only kept once.
+ *
+ * @param dumpPath CSV dump, or "-"
+ * @param paths Birth logs
+ * @param count Number of birth logs
+ * @return 0 on success, nonzero on error (with a message printed)
+ */
+static int buildPhylogeny(const char *dumpPath, char **paths, const uintptr_t count)
+{
+  struct PhyloNode *nodes = (struct PhyloNode *)0, *p;
+  uintptr_t n = 0, capacity = 0, i, k, *order;
+  intptr_t j;
+  const uint8_t *data, *rec;
+  uint64_t records, kept = 0;
+  struct stat st;
+  char line[POND_DEPTH + 256];
+  unsigned long long id;
+  int fd;
+  FILE *f;
+
+  for(i=0;i<count;++i) {
+    fd = open(paths[i], O_RDONLY);
+    if ((fd < 0)||(fstat(fd, &st))||(st.st_size < BIRTH_HEADER_BYTES)) {
+      fprintf(stderr,"*** Unable to read birth log %s ***\n", paths[i]);
+      return 1;
+    }
+    data = (const uint8_t *)mmap((void *)0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if ((void *)data == MAP_FAILED) {
+      fprintf(stderr,"*** Unable to read birth log %s ***\n", paths[i]);
+      return 1;
+    }
+    if ((memcmp(data, BIRTH_MAGIC, 8))||(getLe(data + 8, 4) != BIRTH_VERSION)||(getLe(data + 12, 4) != BIRTH_RECORD_BYTES)) {
+      fprintf(stderr,"*** %s is not a birth log ***\n", paths[i]);
+      return 1;
+    }
+    /* (The mapping is left in place: the nodes point into it) */
+    records = ((uint64_t)st.st_size - BIRTH_HEADER_BYTES) / BIRTH_RECORD_BYTES;
+    for(k=0,rec=data+BIRTH_HEADER_BYTES;k<records;++k,rec+=BIRTH_RECORD_BYTES) {
+      if (n == capacity) {
+        capacity = capacity ? (capacity << 1) : 65536;
+        p = (struct PhyloNode *)realloc(nodes, capacity * sizeof(struct PhyloNode));
+        if (!p) {
+          fprintf(stderr,"*** Unable to allocate memory ***\n");
+          free(nodes);
+          return 1;
+        }
+        nodes = p;
+      }
+      nodes[n].id = getLe(rec, 8);
+      nodes[n].parentId = getLe(rec + 8, 8);
+      nodes[n].rec = rec;
+      nodes[n].tips = 0;
+      nodes[n].pending = 0;
+      nodes[n].kept = 0;
+      ++n;
+    }
+  }
+
+  /* Sort by ID and drop births logged twice */
+  qsort(nodes, n, sizeof(struct PhyloNode), comparePhyloNodes);
+  for(i=0,k=0;i<n;++i) {
+    if ((k)&&(nodes[k-1].id == nodes[i].id))
+      continue;
+    nodes[k++] = nodes[i];
+  }
+  n = k;
+  for(i=0;i<n;++i)
+    nodes[i].parent = findPhyloNode(nodes, n, nodes[i].parentId);
+
+  /* Mark the tips */
+  if (strcmp(dumpPath, "-")) {
+    f = fopen(dumpPath, "r");
+    if (!f) {
+      fprintf(stderr,"*** Unable to open dump %s ***\n", dumpPath);
+      free(nodes);
+      return 1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+      if ((sscanf(line, "%llu", &id) == 1)&&((j = findPhyloNode(nodes, n, (uint64_t)id)) >= 0))
+        nodes[j].tips = 1;
+    }
+    fclose(f);
+  } else {
+    for(i=0;i<n;++i)
+      nodes[i].tips = 1;
+  }
+
+  /* Keep the tips and their ancestors, counting the kept children */
+  for(i=0;i<n;++i) {
+    if (!nodes[i].tips)
+      continue;
+    for(j=(intptr_t)i;(j>=0)&&(!nodes[j].kept);j=nodes[j].parent) {
+      nodes[j].kept = 1;
+      ++kept;
+      if (nodes[j].parent >= 0)
+        ++nodes[nodes[j].parent].pending;
+    }
+  }
+
+  /* Add up the tips from the leaves up: a node is done once all its
+   * kept children are, which also gives children before parents */
+  order = (uintptr_t *)malloc((size_t)(kept ? kept : 1) * sizeof(uintptr_t));
+  if (!order) {
+    fprintf(stderr,"*** Unable to allocate memory ***\n");
+    free(nodes);
+    return 1;
+  }
+  for(i=0,k=0;i<n;++i) {
+    if ((nodes[i].kept)&&(!nodes[i].pending))
+      order[k++] = i;
+  }
+  for(i=0;i<k;++i) {
+    j = nodes[order[i]].parent;
+    if (j >= 0) {
+      nodes[j].tips += nodes[order[i]].tips;
+      if (!--nodes[j].pending)
+        order[k++] = (uintptr_t)j;
+    }
+  }
+
+  /* pending is free again, and now counts the kept children */
+  for(i=0;i<k;++i) {
+    if (nodes[order[i]].parent >= 0)
+      ++nodes[nodes[order[i]].parent].pending;
+  }
+  fprintf(stdout,"id,parent,lineage,clock,generation,x,y,genome_hash,children,tips\n");
+  while (k--) {
+    const struct PhyloNode *const d = &nodes[order[k]];
+    rec = d->rec;
+    fprintf(stdout,"%ju,%ju,%ju,%ju,%ju,%ju,%ju,%016jx,%ju,%ju\n",
+      (uintmax_t)d->id,
+      (uintmax_t)d->parentId,
+      (uintmax_t)getLe(rec + 16, 8),
+      (uintmax_t)getLe(rec + 24, 8),
+      (uintmax_t)getLe(rec + 40, 4),
+      (uintmax_t)getLe(rec + 44, 2),
+      (uintmax_t)getLe(rec + 46, 2),
+      (uintmax_t)getLe(rec + 32, 8),
+      (uintmax_t)d->pending,
+      (uintmax_t)d->tips);
+  }
+  fprintf(stderr,"[INFO] %ju births, %ju kept\n", (uintmax_t)n, (uintmax_t)kept);
+
+  free(order);
+  free(nodes);
+  return 0;
+}
+
+#endif /* BIRTH_LOG */
+
+#if EXEC_TRACE
+
+/* ----------------------------------------------------------------------- */
+/* Execution traces                                                        */
+/* ----------------------------------------------------------------------- */
+
+/*
+ * The trace file starts with a header of TRACE_HEADER_BYTES followed by
+ * records of TRACE_RECORD_BYTES, all integers little-endian: the genome
+ * hash at the start of the execution, the cell's ID, its lineage and the
+ * clock (uint64), its generation, the instructions run, the LOOPs
+ * entered, repeated and skipped (uint32), the reads and then the writes
+ * of each memory bank (TRACE_BANKS uint32 each), the outcome (see
+ * TRACE_STOPPED), 1 if it reproduced (uint8), the number of steps
+ * recorded (uint16) and then EXEC_TRACE_STEPS steps (uint16, position <<
+ * INST_BITS | instruction). With PARALLEL_THREADS the clock is that of
+ * the epoch, and records are in no particular order.
+ */
+
+#define TRACE_MAGIC "NPONDTRC"
+#define TRACE_VERSION 1
+
+/* Magic, version, record bytes, EXEC_TRACE_STEPS, INST_BITS,
+ * EXEC_TRACE_SAMPLE, POND_DEPTH (uint32) */
+#define TRACE_HEADER_BYTES 32
+
+/* Offset of the first step in a record, and the size of a record */
+#define TRACE_STEPS_OFFSET (56 + (8 * TRACE_BANKS))
+#define TRACE_RECORD_BYTES (TRACE_STEPS_OFFSET + (2 * EXEC_TRACE_STEPS))
+
+/* Hot positions listed for each genome by replayTraces() */
+#define TRACE_HOT_POSITIONS 8
+
+static const char *const traceBankName[TRACE_BANKS] = { "special", "private", "public", "neighbor" };
+
+/* The trace file being written, or NULL */
+static POND_STATE FILE *traceLog = (FILE *)0;
+
+/* Traces overwritten in the rings before they could be written out */
+static POND_STATE uint64_t traceDropped = 0;
+
+/* Clock of the current tick (or epoch), set by doHousekeeping() */
+static POND_STATE uint64_t traceClock = 0;
+
+/**
+ * Start the trace of an execution in the next slot of a worker's ring
+ *
+ * @param w Worker
+ * @param c Cell about to be executed
+ * @return Trace to fill in
+ */
+static inline struct TraceRecord *startTrace(struct Worker *const w, const uintptr_t c)
+{
+  struct TraceRecord *const t = &w->traces[w->traceCount++ % EXEC_TRACE_RING];
+  memset(t, 0, offsetof(struct TraceRecord, steps));
+  t->genomeHash = CELL_GENOME_HASH(c);
+  t->id = CELL_ID(c);
+  t->lineage = CELL_LINEAGE(c);
+  t->clock = traceClock;
+  t->generation = (uint32_t)CELL_GENERATION(c);
+  t->outcome = TRACE_EXHAUSTED;
+  return t;
+}
+
+/**
+ * Note an instruction run in a trace
+ *
+ * @param t Trace
+ * @param instPtr Position of the instruction
+ * @param inst Instruction (after any mutation)
+ */
+static inline void traceStep(struct TraceRecord *const t, const uintptr_t instPtr, const uintptr_t inst)
+{
+  if (t->stepCount < EXEC_TRACE_STEPS)
+    t->steps[t->stepCount++] = (uint16_t)((instPtr << INST_BITS) | inst);
+  ++t->instructions;
+}
+
+/**
+ * Write the traces in the workers' rings to the trace file and empty
+ * the rings (call while no workers are running)
+ */
+static void flushTraces()
+{
+  uint8_t rec[TRACE_RECORD_BYTES];
+  uint64_t k, n;
+  uintptr_t i, b;
+
+  for(i=0;i<NUM_WORKERS;++i) {
+    struct Worker *const w = &workers[i];
+    n = (w->traceCount < EXEC_TRACE_RING) ? w->traceCount : EXEC_TRACE_RING;
+    traceDropped += w->traceCount - n;
+    /* Oldest first, which is the slot after the newest once it wrapped */
+    for(k=w->traceCount-n;(traceLog)&&(k<w->traceCount);++k) {
+      const struct TraceRecord *const t = &w->traces[k % EXEC_TRACE_RING];
+      memset(rec, 0, sizeof(rec));
+      putLe(rec, t->genomeHash, 8);
+      putLe(rec + 8, t->id, 8);
+      putLe(rec + 16, t->lineage, 8);
+      putLe(rec + 24, t->clock, 8);
+      putLe(rec + 32, t->generation, 4);
+      putLe(rec + 36, t->instructions, 4);
+      putLe(rec + 40, t->loopEntries, 4);
+      putLe(rec + 44, t->loopRepeats, 4);
+      putLe(rec + 48, t->loopSkips, 4);
+      for(b=0;b<TRACE_BANKS;++b) {
+        putLe(rec + 52 + (4 * b), t->memReads[b], 4);
+        putLe(rec + 52 + (4 * (TRACE_BANKS + b)), t->memWrites[b], 4);
+      }
+      rec[TRACE_STEPS_OFFSET - 4] = t->outcome;
+      rec[TRACE_STEPS_OFFSET - 3] = t->reproduced;
+      putLe(rec + TRACE_STEPS_OFFSET - 2, t->stepCount, 2);
+      for(b=0;b<t->stepCount;++b)
+        putLe(rec + TRACE_STEPS_OFFSET + (2 * b), t->steps[b], 2);
+      if (fwrite(rec, TRACE_RECORD_BYTES, 1, traceLog) != 1) {
+        fprintf(stderr,"[WARNING] Could not write the trace file, no more traces will be written.\n");
+        fclose(traceLog);
+        traceLog = (FILE *)0;
+      }
+    }
+    w->traceCount = 0;
+  }
+}
+
+/**
+ * Start the trace file of a pond, named after the clock it starts at
+ *
+ * @param clock Starting clock
+ * @return 0 on success, 1 on failure
+ */
+static int openTraceLog(const uint64_t clock)
+{
+  char path[sizeof(config.outputPrefix) + 48];
+  uint8_t h[TRACE_HEADER_BYTES];
+  uintptr_t i;
+
+  for(i=0;i<NUM_WORKERS;++i) {
+    workers[i].trace = (struct TraceRecord *)0;
+    workers[i].traceCountdown = EXEC_TRACE_SAMPLE;
+    workers[i].traceCount = 0;
+  }
+  traceDropped = 0;
+  snprintf(path, sizeof(path), "%s%ju.trace.bin", config.outputPrefix, (uintmax_t)clock);
+  traceLog = fopen(path, "wb");
+  if (!traceLog) {
+    fprintf(stderr,"*** Unable to create the trace file %s ***\n", path);
+    return 1;
+  }
+
+  memcpy(h, TRACE_MAGIC, 8);
+  putLe(h + 8, TRACE_VERSION, 4);
+  putLe(h + 12, TRACE_RECORD_BYTES, 4);
+  putLe(h + 16, EXEC_TRACE_STEPS, 4);
+  putLe(h + 20, INST_BITS, 4);
+  putLe(h + 24, EXEC_TRACE_SAMPLE, 4);
+  putLe(h + 28, POND_DEPTH, 4);
+  if (fwrite(h, TRACE_HEADER_BYTES, 1, traceLog) != 1) {
+    fprintf(stderr,"*** Unable to write the trace file %s ***\n", path);
+    fclose(traceLog);
+    traceLog = (FILE *)0;
+    return 1;
+  }
+  fprintf(stderr,"[INFO] Tracing one in %u executions to %s\n", (unsigned int)EXEC_TRACE_SAMPLE, path);
+  return 0;
+}
+
+/**
+ * Write out the workers' last traces and close the trace file (call
+ * while no workers are running)
+ */
+static void closeTraceLog()
+{
+  flushTraces();
+  if (traceLog) {
+    fclose(traceLog);
+    traceLog = (FILE *)0;
+  }
+  if (traceDropped)
+    fprintf(stderr,"[WARNING] %ju traces were overwritten before they were written out (raise EXEC_TRACE_RING)\n", (uintmax_t)traceDropped);
+}
+
+/**
+ * What the traces of one genome add up to, see replayTraces()
+ */
+struct TraceGenome
+{
+  uint64_t genomeHash;
+  uint64_t executions;
+  uint64_t instructions;
+  uint64_t outcomes[3];
+  uint64_t reproduced;
+  uint64_t loops[3];
+  uint64_t memReads[TRACE_BANKS];
+  uint64_t memWrites[TRACE_BANKS];
+  /* Instruction last seen at each position run, '.' for the others */
+  char path[POND_DEPTH + 1];
+  char hot[TRACE_HOT_POSITIONS * 24];
+};
+
+/**
+ * Order trace records by genome hash
+ */
+static int compareTraceRecords(const void *a, const void *b)
+{
+  const uint64_t x = getLe(*(const uint8_t *const *)a, 8), y = getLe(*(const uint8_t *const *)b, 8);
+  return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+/**
+ * Order genomes by instructions run, most first
+ */
+static int compareTraceGenomes(const void *a, const void *b)
+{
+  const uint64_t x = ((const struct TraceGenome *)a)->instructions, y = ((const struct TraceGenome *)b)->instructions;
+  return (x > y) ? -1 : ((x < y) ? 1 : 0);
+}
+
+/**
+ * Rebuild the hot paths of each genome from trace files, and write them
+ * as CSV on standard output
+ *
+ * Each line is a genome (by its hash), hottest first: the number of
+ * traced executions and the instructions they ran, how many ended on
+ * STOP, on running out of energy and on a loop stack overflow, how many
+ * reproduced, the LOOPs entered, repeated and skipped, the reads and
+ * writes of each memory bank, the path (the genome as far as it was run,
+ * with '.' for positions never run) and its hottest positions as
+ * position:instruction:count. Positions are counted over the recorded
+ * steps, so only the first EXEC_TRACE_STEPS of each execution.
+ *
+ * @param paths Trace files
+ * @param count Number of trace files
+ * @return 0 on success, nonzero on error (with a message printed)
+ */
+static int replayTraces(char **paths, const uintptr_t count)
+{
+  const uint8_t **recs = (const uint8_t **)0, **p, *data, *rec;
+  struct TraceGenome *genomes, *g;
+  uint64_t hits[POND_DEPTH], records, best;
+  uintptr_t n = 0, capacity = 0, genomeCount = 0, i, j, k, b, s, pos, end, used;
+  struct stat st;
+  int fd;
+
+  for(i=0;i<count;++i) {
+    fd = open(paths[i], O_RDONLY);
+    if ((fd < 0)||(fstat(fd, &st))||(st.st_size < TRACE_HEADER_BYTES)) {
+      fprintf(stderr,"*** Unable to read trace file %s ***\n", paths[i]);
+      return 1;
+    }
+    data = (const uint8_t *)mmap((void *)0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if ((void *)data == MAP_FAILED) {
+      fprintf(stderr,"*** Unable to read trace file %s ***\n", paths[i]);
+      return 1;
+    }
+    if ((memcmp(data, TRACE_MAGIC, 8))||(getLe(data + 8, 4) != TRACE_VERSION)||(getLe(data + 12, 4) != TRACE_RECORD_BYTES)||(getLe(data + 20, 4) != INST_BITS)||(getLe(data + 28, 4) != POND_DEPTH)) {
+      fprintf(stderr,"*** %s is not a trace file of this build ***\n", paths[i]);
+      return 1;
+    }
+    /* (The mapping is left in place: recs point into it) */
+    records = ((uint64_t)st.st_size - TRACE_HEADER_BYTES) / TRACE_RECORD_BYTES;
+    for(k=0,rec=data+TRACE_HEADER_BYTES;k<records;++k,rec+=TRACE_RECORD_BYTES) {
+      if (n == capacity) {
+        capacity = capacity ? (capacity << 1) : 65536;
+        p = (const uint8_t **)realloc((void *)recs, capacity * sizeof(const uint8_t *));
+        if (!p) {
+          fprintf(stderr,"*** Unable to allocate memory ***\n");
+          free((void *)recs);
+          return 1;
+        }
+        recs = p;
+      }
+      recs[n++] = rec;
+    }
+  }
+
+  qsort((void *)recs, n, sizeof(const uint8_t *), compareTraceRecords);
+  genomes = (struct TraceGenome *)malloc((n ? n : 1) * sizeof(struct TraceGenome));
+  if (!genomes) {
+    fprintf(stderr,"*** Unable to allocate memory ***\n");
+    free((void *)recs);
+    return 1;
+  }
+
+  /* Add up each run of records with the same genome hash */
+  for(i=0;i<n;i=j) {
+    g = &genomes[genomeCount++];
+    memset(g, 0, sizeof(struct TraceGenome));
+    memset(hits, 0, sizeof(hits));
+    memset(g->path, '.', POND_DEPTH);
+    g->genomeHash = getLe(recs[i], 8);
+    end = 0;
+    for(j=i;(j<n)&&(getLe(recs[j], 8) == g->genomeHash);++j) {
+      rec = recs[j];
+      ++g->executions;
+      g->instructions += getLe(rec + 36, 4);
+      for(k=0;k<3;++k)
+        g->loops[k] += getLe(rec + 40 + (4 * k), 4);
+      for(b=0;b<TRACE_BANKS;++b) {
+        g->memReads[b] += getLe(rec + 52 + (4 * b), 4);
+        g->memWrites[b] += getLe(rec + 52 + (4 * (TRACE_BANKS + b)), 4);
+      }
+      if (rec[TRACE_STEPS_OFFSET - 4] < 3)
+        ++g->outcomes[rec[TRACE_STEPS_OFFSET - 4]];
+      g->reproduced += rec[TRACE_STEPS_OFFSET - 3] ? 1 : 0;
+      s = (uintptr_t)getLe(rec + TRACE_STEPS_OFFSET - 2, 2);
+      for(k=0;(k<s)&&(k<EXEC_TRACE_STEPS);++k) {
+        const uintptr_t step = (uintptr_t)getLe(rec + TRACE_STEPS_OFFSET + (2 * k), 2);
+        pos = step >> INST_BITS;
+        if (pos >= POND_DEPTH)
+          continue;
+        ++hits[pos];
+        g->path[pos] = inst_chars[step & INST_MASK];
+        if (pos >= end)
+          end = pos + 1;
+      }
+    }
+    g->path[end] = (char)0;
+
+    /* Pick the hottest positions, taking each out as it is listed */
+    used = 0;
+    for(k=0;k<TRACE_HOT_POSITIONS;++k) {
+      best = 0;
+      pos = 0;
+      for(s=0;s<end;++s) {
+        if (hits[s] > best) {
+          best = hits[s];
+          pos = s;
+        }
+      }
+      if (!best)
+        break;
+      used += (uintptr_t)snprintf(g->hot + used, sizeof(g->hot) - used, "%s%ju:%c:%ju", k ? " " : "", (uintmax_t)pos, g->path[pos], (uintmax_t)best);
+      if (used >= sizeof(g->hot))
+        break;
+      hits[pos] = 0;
+    }
+  }
+  qsort(genomes, genomeCount, sizeof(struct TraceGenome), compareTraceGenomes);
+
+  fprintf(stdout,"genome_hash,executions,instructions,instructions_per_execution,stopped,exhausted,overflowed,reproduced,loop_entries,loop_repeats,loop_skips");
+  for(b=0;b<TRACE_BANKS;++b)
+    fprintf(stdout,",reads_%s", traceBankName[b]);
+  for(b=0;b<TRACE_BANKS;++b)
+    fprintf(stdout,",writes_%s", traceBankName[b]);
+  fprintf(stdout,",path,hot\n");
+  for(i=0;i<genomeCount;++i) {
+    g = &genomes[i];
+    fprintf(stdout,"%016jx,%ju,%ju,%.1f,%ju,%ju,%ju,%ju,%ju,%ju,%ju",
+      (uintmax_t)g->genomeHash,
+      (uintmax_t)g->executions,
+      (uintmax_t)g->instructions,
+      (double)g->instructions / (double)g->executions,
+      (uintmax_t)g->outcomes[TRACE_STOPPED],
+      (uintmax_t)g->outcomes[TRACE_EXHAUSTED],
+      (uintmax_t)g->outcomes[TRACE_OVERFLOW],
+      (uintmax_t)g->reproduced,
+      (uintmax_t)g->loops[0],
+      (uintmax_t)g->loops[1],
+      (uintmax_t)g->loops[2]);
+    for(b=0;b<TRACE_BANKS;++b)
+      fprintf(stdout,",%ju", (uintmax_t)g->memReads[b]);
+    for(b=0;b<TRACE_BANKS;++b)
+      fprintf(stdout,",%ju", (uintmax_t)g->memWrites[b]);
+    fprintf(stdout,",%s,%s\n", g->path, g->hot);
+  }
+  fprintf(stderr,"[INFO] %ju traces of %ju genomes\n", (uintmax_t)n, (uintmax_t)genomeCount);
+
+  free(genomes);
+  free((void *)recs);
+  return 0;
+}
+
+#endif /* EXEC_TRACE */
+
+  
+/**
+ * Get a neighbor in the pond by switching on the direction
+ *
+ * @param x Starting X position
+ * @param y Starting Y position
+ * @param dir Direction to get neighbor from
+ * @param dirs Number of directions (4, 6 or 8), a constant in callers
+ * @return Index of neighboring cell
+ */
+/* Power of two sizes wrap with a mask instead of a compare */
+#if ((POND_SIZE_X & (POND_SIZE_X - 1)) == 0)
+#define X_EAST  (x+1) & (POND_SIZE_X-1)
+#define X_WEST  (x-1) & (POND_SIZE_X-1)
+#else
+#define X_EAST  x < (POND_SIZE_X-1) ? x+1 : 0
+#define X_WEST  x ? x-1 : POND_SIZE_X-1
+#endif
+#define X_NONE  x
+#if ((POND_SIZE_Y & (POND_SIZE_Y - 1)) == 0)
+#define Y_SOUTH (y+1) & (POND_SIZE_Y-1)
+#define Y_NORTH (y-1) & (POND_SIZE_Y-1)
+#else
+#define Y_SOUTH y < (POND_SIZE_Y-1) ? y+1 : 0
+#define Y_NORTH y ? y-1 : POND_SIZE_Y-1
+#endif
+#define Y_NONE  y
+static inline VM_SPECIALIZED uintptr_t getNeighborSwitch(const uintptr_t x, const uintptr_t y, const uintptr_t dir, const uintptr_t dirs)
+{
+    /* Space is toroidal; it wraps at edges */
+
+    if (dirs == 4) {
+        switch(dir & 0x3) {
+            case DIR4_NORTH:
+                return cellIndex(X_NONE, Y_NORTH);
+            case DIR4_EAST:
+                return cellIndex(X_EAST, Y_NONE);
+            case DIR4_SOUTH:
+                return cellIndex(X_NONE, Y_SOUTH);
+            case DIR4_WEST:
+                return cellIndex(X_WEST, Y_NONE);
+        }
+    } else if (dirs == 6) {
+        if (y & 1) {
+            switch(dirmap[dir]) {
+                case DIR6_0:
+                    return cellIndex(X_EAST, Y_NORTH);
+                case DIR6_1:
+                    return cellIndex(X_EAST, Y_NONE);
+                case DIR6_2:
+                    return cellIndex(X_EAST, Y_SOUTH);
+                case DIR6_3:
+                    return cellIndex(X_NONE, Y_SOUTH);
+                case DIR6_4:
+                    return cellIndex(X_WEST, Y_NONE);
+                case DIR6_5:
+                    return cellIndex(X_NONE, Y_NORTH);
+            }
+        }
+        else {
+            switch(dirmap[dir]) {
+                case DIR6_0:
+                    return cellIndex(X_NONE, Y_NORTH);
+                case DIR6_1:
+                    return cellIndex(X_EAST, Y_NONE);
+                case DIR6_2:
+                    return cellIndex(X_NONE, Y_SOUTH);
+                case DIR6_3:
+                    return cellIndex(X_WEST, Y_SOUTH);
+                case DIR6_4:
+                    return cellIndex(X_WEST, Y_NONE);
+                case DIR6_5:
+                    return cellIndex(X_WEST, Y_NORTH);
+            }
+        }
+    } else {
+        switch(dir & 0x7) {
+            case DIR8_NORTH:
+                return cellIndex(X_NONE, Y_NORTH);
+            case DIR8_NE:
+                return cellIndex(X_EAST, Y_NORTH);
+            case DIR8_EAST:
+                return cellIndex(X_EAST, Y_NONE);
+            case DIR8_SE:
+                return cellIndex(X_EAST, Y_SOUTH);
+            case DIR8_SOUTH:
+                return cellIndex(X_NONE, Y_SOUTH);
+            case DIR8_SW:
+                return cellIndex(X_WEST, Y_SOUTH);
+            case DIR8_WEST:
+                return cellIndex(X_WEST, Y_NONE);
+            case DIR8_NW:
+                return cellIndex(X_WEST, Y_NORTH);
+        }
+    }
+    return cellIndex(X_NONE, Y_NONE); /* This should never be reached */
+}
+#undef X_EAST
+#undef X_WEST
+#undef X_NONE
+#undef Y_SOUTH
+#undef Y_NORTH
+#undef Y_NONE
+
+#if NEIGHBOR_TABLES
+
+/* wrapX[x + 1] is x wrapped into the pond, for x from -1 to POND_SIZE_X */
+static uint32_t wrapX[POND_SIZE_X + 2];
+static uint32_t wrapY[POND_SIZE_Y + 2];
+
+/* Offset plus one of the neighbor in each facing, by direction count
+ * (see DIR_SET) and row parity */
+static uint8_t neighborDx[DIR_SETS][2][NUM_INST];
+static uint8_t neighborDy[DIR_SETS][2][NUM_INST];
+
+/* Neighbor offsets (x, y) for each direction, by direction count and row
+ * parity; only the hex grid is different on odd rows */
+static const int8_t dirOffsets[DIR_SETS][2][8][2] = {
+  {
+    { { 0,-1 }, { 1, 0 }, { 0, 1 }, {-1, 0 } },
+    { { 0,-1 }, { 1, 0 }, { 0, 1 }, {-1, 0 } }
+  },
+  {
+    { { 0,-1 }, { 1, 0 }, { 0, 1 }, {-1, 1 }, {-1, 0 }, {-1,-1 } },
+    { { 1,-1 }, { 1, 0 }, { 1, 1 }, { 0, 1 }, {-1, 0 }, { 0,-1 } }
+  },
+  {
+    { { 0,-1 }, { 1,-1 }, { 1, 0 }, { 1, 1 }, { 0, 1 }, {-1, 1 }, {-1, 0 }, {-1,-1 } },
+    { { 0,-1 }, { 1,-1 }, { 1, 0 }, { 1, 1 }, { 0, 1 }, {-1, 1 }, {-1, 0 }, {-1,-1 } }
+  }
+};
+
+/**
+ * Build the neighbor lookup tables
+ */
+static void initNeighborTables()
+{
+  uintptr_t i, s, p, dir, d;
+  for(i=0;i<(POND_SIZE_X + 2);++i)
+    wrapX[i] = (uint32_t)((i + POND_SIZE_X - 1) % POND_SIZE_X);
+  for(i=0;i<(POND_SIZE_Y + 2);++i)
+    wrapY[i] = (uint32_t)((i + POND_SIZE_Y - 1) % POND_SIZE_Y);
+  for(s=0;s<DIR_SETS;++s) {
+    for(p=0;p<2;++p) {
+      for(dir=0;dir<NUM_INST;++dir) {
+        if (s == DIR_SET(4))
+          d = dir & 0x3;
+        else if (s == DIR_SET(6))
+          d = dirmap[dir];
+        else d = dir & 0x7;
+        neighborDx[s][p][dir] = (uint8_t)(dirOffsets[s][p][d][0] + 1);
+        neighborDy[s][p][dir] = (uint8_t)(dirOffsets[s][p][d][1] + 1);
+      }
+    }
+  }
+}
+
+#endif /* NEIGHBOR_TABLES */
+
+/**
+ * Get a neighbor in the pond
+ *
+ * @param x Starting X position
+ * @param y Starting Y position
+ * @param dir Direction to get neighbor from (a facing)
+ * @param dirs Number of directions (4, 6 or 8), a constant in callers
+ * @return Index of neighboring cell
+ */
+static inline VM_SPECIALIZED uintptr_t getNeighbor(const uintptr_t x, const uintptr_t y, const uintptr_t dir, const uintptr_t dirs)
+{
+#if NEIGHBOR_TABLES
+    const uintptr_t p = (dirs == 6) ? (y & 1) : 0;
+    return cellIndex(wrapX[x + neighborDx[DIR_SET(dirs)][p][dir & FACING_MASK]], wrapY[y + neighborDy[DIR_SET(dirs)][p][dir & FACING_MASK]]);
+#else
+    return getNeighborSwitch(x, y, dir, dirs);
+#endif
+}
+
+/**
+ * Determines if c1 is allowed to access c2
+ *
+ * @param w Worker (for its random number generator)
+ * @param c2 Cell being accessed
+ * @param c1guess c1's "guess"
+ * @param sense The "sense" of this interaction
+ * @return True or false (1 or 0)
+ */
+static inline int accessAllowed(struct Worker *const w,const uintptr_t c2,const uintptr_t c1guess,int sense)
+{
+  /* Access permission is more probable if they are more similar in sense 0,
+   * and more probable if they are different in sense 1. Sense 0 is used for
+   * "negative" interactions and sense 1 for "positive" ones. */
+  return sense ?
+      (((getRandom(w->rng) & 0xf) >= BITS_IN_FIVEBIT_WORD[(CELL_LOGO(c2) ^ c1guess) & 0x1f]) || (!CELL_PARENT_ID(c2))) :
+      (((getRandom(w->rng) & 0xf) <= BITS_IN_FIVEBIT_WORD[(CELL_LOGO(c2) ^ c1guess) & 0x1f]) || (!CELL_PARENT_ID(c2)));
+}
+
+/**
+ * Gets the color that a cell should be
+ *
+ * @param c Cell to get color for
+ * @return 8-bit color value
+ */
+static inline uint8_t getColor(const uintptr_t c)
+{
+  uintptr_t i, sum; /* inst, stopCount, skipnext; */
+
+  if (CELL_ENERGY(c)) {
+    switch(colorScheme) {
+      case KINSHIP:
+        /*
+         * Kinship color scheme by Christoph Groth
+         *
+         * For cells of generation > 1, saturation and value are set to maximum.
+         * Hue is a hash-value with the property that related genomes will have
+         * similar hue (but of course, as this is a hash function, totally
+         * different genomes can also have a similar or even the same hue).
+         * Therefore the difference in hue should to some extent reflect the grade
+         * of "kinship" of two cells.
+         */
+        if (CELL_GENERATION(c) > 1) {
+#if GENOME_HASH_CACHE
+          sum = CELL_KIN_SUM(c);
+#elif GENOME_PACKED
+          {
+            uint8_t g[POND_DEPTH];
+            genomeUnpack(CELL_GENOME_WORDS(c), g);
+            sum = kernels.genomeSum(g);
+          }
+#else
+          sum = kernels.genomeSum(CELL_GENOME(c));
+#if 0
+          skipnext = 0;
+          stopCount = 0;
+          for(i = 0; i < POND_DEPTH; ++i) {
+              inst = GENOME_AT(c, i);
+
+              if (skipnext) {
+                  skipnext = 0;
+              }
+              else {
+                  if (inst != OP_STOP) {
+                      sum += inst;
+                  }
+
+                  if (inst == OP_STOP) { /* STOP */
+                      if (++stopCount >= 4) {
+                          break;
+                      }
+                  }
+                  else {
+                      stopCount = 0;
+                      if (inst == 0xc) /* 0xc == XCHG */
+                          skipnext = 1; /* Skip "operand" after XCHG */
+                  }
+              }
+          }
+#endif
+#endif /* GENOME_HASH_CACHE */
+          /* For the hash-value use a wrapped around sum of the sum of all
+           * commands and the length of the genome. */
+          return (uint8_t)((sum % 192) + 64);
+        }
+        return 0;
+      case LINEAGE:
+        /*
+         * Cells with generation > 1 are color-coded by lineage.
+         */
+        return (CELL_GENERATION(c) > 1) ? (((uint8_t)CELL_LINEAGE(c)) | (uint8_t)1) : 0;
+      case LOGO:
+        return (CELL_GENERATION(c) > 1) ? (uint8_t)(73 + CELL_LOGO(c)) : 0;
+      case FACING:
+        return (CELL_GENERATION(c) > 1) ? (uint8_t)(157 + CELL_FACING(c)) : 0;
+      case ENERGY1:
+        return (CELL_GENERATION(c) > 1 && maxLivingCellEnergy > 0) ?
+            (uint8_t)(255.0 * ((double)CELL_ENERGY(c) / (double)maxLivingCellEnergy)) : 0;
+      case ENERGY2:
+        return (maxCellEnergy > 0) ?
+            (uint8_t)(255.0 * ((double)CELL_ENERGY(c) / (double)maxCellEnergy)) : 0;
+      case RAM0:
+        if (CELL_GENERATION(c) > 1) {
+          sum = 0;
+          for(i = 0; i < 8; ++i) {
+              sum += CELL_RAM(c)[i];
+          }
+          return (uint8_t)((sum & 0x7f) + 128);
+        }
+        return 0;
+      case RAM1:
+        if (CELL_GENERATION(c) > 1) {
           sum = 0;
           for(i = 0; i < 8; ++i) {
-              sum += c->ram[i];
+              sum += CELL_RAM(c)[8 + i];
           }
           return (uint8_t)((sum & 0x7f) + 128);
         }
-        return 0;
-      case RAM1:
-        if (c->generation > 1) {
-          sum = 0;
-          for(i = 0; i < 8; ++i) {
-              sum += c->ram[8 + i];
+        return 0;
+      case MAX_COLOR_SCHEME:
+        /* ... never used... to make compiler shut up. */
+        break;
+    }
+  }
+  return 0; /* Cells with no energy are black */
+}
+
+static inline VM_SPECIALIZED uint8_t read_mem(struct Worker *const w, const uintptr_t c, const uintptr_t x, const uintptr_t y, const uintptr_t ptr_mem, const uintptr_t dirs)
+{
+#if EXEC_TRACE
+    if (w->trace)
+        ++w->trace->memReads[ptr_mem >> 3];
+#endif
+    switch (ptr_mem) {
+        case 0x00: /* logo */
+            w->stats.memSpecialReads++;
+            return CELL_LOGO(c);
+        case 0x01: /* facing */
+            w->stats.memSpecialReads++;
+            return CELL_FACING(c);
+        case 0x02: /* energy */
+            w->stats.memSpecialReads++;
+            if (CELL_ENERGY(c) == 0)
+                return 0;
+            else if (CELL_ENERGY(c) > 126975)
+                return 31;
+            else
+                return 1 + (CELL_ENERGY(c) >> 12); 
+        case 0x03:
+            return CELL_LINEAGE(c) & REG_MASK;
+        case 0x04:
+            return CELL_ID(c) & REG_MASK;
+        case 0x05:
+            return CELL_PARENT_ID(c) & REG_MASK;
+        case 0x06:
+            return (CELL_GENERATION(c) >> REG_BITS) & REG_MASK;
+        case 0x07:
+            return CELL_GENERATION(c) & REG_MASK;
+            break;
+
+        case 0x08: /* private RAM */
+        case 0x09:
+        case 0x0a:
+        case 0x0b:
+        case 0x0c:
+        case 0x0d:
+        case 0x0e:
+        case 0x0f:
+            w->stats.memPrivateReads++;
+            return CELL_RAM(c)[ptr_mem & 0x7];
+
+        case 0x10: /* public RAM */
+        case 0x11:
+        case 0x12:
+        case 0x13:
+        case 0x14:
+        case 0x15:
+        case 0x16:
+        case 0x17:
+            w->stats.memOutputReads++;
+            return CELL_RAM(c)[8 + (ptr_mem & 0x7)];
+
+        case 0x18: /* neighbor (facing) public ram */
+        case 0x19:
+        case 0x1a:
+        case 0x1b:
+        case 0x1c:
+        case 0x1d:
+        case 0x1e:
+        case 0x1f:
+            {
+                w->stats.memInputReads++;
+                const uintptr_t tmpcell = getNeighbor(x, y, CELL_FACING(c), dirs);
+                return CELL_RAM(tmpcell)[8 + (ptr_mem & 0x7)];
+            }
+    }
+    return 0;
+}
+
+static inline VM_SPECIALIZED void write_mem(struct Worker *const w, const uintptr_t c, const uintptr_t x, const uintptr_t y, 
+        const uintptr_t ptr_mem, const uintptr_t value, const uintptr_t dirs)
+{
+#if EXEC_TRACE
+    if (w->trace)
+        ++w->trace->memWrites[ptr_mem >> 3];
+#endif
+    switch (ptr_mem) {
+        case 0x00: /* logo */
+            w->stats.memSpecialWrites++;
+            CELL_LOGO(c) = value & LOGO_MASK;
+            dumpRecordChanged(c);
+            break;
+        case 0x01: /* facing */
+            w->stats.memSpecialWrites++;
+            CELL_FACING(c) = value & FACING_MASK;
+            dumpRecordChanged(c);
+            break;
+
+        case 0x02: /* read only */
+        case 0x03:
+        case 0x04:
+        case 0x05:
+        case 0x06:
+        case 0x07:
+            w->stats.memSpecialWrites++;
+            break;
+
+        case 0x08: /* private RAM */
+        case 0x09:
+        case 0x0a:
+        case 0x0b:
+        case 0x0c:
+        case 0x0d:
+        case 0x0e:
+        case 0x0f:
+            w->stats.memPrivateWrites++;
+            CELL_RAM(c)[ptr_mem & 0x7] = value & REG_MASK;
+            break;
+
+        case 0x10: /* public RAM */
+        case 0x11:
+        case 0x12:
+        case 0x13:
+        case 0x14:
+        case 0x15:
+        case 0x16:
+        case 0x17:
+            w->stats.memOutputWrites++;
+            CELL_RAM(c)[8 + (ptr_mem & 0x7)] = value & REG_MASK;
+            break;
+
+        case 0x18: /* neighbor (facing) public ram (if permitted by logo) */
+        case 0x19:
+        case 0x1a:
+        case 0x1b:
+        case 0x1c:
+        case 0x1d:
+        case 0x1e:
+        case 0x1f:
+            {
+                w->stats.memInputWrites++;
+                const uintptr_t tmpcell = getNeighbor(x, y, CELL_FACING(c), dirs);
+                if (accessAllowed(w, tmpcell, CELL_LOGO(c), 1)) {
+                    CELL_RAM(tmpcell)[8 + (ptr_mem & 0x7)] = value & REG_MASK;
+                }
+            }
+            break;
+    }
+}
+
+/**
+ * Introduce a random cell with a given energy level
+ *
+ * This is called seeding, and introduces both energy and entropy into
+ * the substrate.
+ *
+ * @param w Worker doing the seeding
+ * @param x X position
+ * @param y Y position
+ */
+static void seedCell(struct Worker *const w, const uintptr_t x, const uintptr_t y)
+{
+  uint8_t genome[POND_DEPTH];
+  uintptr_t i;
+  const uintptr_t pcell = cellIndex(x, y);
+
+  populationRemove(w, pcell);
+
+  CELL_ID(pcell) = w->ids->next;
+  CELL_PARENT_ID(pcell) = 0;
+  CELL_LINEAGE(pcell) = w->ids->next;
+  CELL_GENERATION(pcell) = 0;
+  CELL_LOGO(pcell) = 0;
+  CELL_FACING(pcell) = 0;
+#if TOTAL_ENERGY_CAP
+  if (currentTotalEnergy(w) < TOTAL_ENERGY_CAP) {
+#endif
+#if CELL_ENERGY_CAP
+     if (CELL_ENERGY(pcell) < CELL_ENERGY_CAP) {
+#endif
+    if (config.inflowRateVariation)
+      CELL_ENERGY(pcell) += config.inflowRateBase + (getRandom(w->rng) % config.inflowRateVariation);
+    else
+      CELL_ENERGY(pcell) += config.inflowRateBase;
+#if CELL_ENERGY_CAP
+     }
+#endif
+#if TOTAL_ENERGY_CAP
+  }
+#endif
+#if SEED_BULK_RANDOM
+  fillRandomBytes(w->rng, genome, POND_DEPTH);
+  for(i = 0; i < POND_DEPTH; ++i)
+    genome[i] &= INST_MASK;
+#else
+  for(i = 0; i < POND_DEPTH; ++i) {
+    genome[i] = getRandom(w->rng) & INST_MASK;
+  }
+#endif
+  genomeSet(pcell, genome, POND_DEPTH);
+  for(i = 0; i < RAM_SIZE; ++i) {
+#if CLEAR_RAM
+    CELL_RAM(pcell)[i] = 0; 
+#else
+    CELL_RAM(pcell)[i] = getRandom(w->rng) & REG_MASK;
+#endif
+  }
+
+  takeCellId(w->ids);
+  populationAdd(w, pcell);
+}
+
+/**
+ * Seed every cell of the pond with a loop-heavy genome
+ *
+ * This is the starting point of the benchmark's loops workload. Each
+ * genome is a run of counted loops, ZERO INC [SHL...] LOOP <body> DEC REP,
+ * which go round 1, 2, 4 or 8 times over a body of instructions that
+ * leave the register alone, so LOOP, REP and the false loop skipping get
+ * exercised far more than in a random pond.
+ *
+ * @param w Worker doing the seeding
+ */
+static void seedLoopCorpus(struct Worker *const w)
+{
+  static const uint8_t body[6] = { OP_FWD, OP_BACK, OP_WRITEO, OP_NEXTB, OP_PREVB, OP_NEXTM };
+  uint8_t g[POND_DEPTH];
+  uintptr_t c, i, k, n;
+
+  for(c=0;c<POND_CELLS;++c) {
+    seedCell(w, cellX(c), cellY(c));
+    i = 0;
+    while ((i + 14) < POND_DEPTH) {
+      g[i++] = OP_ZERO;
+      g[i++] = OP_INC;
+      for(k=getRandom(w->rng) & 3;k;--k)
+        g[i++] = OP_SHL;
+      g[i++] = OP_LOOP;
+      for(n=1 + (getRandom(w->rng) % 6);n;--n)
+        g[i++] = body[getRandom(w->rng) % 6];
+      g[i++] = OP_DEC;
+      g[i++] = OP_REP;
+    }
+    genomeSet(c, g, i);
+  }
+}
+
+#if MUTATION_SKIP_AHEAD
+#define VM_MUTATION_DUE() \
+  (mutationCountdown-- ? 0 : ((mutationCountdown = nextMutationDistance(w->rng)), 1))
+#else
+#define VM_MUTATION_DUE() ((getRandom(w->rng) & 0xffffffff) < config.mutationRate)
+#endif
+
+/* Randomly frob either the instruction or the register with a
+ * probability defined by MUTATION_RATE. This introduces variation,
+ * and since the variation is introduced into the state of the VM
+ * it can have all manner of different effects on the end result of
+ * replication: insertions, deletions, duplications of entire
+ * ranges of the genome, etc. setInst replaces the instruction about to
+ * be executed with tmp & INST_MASK. */
+#define VM_MUTATE(setInst) \
+    if (VM_MUTATION_DUE()) { \
+      tmp = getRandom(w->rng); /* Call getRandom() only once for speed */ \
+      if (tmp & 0x20000) \
+          if (tmp & 0x10000) \
+              setInst; \
+          else \
+              reg = tmp & REG_MASK; \
+      else \
+          if (tmp & 0x10000) \
+              ptr_mem = tmp & MEM_MASK; \
+          else \
+              CELL_RAM(pcell)[(tmp >> 8) & RAM_MASK] = tmp & REG_MASK; \
+    }
+
+#if LOOP_JUMP_TABLE
+/**
+ * Skip a false LOOP/REP block in one step if possible
+ *
+ * Looks up (or works out and caches) the distance from the LOOP at
+ * instPtr to its matching REP, then charges one unit of energy and one
+ * count of the mutation countdown per skipped instruction, exactly as
+ * walking the block would. It gives up if a mutation would happen inside
+ * the block, since that could change which REP matches. If there is no
+ * matching REP, or not enough energy to reach it, all the remaining
+ * energy is used up as walking would do.
+ *
+ * A match, if there is one, is always within one pass around the
+ * genome: if the depth has not reached zero after a full pass, that pass
+ * had at least as many LOOPs as REPs and every later pass will too.
+ *
+ * @param w Worker (for its cache)
+ * @param c Cell being executed
+ * @param instPtr Position of the LOOP, updated to the matching REP
+ * @param mutationCountdown Instructions until the next mutation
+ * @return 1 if the block was skipped, 0 if it must be walked
+ */
+static int skipFalseLoop(struct Worker *const w, const uintptr_t c, uintptr_t *const instPtr, uintptr_t *const mutationCountdown)
+{
+  struct LoopJumpEntry *const e = &w->loopJumps[c & (LOOP_JUMP_CACHE_SIZE - 1)];
+  uintptr_t d, steps, p, depth;
+
+  if ((e->cell != c)||(e->version != CELL_GENOME_VERSION(c))) {
+    e->cell = c;
+    e->version = CELL_GENOME_VERSION(c);
+    memset(e->distance, 0, sizeof(e->distance));
+  }
+
+  d = e->distance[*instPtr];
+  if (!d) {
+    /* Walk one pass around the genome, as the interpreter would */
+    d = LOOP_JUMP_NONE;
+    depth = 1;
+    p = *instPtr;
+    for(steps=1;steps<=(POND_DEPTH - EXEC_START_INST);++steps) {
+      if (++p >= POND_DEPTH)
+        p = EXEC_START_INST;
+      if (GENOME_AT(c, p) == OP_LOOP)
+        ++depth;
+      else if ((GENOME_AT(c, p) == OP_REP)&&(!--depth)) {
+        d = steps;
+        break;
+      }
+    }
+    e->distance[*instPtr] = (uint16_t)d;
+  }
+
+  steps = ((d == LOOP_JUMP_NONE)||(d > CELL_ENERGY(c))) ? CELL_ENERGY(c) : d;
+  if (*mutationCountdown < steps)
+    return 0;
+
+  *mutationCountdown -= steps;
+  CELL_ENERGY(c) -= steps;
+  *instPtr = EXEC_START_INST + ((*instPtr - EXEC_START_INST + steps) % (POND_DEPTH - EXEC_START_INST));
+  return 1;
+}
+#endif /* LOOP_JUMP_TABLE */
+
+#if (VM_DISPATCH == VM_DISPATCH_THREADED)
+#ifndef __GNUC__
+#error VM_DISPATCH_THREADED needs computed goto (GCC or Clang)
+#endif
+#elif (VM_DISPATCH != VM_DISPATCH_SWITCH)
+#error Unknown VM_DISPATCH
+#elif VM_PREDECODE
+#error VM_PREDECODE needs VM_DISPATCH_THREADED
+#endif
+
+/**
+ * Execute a cell's genome until it stops or runs out of energy, then
+ * place its offspring if it produced one
+ *
+ * @param w Worker doing the execution
+ * @param x X position
+ * @param y Y position
+ * @param dirs Number of directions (4, 6 or 8) (with VM_SPECIALIZE)
+ */
+#if VM_SPECIALIZE
+static inline VM_SPECIALIZED void execCellDirs(struct Worker *const w, const uintptr_t x, const uintptr_t y, const uintptr_t dirs)
+#else
+static void execCell(struct Worker *const w, const uintptr_t x, const uintptr_t y)
+#endif
+{
+#if !VM_SPECIALIZE
+  const uintptr_t dirs = DIRECTIONS;
+#endif
+  uintptr_t i;
+
+  /* Buffer used for execution output of candidate offspring. Only the
+   * first outputEnd bytes have been written (or filled with OP_STOP);
+   * the rest reads as OP_STOP. Most executions write little or none of
+   * it, so this saves clearing and copying all of it every time. */
+  uint8_t outputBuf[POND_DEPTH];
+  uintptr_t outputEnd;
+#define VM_READO() ((ptr_ioPtr < outputEnd) ? outputBuf[ptr_ioPtr] : OP_STOP)
+#define VM_WRITEO(v) \
+  do { \
+    if (ptr_ioPtr >= outputEnd) { \
+      memset(outputBuf + outputEnd, OP_STOP, ptr_ioPtr - outputEnd); \
+      outputEnd = ptr_ioPtr + 1; \
+    } \
+    outputBuf[ptr_ioPtr] = (v); \
+  } while (0)
+
+  /* Miscellaneous variables used in the loop */
+  uintptr_t instPtr, inst, tmp;
+  const uintptr_t pcell = cellIndex(x, y);
+  uintptr_t tmpcell;
+  
+  /* Virtual machine I/O pointer register (used for both genome and output buffer) */
+  uintptr_t ptr_ioPtr;
+
+  /* memory pointers */
+  uintptr_t ptr_mem;
+  
+  /* The main "register" */
+  uintptr_t reg;
+  
+  /* Which way is the cell facing? */
+  //uintptr_t facing;
+  
+  /* Virtual machine loop/rep stack */
+  uintptr_t loopStack[POND_DEPTH];
+  uintptr_t loopStackPtr;
+  
+  /* If this is nonzero, we're skipping to matching REP */
+  /* It is incremented to track the depth of a nested set
+   * of LOOP/REP pairs in false state. */
+  uintptr_t falseLoopDepth;
+  
+#if (VM_DISPATCH == VM_DISPATCH_SWITCH)
+  /* If this is nonzero, cell execution stops. This allows us
+   * to avoid the ugly use of a goto to exit the loop. :) */
+  int stop;
+#endif
+
+#if MUTATION_SKIP_AHEAD
+  /* Kept in a local while executing */
+  uintptr_t mutationCountdown = w->mutationCountdown;
+#endif
+
+#if PROFILE_CYCLES
+  /* Start of the execution and of the run, the last timestamp, the
+   * instruction being timed and the number run */
+  const uint64_t profStart = profileNow();
+  uint64_t profRun, profThen, profNow;
+  uintptr_t profOp = PROFILE_OP_NONE, profInstructions = 0;
+
+  /* Charge the time since the last timestamp to profOp */
+#define PROFILE_SAMPLE() (profNow = profileNow(), w->profile.opCycles[profOp] += profNow - profThen, profThen = profNow)
+  /* Start timing an instruction */
+#define PROFILE_OP(op) (PROFILE_SAMPLE(), profOp = (op), ++w->profile.opCount[(op)], ++profInstructions)
+#else
+#define PROFILE_OP(op)
+#endif
+
+#if EXEC_TRACE
+  /* Trace of this execution, or NULL if it is not one of those sampled */
+  struct TraceRecord *trace = (struct TraceRecord *)0;
+
+  /* Note an instruction, count a LOOP event, or set the outcome */
+#define TRACE_STEP(op) do { if (trace) traceStep(trace, instPtr, (op)); } while (0)
+#define TRACE_COUNT(field) do { if (trace) ++trace->field; } while (0)
+#define TRACE_END(o) do { if (trace) trace->outcome = (o); } while (0)
+#else
+#define TRACE_STEP(op)
+#define TRACE_COUNT(field)
+#define TRACE_END(o)
+#endif
+
+  /* Reset the state of the VM prior to execution */
+  outputEnd = 0;
+  ptr_ioPtr = 0;
+  loopStackPtr = 0;
+  falseLoopDepth = 0;
+#if (VM_DISPATCH == VM_DISPATCH_SWITCH)
+  stop = 0;
+#endif
+
+  //facing = CELL_GENOME(pcell)[1] & 0x7;
+  //reg = CELL_GENOME(pcell)[2] & INST_MASK;
+  reg = 0;
+  instPtr = EXEC_START_INST;
+
+  ptr_mem = 0;
+  
+  /* Keep track of how many cells have been executed */
+  ++w->stats.cellExecutions;
+
+#if EXEC_TRACE
+  if (!--w->traceCountdown) {
+    w->traceCountdown = EXEC_TRACE_SAMPLE;
+    trace = startTrace(w, pcell);
+  }
+  w->trace = trace;
+#endif
+
+  /* The cell's energy changes all through execution, so it is taken out
+   * of the population totals until the end */
+  populationRemove(w, pcell);
+
+#if PROFILE_CYCLES
+  profRun = profThen = profileNow();
+  w->profile.phaseCycles[PROFILE_RESET] += profRun - profStart;
+#endif
+
+#if (VM_DISPATCH == VM_DISPATCH_THREADED)
+  {
+    /* Where each instruction's code starts */
+    static const void *const dispatchTable[NUM_INST] = {
+      [OP_STOP] = &&vm_stop,     [OP_FWD] = &&vm_fwd,       [OP_BACK] = &&vm_back,     [OP_INC] = &&vm_inc,
+      [OP_DEC] = &&vm_dec,       [OP_READG] = &&vm_readg,   [OP_WRITEG] = &&vm_writeg, [OP_READO] = &&vm_reado,
+      [OP_WRITEO] = &&vm_writeo, [OP_LOOP] = &&vm_loop,     [OP_REP] = &&vm_rep,       [OP_TURN] = &&vm_turn,
+      [OP_XCHG] = &&vm_xchg,     [OP_KILL] = &&vm_kill,     [OP_SHARE] = &&vm_share,   [OP_ZERO] = &&vm_zero,
+      [OP_SETP] = &&vm_setp,     [OP_NEXTB] = &&vm_nextb,   [OP_PREVB] = &&vm_prevb,   [OP_NEXTM] = &&vm_nextm,
+      [OP_PREVM] = &&vm_prevm,   [OP_READM] = &&vm_readm,   [OP_WRITEM] = &&vm_writem, [OP_CLEARM] = &&vm_clearm,
+      [OP_ADD] = &&vm_add,       [OP_SUB] = &&vm_sub,       [OP_MUL] = &&vm_mul,       [OP_DIV] = &&vm_div,
+      [OP_SHL] = &&vm_shl,       [OP_SHR] = &&vm_shr,       [OP_SETMP] = &&vm_setmp,   [OP_RAND] = &&vm_rand
+    };
+    const void *handler;
+
+#if VM_PREDECODE
+    /* The genome decoded into jump targets */
+    const void *code[POND_DEPTH];
+    for(i=0;i<POND_DEPTH;++i)
+      code[i] = dispatchTable[GENOME_AT(pcell, i)];
+#define VM_DECODE() (handler = code[instPtr])
+#define VM_GENOME_WRITTEN(p) (code[(p)] = dispatchTable[GENOME_AT(pcell, (p))])
+#else
+#define VM_DECODE() (handler = dispatchTable[GENOME_AT(pcell, instPtr)])
+#define VM_GENOME_WRITTEN(p)
+#endif
+
+    /* Run the instruction at instPtr: the same steps as one pass of the
+     * switch loop up to the switch, ending in a jump to the handler */
+#define VM_DISPATCH_CURRENT() \
+    do { \
+      if (!CELL_ENERGY(pcell)) \
+        goto vm_done; \
+      VM_DECODE(); \
+      VM_MUTATE(handler = dispatchTable[tmp & INST_MASK]); \
+      --CELL_ENERGY(pcell); \
+      goto *handler; \
+    } while (0)
+
+    /* Advance the instruction pointer (wrapping at the end) and run the
+     * next instruction */
+#define VM_NEXT() \
+    do { \
+      if (++instPtr >= POND_DEPTH) \
+        instPtr = EXEC_START_INST; \
+      VM_DISPATCH_CURRENT(); \
+    } while (0)
+
+    /* Start of an instruction, which also counts its execution */
+#define VM_OP(label, op) label: ++w->stats.instructionExecutions[(op)]; PROFILE_OP(op); TRACE_STEP(op);
+
+    VM_DISPATCH_CURRENT();
+
+    VM_OP(vm_setp, OP_SETP)
+      ptr_ioPtr = reg;
+      VM_NEXT();
+    VM_OP(vm_nextb, OP_NEXTB)
+      ptr_mem = (ptr_mem + 8) & MEM_MASK;
+      VM_NEXT();
+    VM_OP(vm_prevb, OP_PREVB)
+      ptr_mem = (ptr_mem - 8) & MEM_MASK;
+      VM_NEXT();
+    VM_OP(vm_nextm, OP_NEXTM)
+      ptr_mem = (ptr_mem + 1) & MEM_MASK;
+      VM_NEXT();
+    VM_OP(vm_prevm, OP_PREVM)
+      ptr_mem = (ptr_mem - 1) & MEM_MASK;
+      VM_NEXT();
+    VM_OP(vm_readm, OP_READM)
+      reg = read_mem(w, pcell, x, y, ptr_mem, dirs);
+      VM_NEXT();
+    VM_OP(vm_writem, OP_WRITEM)
+      write_mem(w, pcell, x, y, ptr_mem, reg, dirs);
+      VM_NEXT();
+    VM_OP(vm_clearm, OP_CLEARM)
+      for (i = 0; i < RAM_SIZE; ++i) {
+          CELL_RAM(pcell)[i] = 0x0;
+      }
+      VM_NEXT();
+    VM_OP(vm_add, OP_ADD)
+      reg = (reg + read_mem(w, pcell, x, y, ptr_mem, dirs)) & REG_MASK;
+      VM_NEXT();
+    VM_OP(vm_sub, OP_SUB)
+      reg = (reg - read_mem(w, pcell, x, y, ptr_mem, dirs)) & REG_MASK;
+      VM_NEXT();
+    VM_OP(vm_mul, OP_MUL)
+      reg = (reg * read_mem(w, pcell, x, y, ptr_mem, dirs)) & REG_MASK;
+      VM_NEXT();
+    VM_OP(vm_div, OP_DIV)
+      tmp = read_mem(w, pcell, x, y, ptr_mem, dirs);
+      reg = tmp ? (reg / read_mem(w, pcell, x, y, ptr_mem, dirs)) & REG_MASK : 0;
+      VM_NEXT();
+    VM_OP(vm_shl, OP_SHL)
+      reg = (reg << 1) & REG_MASK;
+      VM_NEXT();
+    VM_OP(vm_shr, OP_SHR)
+      reg = (reg >> 1) & REG_MASK;
+      VM_NEXT();
+    VM_OP(vm_setmp, OP_SETMP)
+      ptr_mem = reg & MEM_MASK;
+      VM_NEXT();
+    VM_OP(vm_rand, OP_RAND)
+      reg = getRandom(w->rng) & REG_MASK;
+      VM_NEXT();
+    VM_OP(vm_zero, OP_ZERO)
+      reg = 0;
+      VM_NEXT();
+    VM_OP(vm_fwd, OP_FWD)
+      if (++ptr_ioPtr >= POND_DEPTH) {
+          ptr_ioPtr = 0;
+      }
+      VM_NEXT();
+    VM_OP(vm_back, OP_BACK)
+      if (ptr_ioPtr) {
+          --ptr_ioPtr;
+      }
+      else {
+          ptr_ioPtr = POND_DEPTH - 1;
+      }
+      VM_NEXT();
+    VM_OP(vm_inc, OP_INC)
+      reg = (reg + 1) & REG_MASK;
+      VM_NEXT();
+    VM_OP(vm_dec, OP_DEC)
+      reg = (reg - 1) & REG_MASK;
+      VM_NEXT();
+    VM_OP(vm_readg, OP_READG)
+      reg = GENOME_AT(pcell, ptr_ioPtr);
+      VM_NEXT();
+    VM_OP(vm_writeg, OP_WRITEG)
+      genomeWrite(pcell, ptr_ioPtr, reg & INST_MASK);
+      VM_GENOME_WRITTEN(ptr_ioPtr);
+      VM_NEXT();
+    VM_OP(vm_reado, OP_READO)
+      reg = VM_READO();
+      VM_NEXT();
+    VM_OP(vm_writeo, OP_WRITEO)
+      VM_WRITEO(reg & INST_MASK);
+      VM_NEXT();
+    VM_OP(vm_loop, OP_LOOP)
+      if (reg) {
+        if (loopStackPtr >= POND_DEPTH) {
+          TRACE_END(TRACE_OVERFLOW);
+          goto vm_done; /* Stack overflow ends execution */
+        }
+        loopStack[loopStackPtr] = instPtr;
+        ++loopStackPtr;
+        TRACE_COUNT(loopEntries);
+        VM_NEXT();
+      }
+      TRACE_COUNT(loopSkips);
+#if LOOP_JUMP_TABLE
+      if (skipFalseLoop(w, pcell, &instPtr, &mutationCountdown))
+        VM_NEXT();
+#endif
+      /* Skip forward to the matching REP. Each skipped instruction
+       * still costs energy and may be mutated, as in the switch loop. */
+      falseLoopDepth = 1;
+      do {
+        if (++instPtr >= POND_DEPTH)
+          instPtr = EXEC_START_INST;
+        if (!CELL_ENERGY(pcell))
+          goto vm_done;
+        inst = GENOME_AT(pcell, instPtr);
+        VM_MUTATE(inst = tmp & INST_MASK);
+        --CELL_ENERGY(pcell);
+        if (inst == OP_LOOP)
+          ++falseLoopDepth;
+        else if (inst == OP_REP)
+          --falseLoopDepth;
+      } while (falseLoopDepth);
+      VM_NEXT();
+    VM_OP(vm_rep, OP_REP)
+      if (loopStackPtr) {
+        --loopStackPtr;
+        if (reg) {
+          /* Jump back to the LOOP so that it is rerun */
+          TRACE_COUNT(loopRepeats);
+          instPtr = loopStack[loopStackPtr];
+          VM_DISPATCH_CURRENT();
+        }
+      }
+      VM_NEXT();
+    VM_OP(vm_turn, OP_TURN)
+      /* read one instruction from either own genome or facing cell */
+      if (CELL_GENERATION(pcell) > 2) {
+          tmpcell = getNeighbor(x, y, CELL_FACING(pcell), dirs);
+          if (CELL_GENERATION(tmpcell) > 2 && accessAllowed(w, tmpcell, reg, COMBINE_SENSE)) {
+              reg = GENOME_AT(((getRandom(w->rng) & 0x8) ? pcell : tmpcell), ptr_ioPtr);
+          }
+          else {
+              reg = GENOME_AT(pcell, ptr_ioPtr);
+          }
+      }
+      else {
+          reg = GENOME_AT(pcell, ptr_ioPtr);
+      }
+      VM_NEXT();
+    VM_OP(vm_xchg, OP_XCHG)
+      if (++instPtr >= POND_DEPTH) {
+          instPtr = EXEC_START_INST;
+      }
+      tmp = reg;
+      reg = GENOME_AT(pcell, instPtr);
+      genomeWrite(pcell, instPtr, tmp & INST_MASK);
+      VM_GENOME_WRITTEN(instPtr);
+      VM_NEXT();
+    VM_OP(vm_kill, OP_KILL)
+      tmpcell = getNeighbor(x, y, CELL_FACING(pcell), dirs);
+      if (accessAllowed(w, tmpcell, reg, 0)) {
+        if (CELL_GENERATION(tmpcell) > 2)
+          ++w->stats.viableCellsKilled;
+
+        populationRemove(w, tmpcell);
+
+        /* clear all */
+        genomeSet(tmpcell, (const uint8_t *)0, 0);
+        CELL_ID(tmpcell) = w->ids->next;
+        CELL_PARENT_ID(tmpcell) = 0;
+        CELL_LINEAGE(tmpcell) = w->ids->next;
+        CELL_GENERATION(tmpcell) = 0;
+        CELL_LOGO(tmpcell) = 0;
+        CELL_FACING(tmpcell) = 0;
+        takeCellId(w->ids);
+        populationAdd(w, tmpcell);
+      } else if (CELL_GENERATION(tmpcell) > 2) {
+        tmp = CELL_ENERGY(pcell) / FAILED_KILL_PENALTY;
+        if (CELL_ENERGY(pcell) > tmp)
+          CELL_ENERGY(pcell) -= tmp;
+        else CELL_ENERGY(pcell) = 0;
+      }
+      VM_NEXT();
+    VM_OP(vm_share, OP_SHARE)
+      tmpcell = getNeighbor(x, y, CELL_FACING(pcell), dirs);
+      if (accessAllowed(w, tmpcell,reg,1)) {
+        if (CELL_GENERATION(tmpcell) > 2)
+          ++w->stats.viableCellShares;
+
+        populationRemove(w, tmpcell);
+        tmp = CELL_ENERGY(pcell) + CELL_ENERGY(tmpcell);
+        CELL_ENERGY(tmpcell) = tmp / 2;
+        CELL_ENERGY(pcell) = tmp - CELL_ENERGY(tmpcell);
+        populationAdd(w, tmpcell);
+      }
+      VM_NEXT();
+    VM_OP(vm_stop, OP_STOP)
+      TRACE_END(TRACE_STOPPED);
+      /* fall through */
+
+#undef VM_OP
+#undef VM_NEXT
+#undef VM_DISPATCH_CURRENT
+#undef VM_GENOME_WRITTEN
+#undef VM_DECODE
+  }
+vm_done:
+#else
+  /* Core execution loop */
+  while (CELL_ENERGY(pcell)&&(!stop)) {
+    /* Get the next instruction */
+    inst = GENOME_AT(pcell, instPtr);
+    
+    /* Maybe mutate the VM state, see VM_MUTATE */
+    VM_MUTATE(inst = tmp & INST_MASK);
+    
+    /* Each instruction processed costs one unit of energy */
+    --CELL_ENERGY(pcell);
+    
+    /* Execute the instruction */
+    if (falseLoopDepth) {
+      PROFILE_OP(PROFILE_OP_SKIP);
+      /* Skip forward to matching REP if we're in a false loop. */
+      if (inst == 0x9) /* Increment false LOOP depth */
+        ++falseLoopDepth;
+      else if (inst == 0xa) /* Decrement on REP */
+        --falseLoopDepth;
+    } else {
+      /* If we're not in a false LOOP/REP, execute normally */
+      
+      /* Keep track of execution frequencies for each instruction */
+      ++w->stats.instructionExecutions[inst];
+      PROFILE_OP(inst);
+      TRACE_STEP(inst);
+      
+      switch(inst) {
+        case OP_SETP: /* SETP */
+          ptr_ioPtr = reg;
+          break;
+        case OP_NEXTB: /* NEXTB */
+          ptr_mem = (ptr_mem + 8) & MEM_MASK;
+          break;
+        case OP_PREVB: /* PREVB */
+          ptr_mem = (ptr_mem - 8) & MEM_MASK;
+          break;
+        case OP_NEXTM: /* NEXTM */
+          ptr_mem = (ptr_mem + 1) & MEM_MASK;
+          break;
+        case OP_PREVM: /* PREVM */
+          ptr_mem = (ptr_mem - 1) & MEM_MASK;
+          break;
+        case OP_READM: /* READM */
+          reg = read_mem(w, pcell, x, y, ptr_mem, dirs);
+          break;
+        case OP_WRITEM: /* WRITEM */
+          write_mem(w, pcell, x, y, ptr_mem, reg, dirs);
+          break;
+        case OP_CLEARM: /* CLEARM */
+          for (i = 0; i < RAM_SIZE; ++i) {
+              CELL_RAM(pcell)[i] = 0x0;
+          }
+          break;
+        case OP_ADD:
+          reg = (reg + read_mem(w, pcell, x, y, ptr_mem, dirs)) & REG_MASK;
+          break;
+        case OP_SUB:
+          reg = (reg - read_mem(w, pcell, x, y, ptr_mem, dirs)) & REG_MASK;
+          break;
+        case OP_MUL:
+          reg = (reg * read_mem(w, pcell, x, y, ptr_mem, dirs)) & REG_MASK;
+          break;
+        case OP_DIV:
+          tmp = read_mem(w, pcell, x, y, ptr_mem, dirs);
+          reg = tmp ? (reg / read_mem(w, pcell, x, y, ptr_mem, dirs)) & REG_MASK : 0;
+          break;
+        case OP_SHL:
+          reg = (reg << 1) & REG_MASK;
+          break;
+        case OP_SHR:
+          reg = (reg >> 1) & REG_MASK;
+          break;
+        case OP_SETMP:
+          ptr_mem = reg & MEM_MASK;
+          break;
+        case OP_RAND:
+          reg = getRandom(w->rng) & REG_MASK;
+          break;
+        case OP_ZERO: /* ZERO: Zero VM state registers */
+          reg = 0;
+          //ptr_ioPtr = 0;
+          //facing = 0;
+          break;
+        case OP_FWD: /* FWD: Increment the pointer (wrap at end) */
+          if (++ptr_ioPtr >= POND_DEPTH) {
+              ptr_ioPtr = 0;
+          }
+          break;
+        case OP_BACK: /* BACK: Decrement the pointer (wrap at beginning) */
+          if (ptr_ioPtr) {
+              --ptr_ioPtr;
+          }
+          else {
+              ptr_ioPtr = POND_DEPTH - 1;
+          }
+          break;
+        case OP_INC: /* INC: Increment the register */
+          reg = (reg + 1) & REG_MASK;
+          break;
+        case OP_DEC: /* DEC: Decrement the register */
+          reg = (reg - 1) & REG_MASK;
+          break;
+        case OP_READG: /* READG: Read into the register from genome */
+          reg = GENOME_AT(pcell, ptr_ioPtr);
+          break;
+        case OP_WRITEG: /* WRITEG: Write out from the register to genome */
+          genomeWrite(pcell, ptr_ioPtr, reg & INST_MASK);
+          break;
+        case OP_READO: /* READO: Read into the register from output buffer */
+          reg = VM_READO();
+          break;
+        case OP_WRITEO: /* WRITEO: Write out from the register to output buffer */
+          VM_WRITEO(reg & INST_MASK);
+          break;
+        case OP_LOOP: /* LOOP: Jump forward to matching REP if register is zero */
+          if (reg) {
+            if (loopStackPtr >= POND_DEPTH) {
+              stop = 1; /* Stack overflow ends execution */
+              TRACE_END(TRACE_OVERFLOW);
+            } else {
+              loopStack[loopStackPtr] = instPtr;
+              ++loopStackPtr;
+              TRACE_COUNT(loopEntries);
+            }
+          } else {
+            TRACE_COUNT(loopSkips);
+#if LOOP_JUMP_TABLE
+            if (!skipFalseLoop(w, pcell, &instPtr, &mutationCountdown))
+#endif
+              falseLoopDepth = 1;
+          }
+          break;
+        case OP_REP: /* REP: Jump back to matching LOOP if register is nonzero */
+          if (loopStackPtr) {
+            --loopStackPtr;
+            if (reg) {
+              TRACE_COUNT(loopRepeats);
+              instPtr = loopStack[loopStackPtr];
+              /* This ensures that the LOOP is rerun */
+              continue;
+            }
+          }
+          break;
+        case OP_TURN: /* using this inst for ideas */
+          /* TURN: Turn in the direction specified by register */
+          //CELL_FACING(pcell) = reg & FACING_MASK; /* TURN */
+
+          //ptr_mem = (ptr_mem + 4) & MEM_MASK; /* inc mem+ptr by 4 */
+
+          /* read one instruction from either own genome or facing cell */
+          if (CELL_GENERATION(pcell) > 2) {
+              tmpcell = getNeighbor(x, y, CELL_FACING(pcell), dirs);
+              if (CELL_GENERATION(tmpcell) > 2 && accessAllowed(w, tmpcell, reg, COMBINE_SENSE)) {
+                  reg = GENOME_AT(((getRandom(w->rng) & 0x8) ? pcell : tmpcell), ptr_ioPtr);
+              }
+              else {
+                  reg = GENOME_AT(pcell, ptr_ioPtr);
+              }
+          }
+          else {
+              reg = GENOME_AT(pcell, ptr_ioPtr);
+          }
+          break;
+        case OP_XCHG: /* XCHG: Skip next instruction and exchange value of register with it */
+          if (++instPtr >= POND_DEPTH) {
+              instPtr = EXEC_START_INST;
+          }
+          tmp = reg;
+          reg = GENOME_AT(pcell, instPtr);
+          genomeWrite(pcell, instPtr, tmp & INST_MASK);
+          break;
+        case OP_KILL: /* KILL: Blow away neighboring cell if allowed with penalty on failure */
+          tmpcell = getNeighbor(x, y, CELL_FACING(pcell), dirs);
+          if (accessAllowed(w, tmpcell, reg, 0)) {
+            if (CELL_GENERATION(tmpcell) > 2)
+              ++w->stats.viableCellsKilled;
+
+            populationRemove(w, tmpcell);
+
+            /* clear all */
+            genomeSet(tmpcell, (const uint8_t *)0, 0);
+            CELL_ID(tmpcell) = w->ids->next;
+            CELL_PARENT_ID(tmpcell) = 0;
+            CELL_LINEAGE(tmpcell) = w->ids->next;
+            CELL_GENERATION(tmpcell) = 0;
+            CELL_LOGO(tmpcell) = 0;
+            CELL_FACING(tmpcell) = 0;
+            takeCellId(w->ids);
+            populationAdd(w, tmpcell);
+          } else if (CELL_GENERATION(tmpcell) > 2) {
+            tmp = CELL_ENERGY(pcell) / FAILED_KILL_PENALTY;
+            if (CELL_ENERGY(pcell) > tmp)
+              CELL_ENERGY(pcell) -= tmp;
+            else CELL_ENERGY(pcell) = 0;
+          }
+          break;
+        case OP_SHARE: /* SHARE: Equalize energy between self and neighbor if allowed */
+          tmpcell = getNeighbor(x, y, CELL_FACING(pcell), dirs);
+          if (accessAllowed(w, tmpcell,reg,1)) {
+            if (CELL_GENERATION(tmpcell) > 2)
+              ++w->stats.viableCellShares;
+
+            populationRemove(w, tmpcell);
+            tmp = CELL_ENERGY(pcell) + CELL_ENERGY(tmpcell);
+            CELL_ENERGY(tmpcell) = tmp / 2;
+            CELL_ENERGY(pcell) = tmp - CELL_ENERGY(tmpcell);
+            populationAdd(w, tmpcell);
+          }
+          break;
+        case OP_STOP: /* STOP: End execution */
+          stop = 1;
+          TRACE_END(TRACE_STOPPED);
+          break;
+      }
+    }
+    
+    /* Advance the instruction pointer, and loop around to the beginning at the end of the genome. */
+    if (++instPtr >= POND_DEPTH) {
+        instPtr = EXEC_START_INST;
+    }
+  }
+#endif /* VM_DISPATCH */
+
+#if MUTATION_SKIP_AHEAD
+  w->mutationCountdown = mutationCountdown;
+#endif
+
+#if PROFILE_CYCLES
+  PROFILE_SAMPLE();
+  w->profile.phaseCycles[PROFILE_RUN] += profNow - profRun;
+  ++w->profile.instructionHist[profileBucket(profInstructions)];
+  ++w->profile.energyHist[profileBucket(CELL_ENERGY(pcell))];
+#endif
+
+  /* Decay part of RAM if there is no energy. */
+  if (!CELL_ENERGY(pcell)) {
+#if DECAY_RAM
+      tmp = getRandom(w->rng);
+      CELL_RAM(pcell)[(tmp >> 8) & RAM_MASK] = tmp & REG_MASK;
+#endif
+  }
+  else if (CELL_ENERGY(pcell) >= config.reproductionCost) {
+
+      /* Copy outputBuf into neighbor if access is permitted and there
+       * is energy there to make something happen. There is no need
+       * to copy to a cell with no energy, since anything copied there
+       * would never be executed and then would be replaced with random
+       * junk eventually. See the seeding code in the main loop above. */
+      if ((outputEnd)&&(outputBuf[0] != OP_STOP)) {
+          tmpcell = getNeighbor(x, y, CELL_FACING(pcell), dirs);
+          if ((CELL_ENERGY(tmpcell))&&accessAllowed(w, tmpcell, reg, 0)) {
+              /* Log it if we're replacing a viable cell */
+              if (CELL_GENERATION(tmpcell) > 2)
+                  ++w->stats.viableCellsReplaced;
+
+              populationRemove(w, tmpcell);
+              CELL_ID(tmpcell) = advanceCellId(w->ids);
+              CELL_PARENT_ID(tmpcell) = CELL_ID(pcell);
+              CELL_LINEAGE(tmpcell) = CELL_LINEAGE(pcell); /* Lineage is copied in offspring */
+              CELL_GENERATION(tmpcell) = CELL_GENERATION(pcell) + 1;
+              CELL_LOGO(tmpcell) = 0;
+              CELL_FACING(tmpcell) = 0;
+              genomeSet(tmpcell, outputBuf, outputEnd);
+              for(i = 0; i < RAM_SIZE; ++i) {
+#if CLEAR_RAM
+                  CELL_RAM(tmpcell)[i] = 0;
+#else
+                  CELL_RAM(tmpcell)[i] = getRandom(w->rng) & REG_MASK;
+#endif
+              }
+              populationAdd(w, tmpcell);
+#if BIRTH_LOG
+              logBirth(w, tmpcell);
+#endif
+#if EXEC_TRACE
+              if (trace)
+                trace->reproduced = 1;
+#endif
+              CELL_ENERGY(pcell) -= config.reproductionCost;
+          }
+      }
+  }
+
+  populationAdd(w, pcell);
+
+#if PROFILE_CYCLES
+  w->profile.phaseCycles[PROFILE_REPRODUCE] += profileNow() - profNow;
+  ++w->profile.executions;
+#undef PROFILE_SAMPLE
+#endif
+#if EXEC_TRACE
+  w->trace = (struct TraceRecord *)0;
+#endif
+#undef TRACE_END
+#undef TRACE_COUNT
+#undef TRACE_STEP
+#undef PROFILE_OP
+#undef VM_WRITEO
+#undef VM_READO
+}
+
+#if VM_SPECIALIZE
+/**
+ * Execute a cell with the copy of the interpreter for the pond's number
+ * of directions
+ *
+ * @param w Worker doing the execution
+ * @param x X position
+ * @param y Y position
+ */
+static void execCell(struct Worker *const w, const uintptr_t x, const uintptr_t y)
+{
+  switch (config.directions) {
+    case 4:
+      execCellDirs(w, x, y, 4);
+      break;
+    case 8:
+      execCellDirs(w, x, y, 8);
+      break;
+    default:
+      execCellDirs(w, x, y, 6);
+      break;
+  }
+}
+#endif /* VM_SPECIALIZE */
+
+#if (PARALLEL_THREADS > 0)
+
+/* ----------------------------------------------------------------------- */
+/* Parallel tile engine state                                              */
+/* ----------------------------------------------------------------------- */
+
+#if ((PARALLEL_TILES_X & 1) || (PARALLEL_TILES_Y & 1))
+#error "PARALLEL_TILES_X and PARALLEL_TILES_Y must be even"
+#endif
+#if ((POND_SIZE_X % PARALLEL_TILES_X) || (POND_SIZE_Y % PARALLEL_TILES_Y))
+#error "PARALLEL_TILES_X and PARALLEL_TILES_Y must divide the pond size"
+#endif
+#if ((POND_SIZE_X / PARALLEL_TILES_X) < 2 || (POND_SIZE_Y / PARALLEL_TILES_Y) < 2)
+#error "Parallel tiles must be at least 2 cells wide and high"
+#endif
+#if ((REPORT_FREQUENCY % PARALLEL_EPOCH) || (PARALLEL_EPOCH % INFLOW_FREQUENCY))
+#error "PARALLEL_EPOCH must divide REPORT_FREQUENCY and be a multiple of INFLOW_FREQUENCY"
+#endif
+#if (defined(USE_SDL) && (REFRESH_FREQUENCY % PARALLEL_EPOCH))
+#error "PARALLEL_EPOCH must divide REFRESH_FREQUENCY"
+#endif
+#if (defined(DUMP_FREQUENCY) && (DUMP_FREQUENCY % PARALLEL_EPOCH))
+#error "PARALLEL_EPOCH must divide DUMP_FREQUENCY"
+#endif
+
+#define TILE_SIZE_X (POND_SIZE_X / PARALLEL_TILES_X)
+#define TILE_SIZE_Y (POND_SIZE_Y / PARALLEL_TILES_Y)
+#define NUM_TILES (PARALLEL_TILES_X * PARALLEL_TILES_Y)
+#define TILES_PER_COLOR (NUM_TILES / 4)
+
+/**
+ * A rectangular piece of the pond
+ */
+struct Tile
+{
+  /* Upper left corner */
+  uintptr_t x0, y0;
+
+  /* Cell executions and inflows assigned for the current epoch */
+  uintptr_t executions, inflows;
+
+#if PARALLEL_DETERMINISTIC
+  struct RandomState rng;
+  struct CellIdCounter ids;
+#if MUTATION_SKIP_AHEAD
+  uintptr_t mutationCountdown;
+#endif
+#endif
+};
+
+static struct Tile tiles[NUM_TILES];
+
+/* Generator used between epochs to hand out ticks */
+static struct RandomState epochRng;
+
+/* Tile indices of each of the four colors */
+static uintptr_t tilesByColor[4][TILES_PER_COLOR];
+
+/* Order in which the colors run in the current epoch */
+static uintptr_t colorOrder[4];
+
+/* Next unclaimed tile of each phase */
+static atomic_uintptr_t nextTile[4];
+
+/* Set by the main thread to make the workers exit */
+static volatile int parallelQuit = 0;
+
+/* Workers meet here at the start and end of each phase */
+static pthread_barrier_t phaseBarrier;
+
+#endif /* PARALLEL_THREADS */
+
+/* ----------------------------------------------------------------------- */
+/* Checkpoints                                                             */
+/* ----------------------------------------------------------------------- */
+
+#define CHECKPOINT_MAGIC "NPONDCKP"
+#define CHECKPOINT_VERSION 4
+
+/* The pond starts at a multiple of this in the file, so that it can be
+ * mapped on any page size up to this */
+#define CHECKPOINT_ALIGN 65536
+
+#if (defined(CHECKPOINT_FREQUENCY) && (PARALLEL_THREADS > 0) && (CHECKPOINT_FREQUENCY % PARALLEL_EPOCH))
+#error "PARALLEL_EPOCH must divide CHECKPOINT_FREQUENCY"
+#endif
+
+/**
+ * Checkpoint file header
+ *
+ * It is followed by NUM_WORKERS CheckpointWorker records, then (for the
+ * parallel engine) the epoch generator and the NUM_TILES tiles, then the
+ * pond memory itself at pondOffset, then (for GENOME_POOL) the first
+ * genomePoolUsed blocks of the genome pool, then (for
+ * ACTIVE_SET_SCHEDULER) the activeCount entries of activeCells in their
+ * order, which the next pick depends on. Everything is in the byte order and
+ * structure layout of the build that wrote it; a checkpoint can only be
+ * restored by a build with the same options, which the fields up to
+ * pondBytes check.
+ */
+struct CheckpointHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t headerBytes;
+
+  uint32_t pondSizeX, pondSizeY, pondDepth, ramSize;
+  uint32_t layoutSoa, pondOrder, rngBackend, numWorkers;
+  uint32_t numTiles, deterministic, mutationSkipAhead, loopJumpTable;
+  uint32_t workerBytes, tileBytes, rngBytes, statBytes;
+  uint32_t genomePool, genomeBlockBytes, activeSet;
+
+  uint64_t pondOffset;
+  uint64_t pondBytes;
+
+  /* The clock value whose housekeeping had just been done */
+  uint64_t clock;
+
+  uint64_t totalEnergy;
+  uint64_t maxCellEnergy;
+  uint64_t maxLivingCellEnergy;
+  uint64_t lastTotalViableReplicators;
+  uint64_t colorScheme;
+  uint64_t genomePoolUsed;
+  uint64_t genomePoolFree;
+  uint64_t activeCount;
+  uint64_t activeSkip;
+  struct PerReportStatCounters statCounters;
+};
+
+/**
+ * State of one worker in a checkpoint
+ */
+struct CheckpointWorker
+{
+  struct RandomState rng;
+  struct CellIdCounter ids;
+  struct PerReportStatCounters stats;
+  uint64_t mutationCountdown;
+};
+
+#if (PARALLEL_THREADS > 0)
+#define CHECKPOINT_PARALLEL_BYTES (sizeof(struct RandomState) + (NUM_TILES * sizeof(struct Tile)))
+#else
+#define CHECKPOINT_PARALLEL_BYTES 0
+#endif
+
+#define CHECKPOINT_POND_OFFSET \
+  ((((sizeof(struct CheckpointHeader) + (NUM_WORKERS * sizeof(struct CheckpointWorker)) + CHECKPOINT_PARALLEL_BYTES) \
+     + CHECKPOINT_ALIGN - 1) / CHECKPOINT_ALIGN) * CHECKPOINT_ALIGN)
+
+/* Clock value of a restored checkpoint, whose housekeeping was done
+ * before it was written */
+static POND_STATE uint64_t resumeClock = UINT64_MAX;
+
+/**
+ * Fill in a checkpoint header for this build
+ *
+ * @param h Header
+ * @param clock Clock value
+ */
+static void fillCheckpointHeader(struct CheckpointHeader *const h, const uint64_t clock)
+{
+  memset(h, 0, sizeof(struct CheckpointHeader));
+  memcpy(h->magic, CHECKPOINT_MAGIC, sizeof(h->magic));
+  h->version = CHECKPOINT_VERSION;
+  h->headerBytes = sizeof(struct CheckpointHeader);
+  h->pondSizeX = POND_SIZE_X;
+  h->pondSizeY = POND_SIZE_Y;
+  h->pondDepth = POND_DEPTH;
+  h->ramSize = RAM_SIZE;
+  h->layoutSoa = POND_LAYOUT_SOA;
+  h->pondOrder = POND_ORDER;
+  h->rngBackend = RNG_BACKEND;
+  h->numWorkers = NUM_WORKERS;
+#if (PARALLEL_THREADS > 0)
+  h->numTiles = NUM_TILES;
+  h->tileBytes = sizeof(struct Tile);
+#endif
+  h->deterministic = PARALLEL_DETERMINISTIC;
+  h->mutationSkipAhead = MUTATION_SKIP_AHEAD;
+  h->loopJumpTable = LOOP_JUMP_TABLE;
+  h->workerBytes = sizeof(struct CheckpointWorker);
+  h->rngBytes = sizeof(struct RandomState);
+  h->statBytes = sizeof(struct PerReportStatCounters);
+#if GENOME_POOL
+  h->genomePool = 1;
+  h->genomeBlockBytes = sizeof(struct GenomeBlock);
+#endif
+  h->activeSet = ACTIVE_SET_SCHEDULER;
+  h->pondOffset = CHECKPOINT_POND_OFFSET;
+  h->pondBytes = POND_BYTES;
+
+  h->clock = clock;
+  h->totalEnergy = totalEnergy;
+  h->maxCellEnergy = maxCellEnergy;
+  h->maxLivingCellEnergy = maxLivingCellEnergy;
+  h->lastTotalViableReplicators = lastTotalViableReplicators;
+  h->colorScheme = (uint64_t)colorScheme;
+#if GENOME_POOL
+  h->genomePoolUsed = genomePoolUsed;
+  h->genomePoolFree = genomePoolFree;
+#endif
+#if ACTIVE_SET_SCHEDULER
+  h->activeCount = activeCount;
+  h->activeSkip = activeSkip;
+#endif
+  h->statCounters = statCounters;
+}
+
+/**
+ * Write all of a buffer to a file descriptor
+ *
+ * @param fd File descriptor
+ * @param p Data
+ * @param n Number of bytes
+ * @return 0 on success, -1 on error
+ */
+static int writeAll(const int fd, const void *p, size_t n)
+{
+  const uint8_t *b = (const uint8_t *)p;
+  while (n) {
+    const ssize_t k = write(fd, b, n);
+    if (k < 0) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    b += k;
+    n -= (size_t)k;
+  }
+  return 0;
+}
+
+/**
+ * Write a checkpoint of the whole simulation
+ *
+ * This normally runs in a forked child, so it only uses plain system
+ * calls, and writes the parent's memory as it was at the fork. The file
+ * is written under a temporary name and renamed once it is complete.
+ *
+ * @param path File to write
+ * @param tmpPath Temporary name to write it under
+ * @param clock Clock value
+ * @return 0 on success, -1 on error
+ */
+static int writeCheckpoint(const char *path, const char *tmpPath, const uint64_t clock)
+{
+  struct CheckpointHeader h;
+  struct CheckpointWorker cw;
+  uintptr_t k;
+  int fd;
+
+  fd = open(tmpPath, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+  if (fd < 0)
+    return -1;
+
+  fillCheckpointHeader(&h, clock);
+  if (writeAll(fd, &h, sizeof(h)))
+    goto fail;
+  for(k=0;k<NUM_WORKERS;++k) {
+    memset(&cw, 0, sizeof(cw));
+    cw.rng = workers[k].ownRng;
+    cw.ids = workers[k].ownIds;
+    cw.stats = workers[k].stats;
+#if MUTATION_SKIP_AHEAD
+    cw.mutationCountdown = workers[k].mutationCountdown;
+#endif
+    if (writeAll(fd, &cw, sizeof(cw)))
+      goto fail;
+  }
+#if (PARALLEL_THREADS > 0)
+  if (writeAll(fd, &epochRng, sizeof(epochRng)) || writeAll(fd, tiles, sizeof(tiles)))
+    goto fail;
+#endif
+  if ((lseek(fd, (off_t)CHECKPOINT_POND_OFFSET, SEEK_SET) < 0) || writeAll(fd, pondMemory, POND_BYTES))
+    goto fail;
+#if GENOME_POOL
+  if (writeAll(fd, genomePool, (size_t)genomePoolUsed * sizeof(struct GenomeBlock)))
+    goto fail;
+#endif
+#if ACTIVE_SET_SCHEDULER
+  if (writeAll(fd, activeCells, activeCount * sizeof(uint32_t)))
+    goto fail;
+#endif
+  if (fsync(fd) || close(fd))
+    return -1;
+  return rename(tmpPath, path);
+
+fail:
+  close(fd);
+  return -1;
+}
+
+#ifdef CHECKPOINT_FREQUENCY
+
+/* Process writing the last checkpoint, if still running */
+static POND_STATE pid_t checkpointChild = 0;
+
+/**
+ * Reap the process writing the last checkpoint
+ *
+ * @param block Nonzero to wait for it to finish
+ * @return Nonzero if it is still running
+ */
+static int finishCheckpoint(const int block)
+{
+  int status;
+  pid_t p;
+
+  if (checkpointChild <= 0)
+    return 0;
+  p = waitpid(checkpointChild, &status, block ? 0 : WNOHANG);
+  if (p == 0)
+    return 1;
+  if ((p < 0)||(!WIFEXITED(status))||(WEXITSTATUS(status)))
+    fprintf(stderr,"[WARNING] Writing the last checkpoint failed.\n");
+  checkpointChild = 0;
+  return 0;
+}
+
+/**
+ * Checkpoint the simulation to a file called <clock>.checkpoint
+ *
+ * The file is written by a forked copy of the process, so the main loop
+ * only stalls for the fork itself; copy-on-write keeps the child's view
+ * of the pond as it was. Must be called while no workers are running.
+ *
+ * @param clock Clock value
+ */
+static void doCheckpoint(const uint64_t clock)
+{
+  char path[320], tmpPath[336];
+  pid_t p;
+
+  if (finishCheckpoint(0)) {
+    fprintf(stderr,"[WARNING] Previous checkpoint is still being written, skipping checkpoint at %ju.\n", (uintmax_t)clock);
+    return;
+  }
+
+  sprintf(path,"%s%ju.checkpoint", config.outputPrefix, (uintmax_t)clock);
+  sprintf(tmpPath,"%s.tmp", path);
+  fprintf(stderr,"[INFO] Writing checkpoint to %s\n",path);
+  fflush(stdout);
+  fflush(stderr);
+
+  p = fork();
+  if (p == 0)
+    _exit(writeCheckpoint(path, tmpPath, clock) ? 1 : 0);
+  if (p > 0)
+    checkpointChild = p;
+  else if (writeCheckpoint(path, tmpPath, clock)) /* No fork, so write it here */
+    fprintf(stderr,"[WARNING] Could not write %s.\n", path);
+}
+
+#endif /* CHECKPOINT_FREQUENCY */
+
+/**
+ * Read all of a buffer from a file descriptor
+ *
+ * @param fd File descriptor
+ * @param p Buffer
+ * @param n Number of bytes
+ * @return 0 on success, -1 on error or end of file
+ */
+static int readAll(const int fd, void *p, size_t n)
+{
+  uint8_t *b = (uint8_t *)p;
+  while (n) {
+    const ssize_t k = read(fd, b, n);
+    if (k < 0) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    if (k == 0)
+      return -1;
+    b += k;
+    n -= (size_t)k;
+  }
+  return 0;
+}
+
+/**
+ * Restore the simulation from a checkpoint
+ *
+ * The pond is mapped straight from the file (privately, so the file is
+ * never changed) and paged in as it is touched, so this takes about as
+ * long as reading the header.
+ *
+ * @param path Checkpoint file
+ * @param clock Set to the checkpoint's clock value
+ * @return 0 on success, -1 on error (with a message printed)
+ */
+static int restoreCheckpoint(const char *path, uint64_t *const clock)
+{
+  struct CheckpointHeader h, expected;
+  struct CheckpointWorker cw;
+  struct stat st;
+  uint64_t need;
+  uintptr_t k;
+#if GENOME_POOL
+  uint8_t *linked;
+#endif
+  void *p;
+  int fd;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr,"*** Unable to open checkpoint %s ***\n", path);
+    return -1;
+  }
+  fillCheckpointHeader(&expected, 0);
+  if (readAll(fd, &h, sizeof(h))) {
+    fprintf(stderr,"*** Unable to read checkpoint %s ***\n", path);
+    goto fail;
+  }
+  if (memcmp(&h, &expected, offsetof(struct CheckpointHeader, clock))) {
+    fprintf(stderr,"*** %s is not a checkpoint from a build with the same options ***\n", path);
+    goto fail;
+  }
+
+  /* The pond is mapped from the file, so a truncated checkpoint has to
+   * be caught here; touching a page past its end would be a SIGBUS. */
+  need = h.pondOffset + POND_BYTES;
+#if GENOME_POOL
+  if (h.genomePoolUsed <= GENOME_POOL_BLOCKS)
+    need += h.genomePoolUsed * (uint64_t)sizeof(struct GenomeBlock);
+#endif
+#if ACTIVE_SET_SCHEDULER
+  if (h.activeCount <= POND_CELLS)
+    need += h.activeCount * (uint64_t)sizeof(uint32_t);
+#endif
+  if ((fstat(fd, &st))||((uint64_t)st.st_size < need)) {
+    fprintf(stderr,"*** Checkpoint %s is truncated ***\n", path);
+    goto fail;
+  }
+
+  for(k=0;k<NUM_WORKERS;++k) {
+    if (readAll(fd, &cw, sizeof(cw))) {
+      fprintf(stderr,"*** Unable to read checkpoint %s ***\n", path);
+      goto fail;
+    }
+    workers[k].ownRng = cw.rng;
+    workers[k].ownIds = cw.ids;
+    workers[k].stats = cw.stats;
+#if MUTATION_SKIP_AHEAD
+    workers[k].mutationCountdown = (uintptr_t)cw.mutationCountdown;
+#endif
+    workers[k].rng = &workers[k].ownRng;
+    workers[k].ids = &workers[k].ownIds;
+  }
+#if (PARALLEL_THREADS > 0)
+  if (readAll(fd, &epochRng, sizeof(epochRng)) || readAll(fd, tiles, sizeof(tiles))) {
+    fprintf(stderr,"*** Unable to read checkpoint %s ***\n", path);
+    goto fail;
+  }
+#endif
+#if GENOME_POOL
+  /* Read the used part of the genome pool, whose blocks still link up
+   * the free list and the hash chains. A chain starts at the one block
+   * of it that no other block links to. */
+  if ((h.genomePoolUsed < 1) || (h.genomePoolUsed > GENOME_POOL_BLOCKS) || (h.genomePoolFree >= h.genomePoolUsed) ||
+      allocGenomePool()) {
+    fprintf(stderr,"*** Unable to restore the genome pool from checkpoint %s ***\n", path);
+    goto fail;
+  }
+  if ((lseek(fd, (off_t)(h.pondOffset + POND_BYTES), SEEK_SET) < 0) ||
+      readAll(fd, genomePool, (size_t)h.genomePoolUsed * sizeof(struct GenomeBlock))) {
+    fprintf(stderr,"*** Unable to read checkpoint %s ***\n", path);
+    releaseGenomePool();
+    goto fail;
+  }
+  genomePoolUsed = (uint32_t)h.genomePoolUsed;
+  genomePoolFree = (uint32_t)h.genomePoolFree;
+  linked = (uint8_t *)calloc(genomePoolUsed, 1);
+  if (!linked) {
+    fprintf(stderr,"*** Unable to allocate memory ***\n");
+    releaseGenomePool();
+    goto fail;
+  }
+  for(k=1;k<genomePoolUsed;++k) {
+    if ((genomePool[k].refs)&&(genomePool[k].interned)&&(genomePool[k].next < genomePoolUsed))
+      linked[genomePool[k].next] = 1;
+  }
+  for(k=1;k<genomePoolUsed;++k) {
+    if ((genomePool[k].refs)&&(genomePool[k].interned)&&(!linked[k]))
+      *genomePoolBucket(genomePool[k].hash) = (uint32_t)k;
+  }
+  free(linked);
+#endif
+
+  p = mmap((void *)0, POND_BYTES, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, (off_t)h.pondOffset);
+  if (p == MAP_FAILED) {
+    fprintf(stderr,"*** Unable to map the pond from checkpoint %s ***\n", path);
+    goto fail;
+  }
+  setPondMemory((uint8_t *)p);
+
+#if ACTIVE_SET_SCHEDULER
+  /* The active set has to come back in the order it had, and hold just
+   * the cells with energy, each once */
+  if (allocActiveSet()) {
+    fprintf(stderr,"*** Unable to allocate the active set ***\n");
+    goto fail;
+  }
+  if ((h.activeCount > POND_CELLS) ||
+      (lseek(fd, (off_t)(need - (h.activeCount * sizeof(uint32_t))), SEEK_SET) < 0) ||
+      readAll(fd, activeCells, (size_t)h.activeCount * sizeof(uint32_t))) {
+    fprintf(stderr,"*** Unable to read checkpoint %s ***\n", path);
+    goto fail;
+  }
+  for(k=0;k<h.activeCount;++k) {
+    const uint32_t c = activeCells[k];
+    if ((c >= POND_CELLS)||(activePosition[c] != ACTIVE_NONE)||(!CELL_ENERGY(c))) {
+      fprintf(stderr,"*** Checkpoint %s has a broken active set ***\n", path);
+      goto fail;
+    }
+    activePosition[c] = (uint32_t)k;
+  }
+  activeCount = (uintptr_t)h.activeCount;
+  for(k=0;k<POND_CELLS;++k) {
+    if (CELL_ENERGY(k) && (activePosition[k] == ACTIVE_NONE)) {
+      fprintf(stderr,"*** Checkpoint %s has a broken active set ***\n", path);
+      goto fail;
+    }
+  }
+  activeSkip = h.activeSkip;
+#endif
+  close(fd);
+
+  *clock = h.clock;
+  resumeClock = h.clock;
+  totalEnergy = (uintptr_t)h.totalEnergy;
+  maxCellEnergy = (uintptr_t)h.maxCellEnergy;
+  maxLivingCellEnergy = (uintptr_t)h.maxLivingCellEnergy;
+  lastTotalViableReplicators = h.lastTotalViableReplicators;
+  colorScheme = (int)h.colorScheme;
+  statCounters = h.statCounters;
+
+  fprintf(stderr,"[INFO] Restored checkpoint %s at clock %ju\n", path, (uintmax_t)h.clock);
+  return 0;
+
+fail:
+  close(fd);
+  return -1;
+}
+
+#ifdef USE_SDL
+
+/* ----------------------------------------------------------------------- */
+/* Display                                                                 */
+/* ----------------------------------------------------------------------- */
+
+/*
+ * The window belongs to the main thread, which services it from the
+ * housekeeping every REFRESH_FREQUENCY ticks: it handles the events,
+ * uploads whatever frame is ready and asks for the next one. It never
+ * waits for a frame. The display thread only works out the colors,
+ * straight from the pond while the simulation carries on (so a frame can
+ * mix cells from before and after an execution, which is harmless for a
+ * picture). It keeps the colors of the last frame and hands over the
+ * pixels with, for each band of DISPLAY_BAND_ROWS rows, the columns that
+ * changed; only those parts are uploaded to the texture.
+ */
+
+/* Rows per band for dirty rectangles */
+#define DISPLAY_BAND_ROWS 16
+#define DISPLAY_BANDS ((POND_SIZE_Y + DISPLAY_BAND_ROWS - 1) / DISPLAY_BAND_ROWS)
+
+/* How long the display thread sleeps between looks for a request (ms) */
+#define DISPLAY_POLL_MS 10
+
+static pthread_t displayThread;
+static SDL_Window *displayWindow = (SDL_Window *)0;
+static SDL_Renderer *displayRenderer = (SDL_Renderer *)0;
+static SDL_Texture *displayTexture = (SDL_Texture *)0;
+
+/* 1 while the display thread runs (set to 0 to stop it) */
+static atomic_int displayRunning;
+
+/* Bumped by the main thread when it wants a new frame */
+static atomic_uint_fast64_t displayRequests;
+
+/* Set by the display thread once the frame below is complete, and
+ * cleared by the main thread once it has been uploaded. Whichever side
+ * does not own the frame leaves it alone. */
+static atomic_int displayReady;
+
+/* The frame being handed over: ARGB8888 pixels in screen order, and the
+ * changed columns of each band (none if the first is past the last) */
+static uint32_t displayPixels[POND_SIZE_X * POND_SIZE_Y];
+static uintptr_t displayMinX[DISPLAY_BANDS], displayMaxX[DISPLAY_BANDS];
+
+/**
+ * Fill in the 8-bit palette SDL 1.2 gave the original 8-bit window
+ *
+ * @param palette 256 ARGB8888 colors
+ */
+static void initDisplayPalette(uint32_t *const palette)
+{
+  uint32_t i, r, g, b;
+  for(i=0;i<256;++i) {
+    r = i & 0xe0;
+    r |= (r >> 3) | (r >> 6);
+    g = (i << 3) & 0xe0;
+    g |= (g >> 3) | (g >> 6);
+    b = i & 0x03;
+    b |= b << 2;
+    b |= b << 4;
+    palette[i] = 0xff000000 | (r << 16) | (g << 8) | b;
+  }
+}
+
+/**
+ * Display thread main: build a frame for each request
+ *
+ * @param arg Colors of the last frame, one byte per cell in screen order
+ * @return Nothing
+ */
+static void *displayMain(void *arg)
+{
+  uint8_t *const frame = (uint8_t *)arg;
+  static uint32_t palette[256];
+  uintptr_t i, c, x, y, b;
+  uint_fast64_t requested, drawn = 0;
+
+  initDisplayPalette(palette);
+  while (atomic_load(&displayRunning)) {
+    requested = atomic_load_explicit(&displayRequests, memory_order_acquire);
+    if ((requested == drawn)||(atomic_load_explicit(&displayReady, memory_order_acquire))) {
+      SDL_Delay(DISPLAY_POLL_MS);
+      continue;
+    }
+    drawn = requested;
+
+    /* Walk the pond in storage order rather than screen order */
+    for(b=0;b<DISPLAY_BANDS;++b) {
+      displayMinX[b] = POND_SIZE_X;
+      displayMaxX[b] = 0;
+    }
+    for(c=0;c<POND_CELLS;++c) {
+      const uint8_t color = getColor(c);
+      x = cellX(c);
+      y = cellY(c);
+      i = x + (y * POND_SIZE_X);
+      if (frame[i] != color) {
+        frame[i] = color;
+        displayPixels[i] = palette[color];
+        b = y / DISPLAY_BAND_ROWS;
+        if (x < displayMinX[b])
+          displayMinX[b] = x;
+        if (x > displayMaxX[b])
+          displayMaxX[b] = x;
+      }
+    }
+    atomic_store_explicit(&displayReady, 1, memory_order_release);
+  }
+
+  free(frame);
+  return (void *)0;
+}
+
+/**
+ * Open the window and start the display thread, exiting on failure
+ *
+ * This has to be called from the main thread, which then services the
+ * window with serviceDisplay().
+ */
+static void startDisplay()
+{
+  uint8_t *const frame = (uint8_t *)calloc(1, POND_SIZE_X * POND_SIZE_Y);
+  uint32_t palette[256];
+  uintptr_t i;
+
+  displayWindow = SDL_CreateWindow(SDL_TITLE, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, POND_SIZE_X, POND_SIZE_Y, 0);
+  displayRenderer = displayWindow ? SDL_CreateRenderer(displayWindow, -1, 0) : (SDL_Renderer *)0;
+  displayTexture = displayRenderer ? SDL_CreateTexture(displayRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, POND_SIZE_X, POND_SIZE_Y) : (SDL_Texture *)0;
+  if ((!frame)||(!displayTexture)) {
+    fprintf(stderr, "*** Unable to create SDL window: %s ***\n", SDL_GetError());
+    exit(1);
+  }
+
+  /* Start from an all-black texture to match the all-zero frame */
+  initDisplayPalette(palette);
+  for(i=0;i<(POND_SIZE_X * POND_SIZE_Y);++i)
+    displayPixels[i] = palette[0];
+  SDL_UpdateTexture(displayTexture, (const SDL_Rect *)0, displayPixels, POND_SIZE_X * sizeof(uint32_t));
+  SDL_RenderCopy(displayRenderer, displayTexture, (const SDL_Rect *)0, (const SDL_Rect *)0);
+  SDL_RenderPresent(displayRenderer);
+
+  atomic_store(&displayRunning, 1);
+  atomic_store(&displayRequests, 0);
+  atomic_store(&displayReady, 0);
+  if (pthread_create(&displayThread, (const pthread_attr_t *)0, displayMain, (void *)frame)) {
+    fprintf(stderr,"*** Unable to create display thread ***\n");
+    exit(1);
+  }
+}
+
+/**
+ * Handle the window's events, show the frame the display thread has
+ * handed over if there is one, and ask for the next (main thread only)
+ *
+ * @return Nonzero if the window was closed
+ */
+static int serviceDisplay()
+{
+  SDL_Event sdlEvent;
+  SDL_Rect rect;
+  uintptr_t b, tmpcell;
+  int present = 0, quit = 0;
+
+  while (SDL_PollEvent(&sdlEvent)) {
+    if (sdlEvent.type == SDL_QUIT) {
+      quit = 1;
+    } else if ((sdlEvent.type == SDL_WINDOWEVENT)&&(sdlEvent.window.event == SDL_WINDOWEVENT_EXPOSED)) {
+      present = 1;
+    } else if (sdlEvent.type == SDL_MOUSEBUTTONDOWN) {
+      switch (sdlEvent.button.button) {
+        case SDL_BUTTON_LEFT:
+          if ((sdlEvent.button.x >= 0)&&(sdlEvent.button.x < POND_SIZE_X)&&(sdlEvent.button.y >= 0)&&(sdlEvent.button.y < POND_SIZE_Y)) {
+            tmpcell = cellIndex((uintptr_t)sdlEvent.button.x, (uintptr_t)sdlEvent.button.y);
+            if (CELL_ENERGY(tmpcell) && (CELL_GENERATION(tmpcell) > 2)) {
+              fprintf(stderr,"[INTERFACE] Genome of cell at (%d, %d):\n", sdlEvent.button.x, sdlEvent.button.y);
+              dumpCell(stderr, tmpcell);
+            }
           }
-          return (uint8_t)((sum & 0x7f) + 128);
-        }
-        return 0;
-      case MAX_COLOR_SCHEME:
-        /* ... never used... to make compiler shut up. */
+          break;
+        case SDL_BUTTON_RIGHT:
+          colorScheme = (colorScheme + 1) % MAX_COLOR_SCHEME;
+          fprintf(stderr,"[INTERFACE] Switching to color scheme \"%s\".\n",colorSchemeName[colorScheme]);
+          break;
+      }
+    }
+  }
+
+  if (atomic_load_explicit(&displayReady, memory_order_acquire)) {
+    for(b=0;b<DISPLAY_BANDS;++b) {
+      if (displayMinX[b] > displayMaxX[b])
+        continue;
+      rect.x = (int)displayMinX[b];
+      rect.y = (int)(b * DISPLAY_BAND_ROWS);
+      rect.w = (int)(displayMaxX[b] - displayMinX[b] + 1);
+      rect.h = (int)(((POND_SIZE_Y - (b * DISPLAY_BAND_ROWS)) < DISPLAY_BAND_ROWS) ? (POND_SIZE_Y - (b * DISPLAY_BAND_ROWS)) : DISPLAY_BAND_ROWS);
+      SDL_UpdateTexture(displayTexture, &rect, displayPixels + (uintptr_t)rect.x + ((uintptr_t)rect.y * POND_SIZE_X), POND_SIZE_X * sizeof(uint32_t));
+      present = 1;
+    }
+    atomic_store_explicit(&displayReady, 0, memory_order_release);
+  }
+  if (present) {
+    SDL_RenderCopy(displayRenderer, displayTexture, (const SDL_Rect *)0, (const SDL_Rect *)0);
+    SDL_RenderPresent(displayRenderer);
+  }
+
+  /* The display thread picks this up; nothing here waits for it */
+  atomic_fetch_add_explicit(&displayRequests, 1, memory_order_release);
+  return quit;
+}
+
+/**
+ * Stop the display thread and close the window (registered with atexit)
+ */
+static void stopDisplay()
+{
+  if (atomic_load(&displayRunning)) {
+    atomic_store(&displayRunning, 0);
+    pthread_join(displayThread, (void **)0);
+  }
+  if (displayTexture)
+    SDL_DestroyTexture(displayTexture);
+  if (displayRenderer)
+    SDL_DestroyRenderer(displayRenderer);
+  if (displayWindow)
+    SDL_DestroyWindow(displayWindow);
+  displayTexture = (SDL_Texture *)0;
+  displayRenderer = (SDL_Renderer *)0;
+  displayWindow = (SDL_Window *)0;
+}
+
+#endif /* USE_SDL */
+
+
+/* Time at which the main loop started, and the clock value and the
+ * number of instructions executed (see instructionCount()) then */
+static POND_STATE struct timespec startTime;
+static POND_STATE uint64_t startClock = 0;
+static POND_STATE uint64_t startInstructions = 0;
+
+/* Clock value at which the main loop stopped */
+static POND_STATE uint64_t stopClock = 0;
+
+/**
+ * Get the time since the main loop started
+ *
+ * @return Wall clock seconds
+ */
+static double elapsedSeconds()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)(now.tv_sec - startTime.tv_sec) + ((double)(now.tv_nsec - startTime.tv_nsec) / 1.0e9);
+}
+
+/**
+ * Get the number of instructions executed so far, including those not
+ * yet in a report (call while no workers are running)
+ *
+ * @return Instructions executed
+ */
+static uint64_t instructionCount()
+{
+  uint64_t n = instructionsExecuted;
+  uintptr_t i, k;
+  for(i=0;i<NUM_INST;++i) {
+    n += statCounters.instructionExecutions[i];
+    for(k=0;k<NUM_WORKERS;++k)
+      n += workers[k].stats.instructionExecutions[i];
+  }
+  return n;
+}
+
+/**
+ * Do the periodic work that happens between cell executions: stopping at
+ * STOP_AT, reports, screen refreshes and dumps
+ *
+ * @param clock Current clock
+ * @return Nonzero if the simulation should stop
+ */
+static int doHousekeeping(const uint64_t clock)
+{
+#if BIRTH_LOG
+  birthClock = clock;
+#endif
+#if EXEC_TRACE
+  traceClock = clock;
+#endif
+
+  /* Resuming from a checkpoint taken right after this clock's housekeeping */
+  if (clock == resumeClock)
+    return 0;
+
+  /* Stop at STOP_AT (config.stopAt) if set */
+  if (clock >= config.stopAt) {
+    /* Also do a final dump if dumps are enabled */
+#ifdef DUMP_FREQUENCY
+    doDump(clock);
+    finishDump();
+#endif /* DUMP_FREQUENCY */
+    fprintf(stderr,"[QUIT] STOP_AT clock value reached\n");
+    /* Every tick is one cell execution (the bench script reads this) */
+#ifdef CHECKPOINT_FREQUENCY
+    finishCheckpoint(1);
+#endif
+    fprintf(stderr,"[INFO] %.0f cell executions/sec\n",(double)(clock - startClock) / elapsedSeconds());
+    stopClock = clock;
+    return 1;
+  }
+
+  /* Increment clock and run reports periodically */
+  /* Clock is incremented at the start, so it starts at 1 */
+  if (!(clock % REPORT_FREQUENCY)) {
+    const double t = elapsedSeconds();
+    doReport(clock);
+#if EXEC_TRACE
+    flushTraces();
+#endif
+    reportSeconds += elapsedSeconds() - t;
+    ++reportCount;
+  }
+  /* SDL display is also refreshed every REFRESH_FREQUENCY */
+#ifdef USE_SDL
+  if (!(clock % REFRESH_FREQUENCY)) {
+    if (serviceDisplay()) {
+      fprintf(stderr,"[QUIT] Quit signal received!\n");
+#ifdef DUMP_FREQUENCY
+      finishDump();
+#endif
+#ifdef CHECKPOINT_FREQUENCY
+      finishCheckpoint(1);
+#endif
+#if TELEMETRY
+      stopTelemetry();
+#endif
+#if BIRTH_LOG
+      closeBirthLog();
+#endif
+#if EXEC_TRACE
+      closeTraceLog();
+#endif
+      exit(0);
+    }
+  }
+#endif /* USE_SDL */
+
+  /* Periodically dump the viable population if defined */
+#ifdef DUMP_FREQUENCY
+  if (!(clock % DUMP_FREQUENCY))
+    doDump(clock);
+#endif /* DUMP_FREQUENCY */
+
+  /* Checkpoints come last, so a restored run picks up right after */
+#ifdef CHECKPOINT_FREQUENCY
+  if (!(clock % CHECKPOINT_FREQUENCY))
+    doCheckpoint(clock);
+#endif /* CHECKPOINT_FREQUENCY */
+
+  return 0;
+}
+
+#if (PARALLEL_THREADS > 0)
+
+/* ----------------------------------------------------------------------- */
+/* Parallel tile engine                                                    */
+/* ----------------------------------------------------------------------- */
+
+/**
+ * Run the executions and inflows a tile was assigned for this epoch
+ *
+ * @param w Worker
+ * @param t Tile
+ */
+static void runTile(struct Worker *const w, struct Tile *const t)
+{
+  uintptr_t i, inflowsDone = 0;
+  const uintptr_t n = t->executions, m = t->inflows;
+
+#if PARALLEL_DETERMINISTIC
+  w->rng = &t->rng;
+  w->ids = &t->ids;
+#if MUTATION_SKIP_AHEAD
+  w->mutationCountdown = t->mutationCountdown;
+#endif
+#endif
+
+  /* Inflows are spread evenly over the tile's executions, just as every
+   * INFLOW_FREQUENCY'th tick has one in the serial engine. */
+  for(i=0;i<n;++i) {
+    if ((inflowsDone < m)&&((i * m) >= (inflowsDone * n))) {
+      seedCell(w, t->x0 + (getRandom(w->rng) % TILE_SIZE_X), t->y0 + (getRandom(w->rng) % TILE_SIZE_Y));
+      ++inflowsDone;
+    }
+    execCell(w, t->x0 + (getRandom(w->rng) % TILE_SIZE_X), t->y0 + (getRandom(w->rng) % TILE_SIZE_Y));
+  }
+  for(;inflowsDone<m;++inflowsDone)
+    seedCell(w, t->x0 + (getRandom(w->rng) % TILE_SIZE_X), t->y0 + (getRandom(w->rng) % TILE_SIZE_Y));
+
+#if (PARALLEL_DETERMINISTIC && MUTATION_SKIP_AHEAD)
+  t->mutationCountdown = w->mutationCountdown;
+#endif
+}
+
+/**
+ * Run the four color phases of one epoch
+ *
+ * @param w Worker
+ */
+static void runEpoch(struct Worker *const w)
+{
+  uintptr_t phase, k;
+  for(phase=0;phase<4;++phase) {
+    const uintptr_t color = colorOrder[phase];
+    while ((k = atomic_fetch_add_explicit(&nextTile[phase], 1, memory_order_relaxed)) < TILES_PER_COLOR)
+      runTile(w, &tiles[tilesByColor[color][k]]);
+    pthread_barrier_wait(&phaseBarrier);
+  }
+}
+
+/**
+ * Worker thread main
+ *
+ * @param arg Worker
+ */
+static void *workerMain(void *arg)
+{
+  struct Worker *const w = (struct Worker *)arg;
+  for(;;) {
+    pthread_barrier_wait(&phaseBarrier);
+    if (parallelQuit)
+      break;
+    runEpoch(w);
+  }
+  return (void *)0;
+}
+
+/**
+ * Main loop of the parallel engine, run by the main thread (worker 0)
+ *
+ * @param clock Starting clock
+ */
+static void runParallel(uint64_t clock, const int restored)
+{
+  struct Worker *const w = &workers[0];
+  struct RandomState *const r = &epochRng;
+  uintptr_t i, k, tx, ty, color, count[4];
+
+  /* Everything is seeded from the main generator seeded by INIT_SEED,
+   * unless it all came from a checkpoint */
+  if (!restored)
+    initRandom(r, getRandom(w->rng));
+
+  for(i=0;i<4;++i)
+    count[i] = 0;
+  for(tx=0;tx<PARALLEL_TILES_X;++tx) {
+    for(ty=0;ty<PARALLEL_TILES_Y;++ty) {
+      i = tx + (ty * PARALLEL_TILES_X);
+      tiles[i].x0 = tx * TILE_SIZE_X;
+      tiles[i].y0 = ty * TILE_SIZE_Y;
+      color = (tx & 1) | ((ty & 1) << 1);
+      tilesByColor[color][count[color]++] = i;
+#if PARALLEL_DETERMINISTIC
+      if (restored)
+        continue;
+      initRandom(&tiles[i].rng, getRandom(r));
+#if MUTATION_SKIP_AHEAD
+      tiles[i].mutationCountdown = nextMutationDistance(&tiles[i].rng);
+#endif
+      tiles[i].ids.next = i;
+      tiles[i].ids.stride = NUM_TILES;
+#endif
+    }
+  }
+  for(k=0;(k<NUM_WORKERS)&&(!restored);++k) {
+    /* (These come from the main generator so that handing out ticks and
+     * seeding the tiles doesn't depend on the number of workers.) */
+    initRandom(&workers[k].ownRng, getRandom(w->rng));
+#if MUTATION_SKIP_AHEAD
+    workers[k].mutationCountdown = nextMutationDistance(&workers[k].ownRng);
+#endif
+    workers[k].rng = &workers[k].ownRng;
+    workers[k].ownIds.next = k;
+    workers[k].ownIds.stride = NUM_WORKERS;
+    workers[k].ids = &workers[k].ownIds;
+  }
+
+  pthread_barrier_init(&phaseBarrier, (const pthread_barrierattr_t *)0, NUM_WORKERS);
+  for(k=1;k<NUM_WORKERS;++k) {
+    if (pthread_create(&workers[k].thread, (const pthread_attr_t *)0, workerMain, &workers[k])) {
+      fprintf(stderr,"*** Unable to create worker thread ***\n");
+      exit(1);
+    }
+  }
+
+  for(;;clock+=PARALLEL_EPOCH) {
+#if INCREMENTAL_STATS
+    /* Keep the total energy seen by TOTAL_ENERGY_CAP at most an epoch
+     * behind */
+    mergePopulation(0);
+#endif
+    if (doHousekeeping(clock))
+      break;
+
+    /* Hand out the epoch's ticks: each tick picks a tile uniformly (all
+     * tiles are the same size, so this is a uniform pick of a cell) as
+     * does every INFLOW_FREQUENCY'th tick for its inflow. The tiles pick
+     * the cells themselves. */
+    for(i=0;i<NUM_TILES;++i) {
+      tiles[i].executions = 0;
+      tiles[i].inflows = 0;
+    }
+    for(i=0;i<PARALLEL_EPOCH;++i)
+      ++tiles[getRandom(r) % NUM_TILES].executions;
+    for(i=0;i<(PARALLEL_EPOCH / INFLOW_FREQUENCY);++i)
+      ++tiles[getRandom(r) % NUM_TILES].inflows;
+
+    /* Shuffle the color order so no color systematically goes first */
+    for(i=0;i<4;++i)
+      colorOrder[i] = i;
+    for(i=3;i>0;--i) {
+      k = getRandom(r) % (i + 1);
+      color = colorOrder[i];
+      colorOrder[i] = colorOrder[k];
+      colorOrder[k] = color;
+    }
+    for(i=0;i<4;++i)
+      atomic_store_explicit(&nextTile[i], 0, memory_order_relaxed);
+
+    pthread_barrier_wait(&phaseBarrier);
+    runEpoch(w);
+  }
+
+  parallelQuit = 1;
+  pthread_barrier_wait(&phaseBarrier);
+  for(k=1;k<NUM_WORKERS;++k)
+    pthread_join(workers[k].thread, (void **)0);
+  pthread_barrier_destroy(&phaseBarrier);
+}
+
+#endif /* PARALLEL_THREADS */
+
+#if (DISTRIBUTED_NODES > 0)
+
+/* ----------------------------------------------------------------------- */
+/* Distributed engine                                                      */
+/* ----------------------------------------------------------------------- */
+
+/*
+ * Each node runs its strip as a pond of DISTRIBUTED_ROWS + 4 rows laid
+ * out as described at NODE_HALO_TOP, the halo rows holding copies of the
+ * neighbors' border rows. Time goes in phases of DISTRIBUTED_PHASE
+ * ticks. In even phases every node runs only the upper half of its
+ * strip, and in odd phases only the lower half, so a cell that runs can
+ * reach its own halo but never a row that the neighbor is running at the
+ * same time. After an even phase a node sends its top halo (with any
+ * changes its cells made to it) and top row up, and gets the lower
+ * node's back as its bottom row and bottom halo; after an odd phase the
+ * same goes the other way. Every node thus always runs on an up to date
+ * copy of its neighbors' border rows, and the result is the same as if
+ * the rows had been shared.
+ */
+
+/* Magic number at the start of the hello nodes send each other */
+#define NODE_HELLO_MAGIC 0x4e504e4f44453031ULL /* "NPNODE01" */
+
+/**
+ * A cell as sent between nodes
+ */
+struct NodeCell
+{
+  uint64_t ID;
+  uint64_t parentID;
+  uint64_t lineage;
+  uint64_t generation;
+  uint64_t energy;
+  uint8_t logo;
+  uint8_t facing;
+  uint8_t genome[POND_DEPTH];
+  uint8_t ram[RAM_SIZE];
+};
+
+/**
+ * What two nodes send each other when they connect, to make sure they
+ * were built alike
+ */
+struct NodeHello
+{
+  uint64_t magic;
+  uint64_t rank;
+  uint64_t nodes;
+  uint64_t sizeX;
+  uint64_t rows;
+  uint64_t depth;
+  uint64_t ramSize;
+  uint64_t cellBytes;
+};
+
+/* Two rows of cells each way for nodeExchange() */
+static struct NodeCell *nodeSendRows = (struct NodeCell *)0;
+static struct NodeCell *nodeRecvRows = (struct NodeCell *)0;
+
+/* Clock of the last exchange */
+static uint64_t nodeLastExchange = 0;
+
+/**
+ * Fill in a hello for this node
+ *
+ * @param h Hello
+ */
+static void nodeHello(struct NodeHello *const h)
+{
+  memset(h, 0, sizeof(struct NodeHello));
+  h->magic = NODE_HELLO_MAGIC;
+  h->rank = (uint64_t)nodeRank;
+  h->nodes = DISTRIBUTED_NODES;
+  h->sizeX = POND_SIZE_X;
+  h->rows = DISTRIBUTED_ROWS;
+  h->depth = POND_DEPTH;
+  h->ramSize = RAM_SIZE;
+  h->cellBytes = sizeof(struct NodeCell);
+}
+
+/**
+ * Connect this node to the nodes above and below it in the ring
+ *
+ * The hosts file has a "<host> <port>" line for each node in order of
+ * rank (# starts a comment line). Each node listens on its own port,
+ * connects to the node below and accepts the node above, retrying the
+ * connection for a while since the nodes don't all start at once.
+ *
+ * @param rank This node's number
+ * @param path Hosts file
+ * @return 0 on success, 1 on failure
+ */
+static int nodeConnect(const int rank, const char *path)
+{
+  char hosts[DISTRIBUTED_NODES][256], ports[DISTRIBUTED_NODES][32], line[1024];
+  struct addrinfo hints, *ai, *a;
+  struct NodeHello mine, up, down;
+  uintptr_t n = 0, tries;
+  int listenFd = -1, one = 1;
+  FILE *f;
+
+  if ((rank < 0)||(rank >= DISTRIBUTED_NODES)) {
+    fprintf(stderr,"*** Node number must be from 0 to %d ***\n", DISTRIBUTED_NODES - 1);
+    return 1;
+  }
+  nodeRank = rank;
+
+  f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr,"*** Unable to open hosts file %s ***\n", path);
+    return 1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    if ((line[0] == '#')||(strspn(line, " \t\r\n") == strlen(line)))
+      continue;
+    if ((n >= DISTRIBUTED_NODES)||(sscanf(line, "%255s %31s", hosts[n], ports[n]) != 2)) {
+      fprintf(stderr,"*** %s must have a <host> <port> line for each of the %d nodes ***\n", path, DISTRIBUTED_NODES);
+      fclose(f);
+      return 1;
+    }
+    ++n;
+  }
+  fclose(f);
+  if (n != DISTRIBUTED_NODES) {
+    fprintf(stderr,"*** %s must have a <host> <port> line for each of the %d nodes ***\n", path, DISTRIBUTED_NODES);
+    return 1;
+  }
+
+  /* Listen for the node above */
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  if (getaddrinfo((const char *)0, ports[rank], &hints, &ai)) {
+    fprintf(stderr,"*** Unable to look up port %s ***\n", ports[rank]);
+    return 1;
+  }
+  for(a=ai;a;a=a->ai_next) {
+    listenFd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (listenFd < 0)
+      continue;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if ((!bind(listenFd, a->ai_addr, a->ai_addrlen))&&(!listen(listenFd, 1)))
+      break;
+    close(listenFd);
+    listenFd = -1;
+  }
+  freeaddrinfo(ai);
+  if (listenFd < 0) {
+    fprintf(stderr,"*** Unable to listen on port %s ***\n", ports[rank]);
+    return 1;
+  }
+
+  /* Connect to the node below */
+  n = (uintptr_t)(rank + 1) % DISTRIBUTED_NODES;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  for(tries=0;(nodeDown < 0)&&(tries<600);++tries) {
+    if (tries)
+      usleep(100000);
+    if (getaddrinfo(hosts[n], ports[n], &hints, &ai))
+      continue;
+    for(a=ai;a;a=a->ai_next) {
+      nodeDown = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+      if (nodeDown < 0)
+        continue;
+      if (!connect(nodeDown, a->ai_addr, a->ai_addrlen))
         break;
+      close(nodeDown);
+      nodeDown = -1;
     }
+    freeaddrinfo(ai);
+  }
+  if (nodeDown < 0) {
+    fprintf(stderr,"*** Unable to connect to node %ju at %s %s ***\n", (uintmax_t)n, hosts[n], ports[n]);
+    close(listenFd);
+    return 1;
   }
-  return 0; /* Cells with no energy are black */
-}
 
-static inline uint8_t read_mem(struct Cell *c, const uintptr_t x, const uintptr_t y, const uintptr_t ptr_mem)
-{
-    switch (ptr_mem) {
-        case 0x00: /* logo */
-            statCounters.memSpecialReads++;
-            return c->logo;
-        case 0x01: /* facing */
-            statCounters.memSpecialReads++;
-            return c->facing;
-        case 0x02: /* energy */
-            statCounters.memSpecialReads++;
-            if (c->energy == 0)
-                return 0;
-            else if (c->energy > 126975)
-                return 31;
-            else
-                return 1 + (c->energy >> 12); 
-        case 0x03:
-            return c->lineage & REG_MASK;
-        case 0x04:
-            return c->ID & REG_MASK;
-        case 0x05:
-            return c->parentID & REG_MASK;
-        case 0x06:
-            return (c->generation >> REG_BITS) & REG_MASK;
-        case 0x07:
-            return c->generation & REG_MASK;
-            break;
+  nodeUp = accept(listenFd, (struct sockaddr *)0, (socklen_t *)0);
+  close(listenFd);
+  if (nodeUp < 0) {
+    fprintf(stderr,"*** Unable to accept the connection from the node above ***\n");
+    return 1;
+  }
+  setsockopt(nodeDown, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  setsockopt(nodeUp, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  /* Check that both neighbors are who they should be and built alike */
+  nodeHello(&mine);
+  nodeTransfer(nodeDown, &mine, sizeof(mine), nodeUp, &up, sizeof(up));
+  nodeTransfer(nodeUp, &mine, sizeof(mine), nodeDown, &down, sizeof(down));
+  mine.rank = (uint64_t)((rank + DISTRIBUTED_NODES - 1) % DISTRIBUTED_NODES);
+  if (memcmp(&mine, &up, sizeof(mine))) {
+    fprintf(stderr,"*** The node above is not node %ju of the same build ***\n", (uintmax_t)mine.rank);
+    return 1;
+  }
+  mine.rank = (uint64_t)n;
+  if (memcmp(&mine, &down, sizeof(mine))) {
+    fprintf(stderr,"*** The node below is not node %ju of the same build ***\n", (uintmax_t)mine.rank);
+    return 1;
+  }
 
-        case 0x08: /* private RAM */
-        case 0x09:
-        case 0x0a:
-        case 0x0b:
-        case 0x0c:
-        case 0x0d:
-        case 0x0e:
-        case 0x0f:
-            statCounters.memPrivateReads++;
-            return c->ram[ptr_mem & 0x7];
+  fprintf(stderr,"[INFO] Node %d of %d connected\n", rank, DISTRIBUTED_NODES);
+  return 0;
+}
 
-        case 0x10: /* public RAM */
-        case 0x11:
-        case 0x12:
-        case 0x13:
-        case 0x14:
-        case 0x15:
-        case 0x16:
-        case 0x17:
-            statCounters.memOutputReads++;
-            return c->ram[8 + (ptr_mem & 0x7)];
+/**
+ * Copy two rows of this node's pond into cells to send
+ *
+ * @param y First row
+ * @param out POND_SIZE_X * 2 cells
+ */
+static void nodePackRows(const uintptr_t y, struct NodeCell *out)
+{
+  uintptr_t x, r, c;
+  for(r=0;r<2;++r) {
+    for(x=0;x<POND_SIZE_X;++x,++out) {
+      c = cellIndex(x, y + r);
+      out->ID = CELL_ID(c);
+      out->parentID = CELL_PARENT_ID(c);
+      out->lineage = CELL_LINEAGE(c);
+      out->generation = CELL_GENERATION(c);
+      out->energy = CELL_ENERGY(c);
+      out->logo = CELL_LOGO(c);
+      out->facing = CELL_FACING(c);
+#if GENOME_PACKED
+      genomeUnpack(CELL_GENOME_WORDS(c), out->genome);
+#else
+      memcpy(out->genome, CELL_GENOME(c), POND_DEPTH);
+#endif
+      memcpy(out->ram, CELL_RAM(c), RAM_SIZE);
+    }
+  }
+}
 
-        case 0x18: /* neighbor (facing) public ram */
-        case 0x19:
-        case 0x1a:
-        case 0x1b:
-        case 0x1c:
-        case 0x1d:
-        case 0x1e:
-        case 0x1f:
-            {
-                statCounters.memInputReads++;
-                struct Cell *tmpptr = getNeighbor(x, y, c->facing);
-                return tmpptr->ram[8 + (ptr_mem & 0x7)];
-            }
+/**
+ * Replace two rows of this node's pond with cells received
+ *
+ * @param w Worker
+ * @param y First row
+ * @param in POND_SIZE_X * 2 cells
+ */
+static void nodeUnpackRows(struct Worker *const w, const uintptr_t y, const struct NodeCell *in)
+{
+  uintptr_t x, r, c;
+  for(r=0;r<2;++r) {
+    for(x=0;x<POND_SIZE_X;++x,++in) {
+      c = cellIndex(x, y + r);
+      populationRemove(w, c);
+      CELL_ID(c) = in->ID;
+      CELL_PARENT_ID(c) = in->parentID;
+      CELL_LINEAGE(c) = in->lineage;
+      CELL_GENERATION(c) = (uintptr_t)in->generation;
+      CELL_ENERGY(c) = (uintptr_t)in->energy;
+      CELL_LOGO(c) = in->logo;
+      CELL_FACING(c) = in->facing;
+      genomeSet(c, in->genome, POND_DEPTH);
+      memcpy(CELL_RAM(c), in->ram, RAM_SIZE);
+      populationAdd(w, c);
     }
-    return 0;
+  }
 }
 
-static inline void write_mem(struct Cell *c, const uintptr_t x, const uintptr_t y, 
-        const uintptr_t ptr_mem, const uintptr_t value)
+/**
+ * Swap border rows with the neighbors after a phase
+ *
+ * @param w Worker
+ * @param phase Phase that just ended (0 for the upper half, 1 for the lower)
+ */
+static void nodeExchange(struct Worker *const w, const uintptr_t phase)
 {
-    switch (ptr_mem) {
-        case 0x00: /* logo */
-            statCounters.memSpecialWrites++;
-            c->logo = value & LOGO_MASK;
-            break;
-        case 0x01: /* facing */
-            statCounters.memSpecialWrites++;
-            c->facing = value & FACING_MASK;
-            break;
+  const size_t bytes = POND_SIZE_X * 2 * sizeof(struct NodeCell);
+  if (!phase) {
+    nodePackRows(NODE_HALO_TOP, nodeSendRows);
+    nodeTransfer(nodeUp, nodeSendRows, bytes, nodeDown, nodeRecvRows, bytes);
+    nodeUnpackRows(w, NODE_HALO_BOTTOM - 1, nodeRecvRows);
+  } else {
+    nodePackRows(NODE_HALO_BOTTOM - 1, nodeSendRows);
+    nodeTransfer(nodeDown, nodeSendRows, bytes, nodeUp, nodeRecvRows, bytes);
+    nodeUnpackRows(w, NODE_HALO_TOP, nodeRecvRows);
+  }
+}
 
-        case 0x02: /* read only */
-        case 0x03:
-        case 0x04:
-        case 0x05:
-        case 0x06:
-        case 0x07:
-            statCounters.memSpecialWrites++;
-            break;
+/**
+ * Main loop of the distributed engine
+ *
+ * Every node runs the same number of ticks, picking cells only from the
+ * half of its strip the phase is for.
+ *
+ * @param clock Starting clock
+ */
+static void runDistributed(uint64_t clock)
+{
+  struct Worker *const w = &workers[0];
+  uintptr_t x, y, phase;
 
-        case 0x08: /* private RAM */
-        case 0x09:
-        case 0x0a:
-        case 0x0b:
-        case 0x0c:
-        case 0x0d:
-        case 0x0e:
-        case 0x0f:
-            statCounters.memPrivateWrites++;
-            c->ram[ptr_mem & 0x7] = value & REG_MASK;
-            break;
+  nodeSendRows = (struct NodeCell *)calloc(POND_SIZE_X * 2, sizeof(struct NodeCell));
+  nodeRecvRows = (struct NodeCell *)calloc(POND_SIZE_X * 2, sizeof(struct NodeCell));
+  if ((!nodeSendRows)||(!nodeRecvRows)) {
+    fprintf(stderr,"*** Unable to allocate memory ***\n");
+    exit(1);
+  }
 
-        case 0x10: /* public RAM */
-        case 0x11:
-        case 0x12:
-        case 0x13:
-        case 0x14:
-        case 0x15:
-        case 0x16:
-        case 0x17:
-            statCounters.memOutputWrites++;
-            c->ram[8 + (ptr_mem & 0x7)] = value & REG_MASK;
-            break;
+  /* (Every node starts out empty, so the halos already match.) */
+  nodeLastExchange = clock;
+  for(;;++clock) {
+    /* Swap border rows at the end of each phase, and before the final
+     * dump so that it has the neighbors' last changes */
+    if ((clock != nodeLastExchange)&&((!(clock % DISTRIBUTED_PHASE))||(clock >= config.stopAt))) {
+      nodeExchange(w, (uintptr_t)((clock - 1) / DISTRIBUTED_PHASE) & 1);
+      nodeLastExchange = clock;
+    }
+    if (doHousekeeping(clock))
+      break;
 
-        case 0x18: /* neighbor (facing) public ram (if permitted by logo) */
-        case 0x19:
-        case 0x1a:
-        case 0x1b:
-        case 0x1c:
-        case 0x1d:
-        case 0x1e:
-        case 0x1f:
-            {
-                statCounters.memInputWrites++;
-                struct Cell *tmpptr = getNeighbor(x, y, c->facing);
-                if (accessAllowed(tmpptr, c->logo, 1)) {
-                    tmpptr->ram[8 + (ptr_mem & 0x7)] = value & REG_MASK;
-                }
-            }
-            break;
+    phase = (uintptr_t)(clock / DISTRIBUTED_PHASE) & 1;
+
+    if (!(clock % INFLOW_FREQUENCY)) {
+      x = getRandom(w->rng) % POND_SIZE_X;
+      y = NODE_FIRST_ROW + (phase * NODE_HALF_ROWS) + (getRandom(w->rng) % NODE_HALF_ROWS);
+      seedCell(w, x, y);
     }
+
+    x = getRandom(w->rng) % POND_SIZE_X;
+    y = NODE_FIRST_ROW + (phase * NODE_HALF_ROWS) + (getRandom(w->rng) % NODE_HALF_ROWS);
+    execCell(w, x, y);
+  }
+
+  free(nodeSendRows);
+  free(nodeRecvRows);
+  nodeSendRows = (struct NodeCell *)0;
+  nodeRecvRows = (struct NodeCell *)0;
 }
 
+#endif /* DISTRIBUTED_NODES */
+
+/* Rounds and plane length for checking the kernels */
+#define KERNEL_TEST_ROUNDS 64
+#define KERNEL_TEST_CELLS 1027
+
 /**
- * Main method
+ * Check the indexing layer and getNeighbor() against the geometry
  *
- * @param argc Number of args
- * @param argv Argument array
+ * Every cell is checked to map back to its position, and every
+ * direction of the 4, 6 and 8 direction grids to land on the neighbor
+ * at the expected offset (with the pond wrapping at the edges). Each of
+ * the NUM_INST facings must agree with getNeighborSwitch(), which covers
+ * the table lookup when NEIGHBOR_TABLES is set. Every set of kernels
+ * the processor can run must agree with the scalar kernels. With
+ * GENOME_PACKED, packed genomes must read back what was written.
+ *
+ * @return Number of failures
  */
-int main(int argc,char **argv)
+static uintptr_t selfTest()
 {
-  uintptr_t i, x, y;
-  
-  /* Buffer used for execution output of candidate offspring */
-  uint8_t outputBuf[POND_DEPTH];
-  
-  /* Seed and init the random number generator */
-  init_genrand(INIT_SEED);
-  for(i=0;i<1024;++i)
-    getRandom();
+  uintptr_t x, y, dir, dirs, n, failures = 0;
+  struct Kernels sets[MAX_KERNEL_SETS];
+  const uintptr_t setCount = getKernelSets(sets);
+  struct PopulationTotals expected, t;
+  struct RandomState r;
+  static uint8_t genome[POND_DEPTH];
+  static uint64_t weights[POND_DEPTH];
+  static uintptr_t energy[KERNEL_TEST_CELLS], generation[KERNEL_TEST_CELLS];
 
-  /* Reset per-report stat counters */
-  for(x=0;x<sizeof(statCounters);++x)
-    ((uint8_t *)&statCounters)[x] = (uint8_t)0;
-  
-  maxCellEnergy = 0;
-  maxLivingCellEnergy = 0;
-  
-  /* Set up SDL if we're using it */
-#ifdef USE_SDL
-  SDL_Surface *screen;
-  SDL_Event sdlEvent;
-  if (SDL_Init(SDL_INIT_VIDEO) < 0 ) {
-    fprintf(stderr,"*** Unable to init SDL: %s ***\n",SDL_GetError());
-    exit(1);
+#define TEST_DIR(dir,x,y,xo,yo) \
+  if (getNeighbor(x, y, dir, dirs) != cellIndex((POND_SIZE_X + x + xo) % POND_SIZE_X, (POND_SIZE_Y + y + yo) % POND_SIZE_Y)) { \
+    fprintf(stderr, "[TEST] getNeighbor dirs=%d dir=%d failed at x=%d, y=%d, xo=%d, yo=%d\n", (int)dirs, (int)dir, (int)x, (int)y, (int)xo, (int)yo); \
+    ++failures; \
   }
-  atexit(SDL_Quit);
-  SDL_WM_SetCaption(SDL_TITLE, SDL_TITLE);
-  screen = SDL_SetVideoMode(POND_SIZE_X,POND_SIZE_Y,8,SDL_SWSURFACE);
-  if (!screen) {
-    fprintf(stderr, "*** Unable to create SDL window: %s ***\n", SDL_GetError());
-    exit(1);
+  for (y = 0; y < POND_SIZE_Y; ++y) {
+    for (x = 0; x < POND_SIZE_X; ++x) {
+        if ((cellX(cellIndex(x, y)) != x) || (cellY(cellIndex(x, y)) != y) || (cellIndex(x, y) >= POND_CELLS)) {
+            fprintf(stderr, "[TEST] cellIndex/cellX/cellY mismatch at x=%d, y=%d\n", (int)x, (int)y);
+            ++failures;
+        }
+        for (dirs = 4; dirs <= 8; dirs += 2) {
+            if (dirs == 4) {
+                TEST_DIR(DIR4_NORTH, x, y,  0, -1);
+                TEST_DIR(DIR4_EAST,  x, y,  1,  0);
+                TEST_DIR(DIR4_SOUTH, x, y,  0,  1);
+                TEST_DIR(DIR4_WEST,  x, y, -1,  0);
+            } else if (dirs == 6) {
+                if (y & 1) {
+                    TEST_DIR(DIR6_0, x, y,  1, -1);
+                    TEST_DIR(DIR6_1, x, y,  1,  0);
+                    TEST_DIR(DIR6_2, x, y,  1,  1);
+                    TEST_DIR(DIR6_3, x, y,  0,  1);
+                    TEST_DIR(DIR6_4, x, y, -1,  0);
+                    TEST_DIR(DIR6_5, x, y,  0, -1);
+                }
+                else {
+                    TEST_DIR(DIR6_0, x, y,  0, -1);
+                    TEST_DIR(DIR6_1, x, y,  1,  0);
+                    TEST_DIR(DIR6_2, x, y,  0,  1);
+                    TEST_DIR(DIR6_3, x, y, -1,  1);
+                    TEST_DIR(DIR6_4, x, y, -1,  0);
+                    TEST_DIR(DIR6_5, x, y, -1, -1);
+                }
+            } else {
+                TEST_DIR(DIR8_NORTH, x, y,  0, -1);
+                TEST_DIR(DIR8_NE,    x, y,  1, -1);
+                TEST_DIR(DIR8_EAST,  x, y,  1,  0);
+                TEST_DIR(DIR8_SE,    x, y,  1,  1);
+                TEST_DIR(DIR8_SOUTH, x, y,  0,  1);
+                TEST_DIR(DIR8_SW,    x, y, -1,  1);
+                TEST_DIR(DIR8_WEST,  x, y, -1,  0);
+                TEST_DIR(DIR8_NW,    x, y, -1, -1);
+            }
+            for (dir = 0; dir < NUM_INST; ++dir) {
+                if (getNeighbor(x, y, dir, dirs) != getNeighborSwitch(x, y, dir, dirs)) {
+                    fprintf(stderr, "[TEST] getNeighbor dirs=%d facing=%d disagrees with getNeighborSwitch at x=%d, y=%d\n", (int)dirs, (int)dir, (int)x, (int)y);
+                    ++failures;
+                }
+            }
+        }
+    }
   }
-  const uintptr_t sdlPitch = screen->pitch;
-#endif /* USE_SDL */
- 
-  /* Clear the pond and initialize all genomes */
-  for(x=0;x<POND_SIZE_X;++x) {
-    for(y=0;y<POND_SIZE_Y;++y) {
-      pond[x][y].ID = 0;
-      pond[x][y].parentID = 0;
-      pond[x][y].lineage = 0;
-      pond[x][y].generation = 0;
-      pond[x][y].energy = 0;
-      pond[x][y].logo = 0;
-      pond[x][y].facing = 0;
-      for(i = 0; i < POND_DEPTH; ++i)
-        pond[x][y].genome[i] = OP_STOP;
-      for(i = 0; i < RAM_SIZE; ++i)
-        pond[x][y].ram[i] = 0x0;
+#undef TEST_DIR
+
+  /* Every kernel set has to agree with the scalar one, on random data
+   * that doesn't fill a whole number of vectors */
+  for (n = 0; n < KERNEL_TEST_ROUNDS; ++n) {
+    initRandom(&r, (uint64_t)n + 1);
+    for (x = 0; x < POND_DEPTH; ++x) {
+      genome[x] = (uint8_t)getRandom(&r);
+      weights[x] = getRandom(&r);
+    }
+    for (x = 0; x < KERNEL_TEST_CELLS; ++x) {
+      energy[x] = (getRandom(&r) & 3) ? (uintptr_t)((getRandom(&r) & 1) ? (getRandom(&r) % 10000) : getRandom(&r)) : 0;
+      generation[x] = (uintptr_t)((getRandom(&r) & 1) ? (getRandom(&r) & 3) : getRandom(&r));
+    }
+    memset(&expected, 0, sizeof(expected));
+    sets[0].scanPlanes(energy, generation, KERNEL_TEST_CELLS, &expected);
+    for (y = 1; y < setCount; ++y) {
+      memset(&t, 0, sizeof(t));
+      sets[y].scanPlanes(energy, generation, KERNEL_TEST_CELLS, &t);
+      if ((sets[y].genomeSum(genome) != sets[0].genomeSum(genome)) ||
+          (sets[y].genomeHash(genome, weights) != sets[0].genomeHash(genome, weights)) ||
+          (memcmp(&t, &expected, sizeof(t)))) {
+        fprintf(stderr, "[TEST] %s kernels disagree with the scalar ones in round %d\n", sets[y].name, (int)n);
+        ++failures;
+      }
     }
   }
-  
-  /* Clock is incremented on each core loop */
-  uint64_t clock = 0;
-  
-  /* This is used to generate unique cell IDs */
-  uint64_t cellIdCounter = 0;
-  
-  /* Miscellaneous variables used in the loop */
-  uintptr_t instPtr, inst, tmp;
-  struct Cell *pptr,*tmpptr;
-  
-  /* Virtual machine I/O pointer register (used for both genome and output buffer) */
-  uintptr_t ptr_ioPtr;
 
-  /* memory pointers */
-  uintptr_t ptr_mem;
-  
-  /* The main "register" */
-  uintptr_t reg;
-  
-  /* Which way is the cell facing? */
-  //uintptr_t facing;
-  
-  /* Virtual machine loop/rep stack */
-  uintptr_t loopStack[POND_DEPTH];
-  uintptr_t loopStackPtr;
-  
-  /* If this is nonzero, we're skipping to matching REP */
-  /* It is incremented to track the depth of a nested set
-   * of LOOP/REP pairs in false state. */
-  uintptr_t falseLoopDepth;
-  
-  /* If this is nonzero, cell execution stops. This allows us
-   * to avoid the ugly use of a goto to exit the loop. :) */
-  int stop;
+#if GENOME_PACKED
+  /* Packing, unpacking, and reading and writing single instructions
+   * (with a short genome, so the rest is filled with STOP) */
+  for (n = 0; n < KERNEL_TEST_ROUNDS; ++n) {
+    uint64_t packed[GENOME_WORDS];
+    uint8_t unpacked[POND_DEPTH];
+    const uintptr_t len = (n * 37) % (POND_DEPTH + 1);
+
+    initRandom(&r, (uint64_t)n + 1);
+    for (x = 0; x < POND_DEPTH; ++x)
+      genome[x] = (x < len) ? (uint8_t)(getRandom(&r) & INST_MASK) : OP_STOP;
+    genomePack(packed, genome, len);
+    for (x = 0; x < 64; ++x) {
+      y = getRandom(&r) % POND_DEPTH;
+      genome[y] = (uint8_t)(getRandom(&r) & INST_MASK);
+      genomePut(packed, y, genome[y]);
+    }
+    genomeUnpack(packed, unpacked);
+    for (x = 0; x < POND_DEPTH; ++x) {
+      if ((unpacked[x] != genome[x]) || (genomeGet(packed, x) != genome[x])) {
+        fprintf(stderr, "[TEST] Packed genome reads back wrong at %d in round %d\n", (int)x, (int)n);
+        ++failures;
+        break;
+      }
+    }
+  }
+#endif
+
+#if (DUMP_BINARY && defined(USE_ZSTD))
+  /* A dump written compressed has to read back (through the same path
+   * as -d) as what was compressed. The records are random genomes made
+   * of a few instructions, so they really do shrink. */
+  {
+    struct DumpSnapshot s;
+    char path[] = "/tmp/nanopond-test.XXXXXX";
+    const int fd = mkstemp(path);
+    uint8_t *back = (uint8_t *)0;
+    size_t size = 0;
+
+    memset(&s, 0, sizeof(s));
+    s.clock = 1;
+    s.count = 64;
+    s.tombstones = 5;
+    s.capacity = DUMP_HEADER_BYTES + (s.count * DUMP_RECORD_BYTES) + (s.tombstones * 4);
+    s.buf = (uint8_t *)malloc(s.capacity);
+    s.file = (fd < 0) ? (FILE *)0 : fdopen(fd, "wb");
+    if ((fd >= 0)&&(!s.file))
+      close(fd);
+    if ((s.buf)&&(s.file)) {
+      initRandom(&r, 1);
+      for (x = DUMP_HEADER_BYTES; x < s.capacity; ++x)
+        s.buf[x] = (uint8_t)(getRandom(&r) & 3);
+      writeDump(&s); /* This closes the file */
+      back = readDump(path, &size);
+    } else if (s.file) {
+      fclose(s.file);
+    }
+    if ((!back)||(size != s.capacity)||(memcmp(back, s.buf, size))||(s.bytesWritten >= s.capacity)) {
+      fprintf(stderr, "[TEST] A zstd compressed dump does not read back as written\n");
+      ++failures;
+    }
+    free(back);
+    free(s.buf);
+    if (fd >= 0)
+      unlink(path);
+  }
+#endif
+
+  fprintf(stderr, "[TEST] %s: DIRECTIONS=4,6,8 NEIGHBOR_TABLES=%d POND_ORDER=%d KERNELS=%s, %ju failures\n",
+    failures ? "FAILED" : "passed", NEIGHBOR_TABLES, POND_ORDER, kernels.name, (uintmax_t)failures);
+  return failures;
+}
+
+/**
+ * Set up a pond and run it until it stops
+ *
+ * The pond is set up from config, which must be filled in first.
+ *
+ * @param restore Checkpoint to resume, or NULL to start a new pond
+ * @return 0 once the pond stops, nonzero if it could not be set up
+ */
+static int runPond(const char *restore)
+{
+  uintptr_t i;
+  struct Worker *const w = &workers[0];
+
+  /* Seed and init the random number generator (each node of a
+   * distributed pond gets a seed of its own) */
+  w->rng = &w->ownRng;
+#if (DISTRIBUTED_NODES > 0)
+  initRandom(w->rng, config.seed + (uint64_t)nodeRank);
+#else
+  initRandom(w->rng, config.seed);
+#endif
+  for(i=0;i<1024;++i)
+    getRandom(w->rng);
+#if MUTATION_SKIP_AHEAD
+  w->mutationCountdown = nextMutationDistance(w->rng);
+#endif
 
-#define TEST_NEIGHBOR 0
-#if TEST_NEIGHBOR
-#define TEST_DIR(dir,x,y,xo,yo) \
-  if (getNeighbor(x, y, dir) != &pond[(POND_SIZE_X + x + xo) % POND_SIZE_X][(POND_SIZE_Y + y + yo) % POND_SIZE_Y]) { \
-    fprintf(stderr, "TEST_NEIGHBOR dir=%d failed at x=%d, y=%d, xo=%d, yo=%d\n", (int)dir, (int)x, (int)y, (int)xo, (int)yo); \
-    return 1;\
+  /* This is used to generate unique cell IDs */
+  w->ids = &w->ownIds;
+#if (DISTRIBUTED_NODES > 0)
+  w->ids->next = (uint64_t)nodeRank;
+  w->ids->stride = DISTRIBUTED_NODES;
+#else
+  w->ids->next = 0;
+  w->ids->stride = 1;
+#endif
+
+  /* Reset per-report stat counters */
+  clearStatCounters(&statCounters);
+  for(i=0;i<NUM_WORKERS;++i)
+    clearStatCounters(&workers[i].stats);
+
+  maxCellEnergy = 0;
+  maxLivingCellEnergy = 0;
+
+#if DUMP_DELTA
+  /* Cells are marked changed from the first seeding on, and a restored
+   * run's first dump (always a full one) comes after some executions */
+  dumpDirty = (uint8_t *)calloc(2, POND_CELLS);
+  if (!dumpDirty) {
+    fprintf(stderr,"*** Unable to allocate the dump dirty bits ***\n");
+    return 1;
   }
-  for (y = 0; y < POND_SIZE_Y; ++y) {
-    for (x = 0; x < POND_SIZE_X; ++x) {
-#if (DIRECTIONS == 4)
-        TEST_DIR(DIR_NORTH, x, y,  0, -1);
-        TEST_DIR(DIR_EAST,  x, y,  1,  0);
-        TEST_DIR(DIR_SOUTH, x, y,  0,  1);
-        TEST_DIR(DIR_WEST,  x, y, -1,  0);
-#elif (DIRECTIONS == 6)
-        if (y & 1) {
-            TEST_DIR(DIR_0, x, y,  1, -1);
-            TEST_DIR(DIR_1, x, y,  1,  0);
-            TEST_DIR(DIR_2, x, y,  1,  1);
-            TEST_DIR(DIR_3, x, y,  0,  1);
-            TEST_DIR(DIR_4, x, y, -1,  0);
-            TEST_DIR(DIR_5, x, y,  0, -1);
-        }
-        else {
-            TEST_DIR(DIR_0, x, y,  0, -1);
-            TEST_DIR(DIR_1, x, y,  1,  0);
-            TEST_DIR(DIR_2, x, y,  0,  1);
-            TEST_DIR(DIR_3, x, y, -1,  1);
-            TEST_DIR(DIR_4, x, y, -1,  0);
-            TEST_DIR(DIR_5, x, y, -1, -1);
-        }
-#elif (DIRECTIONS == 8)
-        TEST_DIR(DIR_NORTH, x, y,  0, -1);
-        TEST_DIR(DIR_NE,    x, y,  1, -1);
-        TEST_DIR(DIR_EAST,  x, y,  1,  0);
-        TEST_DIR(DIR_SE,    x, y,  1,  1);
-        TEST_DIR(DIR_SOUTH, x, y,  0,  1);
-        TEST_DIR(DIR_SW,    x, y, -1,  1);
-        TEST_DIR(DIR_WEST,  x, y, -1,  0);
-        TEST_DIR(DIR_NW,    x, y, -1, -1);
+  dumpPresent = dumpDirty + POND_CELLS;
+#endif
+
+  /* Clock is incremented on each core loop */
+  uint64_t clock = 0;
+
+  if (restore) {
+    if (restoreCheckpoint(restore, &clock))
+      return 1;
+#if INCREMENTAL_STATS
+    uintptr_t c;
+    for(c=0;c<POND_CELLS;++c)
+      populationAdd(w, c);
 #endif
+  } else {
+    /* A fresh anonymous mapping is all zero pages, and an all-zero
+     * cell is an empty one (no energy, IDs of 0 and a genome of STOPs),
+     * so the pond needs no clearing: each page is only backed by memory
+     * once something is written to it, by the thread that writes it
+     * (which with PARALLEL_THREADS is the worker running that part of
+     * the pond). */
+    _Static_assert(OP_STOP == 0, "an all-zero pond must be empty");
+    void *const m = mmap((void *)0, POND_BYTES, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (m == MAP_FAILED) {
+      fprintf(stderr,"*** Unable to allocate the pond ***\n");
+      return 1;
+    }
+    setPondMemory((uint8_t *)m);
+#if GENOME_POOL
+    if (initGenomePool()) {
+      fprintf(stderr,"*** Unable to allocate the genome pool ***\n");
+      return 1;
     }
-  }
-  return 0;
 #endif
-  
-  /* Main loop */
-  for(;;++clock) {
-    /* Stop at STOP_AT if defined */
-#ifdef STOP_AT
-    if (clock >= STOP_AT) {
-      /* Also do a final dump if dumps are enabled */
-#ifdef DUMP_FREQUENCY
-      doDump(clock);
-#endif /* DUMP_FREQUENCY */
-      fprintf(stderr,"[QUIT] STOP_AT clock value reached\n");
-      break;
+#if ACTIVE_SET_SCHEDULER
+    if (initActiveSet()) {
+      fprintf(stderr,"*** Unable to allocate the active set ***\n");
+      return 1;
     }
-#endif /* STOP_AT */
+#endif
 
-    /* Increment clock and run reports periodically */
-    /* Clock is incremented at the start, so it starts at 1 */
-    if (!(clock % REPORT_FREQUENCY)) {
-      doReport(clock);
-    }
-    /* SDL display is also refreshed every REFRESH_FREQUENCY */
+    if (config.loopCorpus)
+      seedLoopCorpus(w);
+  }
+  if (config.runTicks && (config.stopAt > clock) && (config.runTicks < (config.stopAt - clock)))
+    config.stopAt = clock + config.runTicks;
+
+  /* The display thread reads the pond, so it starts once there is one */
 #ifdef USE_SDL
-    if (!(clock % REFRESH_FREQUENCY)) {
-      while (SDL_PollEvent(&sdlEvent)) {
-        if (sdlEvent.type == SDL_QUIT) {
-          fprintf(stderr,"[QUIT] Quit signal received!\n");
-          exit(0);
-        } else if (sdlEvent.type == SDL_MOUSEBUTTONDOWN) {
-          switch (sdlEvent.button.button) {
-            case SDL_BUTTON_LEFT:
-              tmpptr = &pond[sdlEvent.button.x][sdlEvent.button.y];
-              if (tmpptr->energy && (tmpptr->generation > 2)) {
-                fprintf(stderr,"[INTERFACE] Genome of cell at (%d, %d):\n", sdlEvent.button.x, sdlEvent.button.y);
-                dumpCell(stderr, tmpptr);
-              }
-              break;
-            case SDL_BUTTON_RIGHT:
-              colorScheme = (colorScheme + 1) % MAX_COLOR_SCHEME;
-              fprintf(stderr,"[INTERFACE] Switching to color scheme \"%s\".\n",colorSchemeName[colorScheme]);
-              break;
-          }
-        }
-      }
-      for (y=0;y<POND_SIZE_Y;++y) {
-          for (x=0;x<POND_SIZE_X;++x) {
-              ((uint8_t *)screen->pixels)[x + (y * sdlPitch)] = getColor(&pond[x][y]);
-          }
-      }
-      SDL_UpdateRect(screen,0,0,POND_SIZE_X,POND_SIZE_Y);
-    }
+  startDisplay();
+  atexit(stopDisplay);
 #endif /* USE_SDL */
 
-    /* Periodically dump the viable population if defined */
-#ifdef DUMP_FREQUENCY
-    if (!(clock % DUMP_FREQUENCY))
-      doDump(clock);
-#endif /* DUMP_FREQUENCY */
-
-    /* Introduce a random cell somewhere with a given energy level */
-    /* This is called seeding, and introduces both energy and
-     * entropy into the substrate. This happens every INFLOW_FREQUENCY
-     * clock ticks. */
-    if (!(clock % INFLOW_FREQUENCY)) {
-      x = getRandom() % POND_SIZE_X;
-      y = getRandom() % POND_SIZE_Y;
-      pptr = &pond[x][y];
-      pptr->ID = cellIdCounter;
-      pptr->parentID = 0;
-      pptr->lineage = cellIdCounter;
-      pptr->generation = 0;
-      pptr->logo = 0;
-      pptr->facing = 0;
-#if TOTAL_ENERGY_CAP
-      if (totalEnergy < TOTAL_ENERGY_CAP) {
-#endif
-#if CELL_ENERGY_CAP
-         if (pptr->energy < CELL_ENERGY_CAP) {
+  startClock = clock;
+  startInstructions = instructionCount();
+  clock_gettime(CLOCK_MONOTONIC, &startTime);
+#if TELEMETRY
+  if (startTelemetry())
+    return 1;
 #endif
-#ifdef INFLOW_RATE_VARIATION
-        pptr->energy += INFLOW_RATE_BASE + (getRandom() % INFLOW_RATE_VARIATION);
-#else
-        pptr->energy += INFLOW_RATE_BASE;
-#endif /* INFLOW_RATE_VARIATION */
-#if CELL_ENERGY_CAP
-         }
+#if BIRTH_LOG
+  if (openBirthLog(clock))
+    return 1;
 #endif
-#if TOTAL_ENERGY_CAP
-      }
+#if EXEC_TRACE
+  if (openTraceLog(clock))
+    return 1;
 #endif
-      instPtr = 0;
-      for(i = 0; i < POND_DEPTH; ++i) {
-        pptr->genome[i] = getRandom() & INST_MASK;
-      }
-      for(i = 0; i < RAM_SIZE; ++i) {
-#if CLEAR_RAM
-        pptr->ram[i] = 0; 
+
+#if (PARALLEL_THREADS > 0)
+  runParallel(clock, restore != (const char *)0);
+#elif (DISTRIBUTED_NODES > 0)
+  runDistributed(clock);
 #else
-        pptr->ram[i] = getRandom() & REG_MASK;
+  uintptr_t x, y;
+#if ACTIVE_SET_SCHEDULER
+  uintptr_t c;
+  uint64_t jump;
+
+  /* A restored run carries on with the wait it had */
+  if (!restore)
+    activeSkip = skippedPicks(w->rng);
 #endif
-      }
 
-      ++cellIdCounter;
+  /* Main loop */
+  for(;;++clock) {
+    if (doHousekeeping(clock))
+      break;
+
+    /* Introduce a random cell somewhere with a given energy level
+     * every INFLOW_FREQUENCY clock ticks. */
+    if (!(clock % INFLOW_FREQUENCY)) {
+      x = getRandom(w->rng) % POND_SIZE_X;
+      y = getRandom(w->rng) % POND_SIZE_Y;
+      seedCell(w, x, y);
+#if ACTIVE_SET_SCHEDULER
+      /* The odds have changed, and since the picks are independent the
+       * rest of the wait can just be drawn again */
+      activeSkip = skippedPicks(w->rng);
+#endif
     }
-    
-    /* Pick a random cell to execute */
-    x = getRandom() % POND_SIZE_X;
-    y = getRandom() % POND_SIZE_Y;
-    pptr = &pond[x][y];
 
-    /* Reset the state of the VM prior to execution */
-    for(i=0;i<POND_DEPTH;++i) {
-      outputBuf[i] = OP_STOP;
+#if ACTIVE_SET_SCHEDULER
+    /* Skip the ticks whose pick would have found no energy, then pick
+     * one of the cells with energy. The clock jumps over the skipped
+     * ticks that have no housekeeping or inflow due; each still counts
+     * as a cell execution, as it would have with uniform picks. */
+    if (activeSkip) {
+      jump = nextBusyClock(clock) - clock - 1;
+      if (jump > (activeSkip - 1))
+        jump = activeSkip - 1;
+      clock += jump;
+      activeSkip -= jump + 1;
+      w->stats.cellExecutions += jump + 1;
+      continue;
     }
+    c = activeCells[getRandom(w->rng) % activeCount];
+    execCell(w, cellX(c), cellY(c));
+    activeSkip = skippedPicks(w->rng);
+#else
+    /* Pick a random cell to execute */
+    x = getRandom(w->rng) % POND_SIZE_X;
+    y = getRandom(w->rng) % POND_SIZE_Y;
+    execCell(w, x, y);
+#endif
+  } /* main loop */
+#endif /* PARALLEL_THREADS */
 
-    ptr_ioPtr = 0;
-    loopStackPtr = 0;
-    falseLoopDepth = 0;
-    stop = 0;
+#if BIRTH_LOG
+  closeBirthLog();
+#endif
+#if EXEC_TRACE
+  closeTraceLog();
+#endif
+#if TELEMETRY
+  stopTelemetry();
+#endif
+  return 0;
+}
 
-    //facing = pptr->genome[1] & 0x7;
-    //reg = pptr->genome[2] & INST_MASK;
-    reg = 0;
-    instPtr = EXEC_START_INST;
+#if BATCH_PONDS
 
-    ptr_mem = 0;
-    
-    /* Keep track of how many cells have been executed */
-    statCounters.cellExecutions += 1.0;
+/* ----------------------------------------------------------------------- */
+/* Batch mode                                                              */
+/* ----------------------------------------------------------------------- */
 
-    /* Core execution loop */
-    while (pptr->energy&&(!stop)) {
-      /* Get the next instruction */
-      inst = pptr->genome[instPtr];
-      
-      /* Randomly frob either the instruction or the register with a
-       * probability defined by MUTATION_RATE. This introduces variation,
-       * and since the variation is introduced into the state of the VM
-       * it can have all manner of different effects on the end result of
-       * replication: insertions, deletions, duplications of entire
-       * ranges of the genome, etc. */
-      if ((getRandom() & 0xffffffff) < MUTATION_RATE) {
-        tmp = getRandom(); /* Call getRandom() only once for speed */
-        if (tmp & 0x20000)
-            if (tmp & 0x10000)
-                inst = tmp & INST_MASK;
-            else
-                reg = tmp & REG_MASK;
-        else
-            if (tmp & 0x10000)
-                ptr_mem = tmp & MEM_MASK;
-            else
-                pptr->ram[(tmp >> 8) & RAM_MASK] = tmp & REG_MASK;
-      }
-      
-      /* Each instruction processed costs one unit of energy */
-      --pptr->energy;
-      
-      /* Execute the instruction */
-      if (falseLoopDepth) {
-        /* Skip forward to matching REP if we're in a false loop. */
-        if (inst == 0x9) /* Increment false LOOP depth */
-          ++falseLoopDepth;
-        else if (inst == 0xa) /* Decrement on REP */
-          --falseLoopDepth;
-      } else {
-        /* If we're not in a false LOOP/REP, execute normally */
-        
-        /* Keep track of execution frequencies for each instruction */
-        statCounters.instructionExecutions[inst] += 1.0;
-        
-        switch(inst) {
-          case OP_SETP: /* SETP */
-            ptr_ioPtr = reg;
-            break;
-          case OP_NEXTB: /* NEXTB */
-            ptr_mem = (ptr_mem + 8) & MEM_MASK;
-            break;
-          case OP_PREVB: /* PREVB */
-            ptr_mem = (ptr_mem - 8) & MEM_MASK;
-            break;
-          case OP_NEXTM: /* NEXTM */
-            ptr_mem = (ptr_mem + 1) & MEM_MASK;
-            break;
-          case OP_PREVM: /* PREVM */
-            ptr_mem = (ptr_mem - 1) & MEM_MASK;
-            break;
-          case OP_READM: /* READM */
-            reg = read_mem(pptr, x, y, ptr_mem);
-            break;
-          case OP_WRITEM: /* WRITEM */
-            write_mem(pptr, x, y, ptr_mem, reg);
-            break;
-          case OP_CLEARM: /* CLEARM */
-            for (i = 0; i < RAM_SIZE; ++i) {
-                pptr->ram[i] = 0x0;
-            }
-            break;
-          case OP_ADD:
-            reg = (reg + read_mem(pptr, x, y, ptr_mem)) & REG_MASK;
-            break;
-          case OP_SUB:
-            reg = (reg - read_mem(pptr, x, y, ptr_mem)) & REG_MASK;
-            break;
-          case OP_MUL:
-            reg = (reg * read_mem(pptr, x, y, ptr_mem)) & REG_MASK;
-            break;
-          case OP_DIV:
-            tmp = read_mem(pptr, x, y, ptr_mem);
-            reg = tmp ? (reg / read_mem(pptr, x, y, ptr_mem)) & REG_MASK : 0;
-            break;
-          case OP_SHL:
-            reg = (reg << 1) & REG_MASK;
-            break;
-          case OP_SHR:
-            reg = (reg >> 1) & REG_MASK;
-            break;
-          case OP_SETMP:
-            ptr_mem = reg & MEM_MASK;
-            break;
-          case OP_RAND:
-            reg = getRandom() & REG_MASK;
-            break;
-          case OP_ZERO: /* ZERO: Zero VM state registers */
-            reg = 0;
-            //ptr_ioPtr = 0;
-            //facing = 0;
-            break;
-          case OP_FWD: /* FWD: Increment the pointer (wrap at end) */
-            if (++ptr_ioPtr >= POND_DEPTH) {
-                ptr_ioPtr = 0;
-            }
-            break;
-          case OP_BACK: /* BACK: Decrement the pointer (wrap at beginning) */
-            if (ptr_ioPtr) {
-                --ptr_ioPtr;
-            }
-            else {
-                ptr_ioPtr = POND_DEPTH - 1;
-            }
-            break;
-          case OP_INC: /* INC: Increment the register */
-            reg = (reg + 1) & REG_MASK;
-            break;
-          case OP_DEC: /* DEC: Decrement the register */
-            reg = (reg - 1) & REG_MASK;
-            break;
-          case OP_READG: /* READG: Read into the register from genome */
-            reg = pptr->genome[ptr_ioPtr];
-            break;
-          case OP_WRITEG: /* WRITEG: Write out from the register to genome */
-            pptr->genome[ptr_ioPtr] = reg & INST_MASK;
-            break;
-          case OP_READO: /* READO: Read into the register from output buffer */
-            reg = outputBuf[ptr_ioPtr];
-            break;
-          case OP_WRITEO: /* WRITEO: Write out from the register to output buffer */
-            outputBuf[ptr_ioPtr] = reg & INST_MASK;
-            break;
-          case OP_LOOP: /* LOOP: Jump forward to matching REP if register is zero */
-            if (reg) {
-              if (loopStackPtr >= POND_DEPTH)
-                stop = 1; /* Stack overflow ends execution */
-              else {
-                loopStack[loopStackPtr] = instPtr;
-                ++loopStackPtr;
-              }
-            } else falseLoopDepth = 1;
-            break;
-          case OP_REP: /* REP: Jump back to matching LOOP if register is nonzero */
-            if (loopStackPtr) {
-              --loopStackPtr;
-              if (reg) {
-                instPtr = loopStack[loopStackPtr];
-                /* This ensures that the LOOP is rerun */
-                continue;
-              }
-            }
-            break;
-          case OP_TURN: /* using this inst for ideas */
-            /* TURN: Turn in the direction specified by register */
-            //pptr->facing = reg & FACING_MASK; /* TURN */
+/**
+ * A pond to run in the batch mode
+ */
+struct BatchJob
+{
+  char name[200];
+  struct PondConfig config;
+  int result;
+};
 
-            //ptr_mem = (ptr_mem + 4) & MEM_MASK; /* inc mem+ptr by 4 */
+static struct BatchJob *batchJobs = (struct BatchJob *)0;
+static uintptr_t batchJobCount = 0;
+static atomic_uintptr_t batchNextJob;
 
-            /* read one instruction from either own genome or facing cell */
-            if (pptr->generation > 2) {
-                tmpptr = getNeighbor(x, y, pptr->facing);
-                if (tmpptr->generation > 2 && accessAllowed(tmpptr, reg, COMBINE_SENSE)) {
-                    reg = ((getRandom() & 0x8) ? pptr->genome : tmpptr->genome)[ptr_ioPtr];
-                }
-                else {
-                    reg = pptr->genome[ptr_ioPtr];
-                }
-            }
-            else {
-                reg = pptr->genome[ptr_ioPtr];
-            }
-            break;
-          case OP_XCHG: /* XCHG: Skip next instruction and exchange value of register with it */
-            if (++instPtr >= POND_DEPTH) {
-                instPtr = EXEC_START_INST;
-            }
-            tmp = reg;
-            reg = pptr->genome[instPtr];
-            pptr->genome[instPtr] = tmp & INST_MASK;
-            break;
-          case OP_KILL: /* KILL: Blow away neighboring cell if allowed with penalty on failure */
-            tmpptr = getNeighbor(x, y, pptr->facing);
-            if (accessAllowed(tmpptr, reg, 0)) {
-              if (tmpptr->generation > 2)
-                ++statCounters.viableCellsKilled;
-
-              /* clear all */
-              for (i = 0; i < POND_DEPTH; ++i) {
-                tmpptr->genome[i] = OP_STOP;
-              }
-              tmpptr->ID = cellIdCounter;
-              tmpptr->parentID = 0;
-              tmpptr->lineage = cellIdCounter;
-              tmpptr->generation = 0;
-              tmpptr->logo = 0;
-              tmpptr->facing = 0;
-              ++cellIdCounter;
-            } else if (tmpptr->generation > 2) {
-              tmp = pptr->energy / FAILED_KILL_PENALTY;
-              if (pptr->energy > tmp)
-                pptr->energy -= tmp;
-              else pptr->energy = 0;
-            }
-            break;
-          case OP_SHARE: /* SHARE: Equalize energy between self and neighbor if allowed */
-            tmpptr = getNeighbor(x, y, pptr->facing);
-            if (accessAllowed(tmpptr,reg,1)) {
-              if (tmpptr->generation > 2)
-                ++statCounters.viableCellShares;
-
-              tmp = pptr->energy + tmpptr->energy;
-              tmpptr->energy = tmp / 2;
-              pptr->energy = tmp - tmpptr->energy;
-            }
-            break;
-          case OP_STOP: /* STOP: End execution */
-            stop = 1;
-            break;
-        }
-      }
-      
-      /* Advance the instruction pointer, and loop around to the beginning at the end of the genome. */
-      if (++instPtr >= POND_DEPTH) {
-          instPtr = EXEC_START_INST;
-      }
+/**
+ * Free what runPond() allocated
+ */
+static void releasePond()
+{
+  munmap(pondMemory, POND_BYTES);
+  pondMemory = (uint8_t *)0;
+#if GENOME_POOL
+  releaseGenomePool();
+#endif
+#if ACTIVE_SET_SCHEDULER
+  free(activeCells);
+  activeCells = (uint32_t *)0;
+  free(activePosition);
+  activePosition = (uint32_t *)0;
+#endif
+  free(dumpSnapshot.buf);
+  dumpSnapshot.buf = (uint8_t *)0;
+#if DUMP_DELTA
+  free(dumpDirty);
+  dumpDirty = (uint8_t *)0;
+#endif
+#if INCREMENTAL_STATS
+  uintptr_t k;
+  for(k=0;k<NUM_WORKERS;++k) {
+    free(workers[k].population.energyHist.count);
+    free(workers[k].population.livingEnergyHist.count);
+    free(workers[k].population.generationHist.count);
+  }
+  free(population.energyHist.count);
+  free(population.livingEnergyHist.count);
+  free(population.generationHist.count);
+#endif
+}
+
+/**
+ * Run one batch job
+ *
+ * Each job runs in a thread of its own, so it starts out with fresh
+ * pond state.
+ *
+ * @param arg Job
+ * @return Nothing
+ */
+static void *batchJobMain(void *arg)
+{
+  struct BatchJob *const j = (struct BatchJob *)arg;
+  char path[sizeof(config.outputPrefix) + 16];
+
+  config = j->config;
+  if (mkdir(j->name, 0755) && (errno != EEXIST)) {
+    fprintf(stderr,"*** Unable to create directory %s ***\n", j->name);
+    j->result = 1;
+    return (void *)0;
+  }
+  snprintf(config.outputPrefix, sizeof(config.outputPrefix), "%s/", j->name);
+  snprintf(path, sizeof(path), "%sreport.csv", config.outputPrefix);
+  config.report = fopen(path, "w");
+  if (!config.report) {
+    fprintf(stderr,"*** Unable to open %s for writing ***\n", path);
+    j->result = 1;
+    return (void *)0;
+  }
+
+  j->result = runPond((const char *)0);
+  fclose(config.report);
+  releasePond();
+  fprintf(stderr,"[BATCH] %s %s\n", j->name, j->result ? "failed" : "finished");
+  return (void *)0;
+}
+
+/**
+ * Batch worker thread, which runs jobs until there are none left
+ *
+ * @param arg Unused
+ * @return Nothing
+ */
+static void *batchWorkerMain(void *arg)
+{
+  pthread_t t;
+  uintptr_t k;
+  (void)arg;
+
+  while ((k = atomic_fetch_add(&batchNextJob, 1)) < batchJobCount) {
+    if (pthread_create(&t, (const pthread_attr_t *)0, batchJobMain, &batchJobs[k])) {
+      fprintf(stderr,"*** Unable to create a thread for %s ***\n", batchJobs[k].name);
+      batchJobs[k].result = 1;
+      continue;
     }
+    pthread_join(t, (void **)0);
+  }
+  return (void *)0;
+}
 
-    /* Decay part of RAM if there is no energy. */
-    if (!pptr->energy) {
-#if DECAY_RAM
-        tmp = getRandom();
-        pptr->ram[(tmp >> 8) & RAM_MASK] = tmp & REG_MASK;
-#endif
+/**
+ * Run the ponds listed in a jobs file, a number of them at a time
+ *
+ * @param path Jobs file (see BATCH_PONDS)
+ * @param threads Number of ponds to run at once, or 0 for one per processor
+ * @return 0 if every pond ran, 1 otherwise
+ */
+static int runBatch(const char *path, uintptr_t threads)
+{
+  struct BatchJob j, *p;
+  unsigned long long seed, mutationRate, inflowBase, inflowVariation, reproductionCost, stopAt, directions;
+  char line[1024];
+  uintptr_t k, lineNo = 0;
+  pthread_t *pool;
+  int failed = 0;
+  FILE *f;
+
+  f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr,"*** Unable to open jobs file %s ***\n", path);
+    return 1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    ++lineNo;
+    if ((line[0] == '#')||(strspn(line, " \t\r\n") == strlen(line)))
+      continue;
+    directions = DIRECTIONS;
+    if (sscanf(line, "%199s %llu %llu %llu %llu %llu %llu %llu", j.name, &seed, &mutationRate, &inflowBase, &inflowVariation, &reproductionCost, &stopAt, &directions) < 7) {
+      fprintf(stderr,"*** %s:%ju: expected <name> <seed> <mutation rate> <inflow base> <inflow variation> <reproduction cost> <stop at> [<directions>] ***\n", path, (uintmax_t)lineNo);
+      fclose(f);
+      return 1;
     }
-#if (REPRODUCTION_COST > 0)
-    else if (pptr->energy >= REPRODUCTION_COST) {
-#else
-    else {
-#endif
-
-        /* Copy outputBuf into neighbor if access is permitted and there
-         * is energy there to make something happen. There is no need
-         * to copy to a cell with no energy, since anything copied there
-         * would never be executed and then would be replaced with random
-         * junk eventually. See the seeding code in the main loop above. */
-        if (outputBuf[0] != OP_STOP) {
-            tmpptr = getNeighbor(x, y, pptr->facing);
-            if ((tmpptr->energy)&&accessAllowed(tmpptr, reg, 0)) {
-                /* Log it if we're replacing a viable cell */
-                if (tmpptr->generation > 2)
-                    ++statCounters.viableCellsReplaced;
-
-                tmpptr->ID = ++cellIdCounter;
-                tmpptr->parentID = pptr->ID;
-                tmpptr->lineage = pptr->lineage; /* Lineage is copied in offspring */
-                tmpptr->generation = pptr->generation + 1;
-                tmpptr->logo = 0;
-                tmpptr->facing = 0;
-                for(i = 0; i < POND_DEPTH; ++i) {
-                    tmpptr->genome[i] = outputBuf[i];
-                }
-                for(i = 0; i < RAM_SIZE; ++i) {
-#if CLEAR_RAM
-                    tmpptr->ram[i] = 0;
+#if VM_SPECIALIZE
+    if ((directions != 4) && (directions != 6) && (directions != 8)) {
 #else
-                    tmpptr->ram[i] = getRandom() & REG_MASK;
+    if (directions != DIRECTIONS) {
 #endif
-                }
-                pptr->energy -= REPRODUCTION_COST;
-            }
-        }
+      fprintf(stderr,"*** %s:%ju: this build can not run %llu directions ***\n", path, (uintmax_t)lineNo, directions);
+      fclose(f);
+      return 1;
     }
+#if MUTATION_SKIP_AHEAD
+    if (!mutationRate) {
+      fprintf(stderr,"*** %s:%ju: MUTATION_SKIP_AHEAD needs a nonzero mutation rate ***\n", path, (uintmax_t)lineNo);
+      fclose(f);
+      return 1;
+    }
+#endif
+    defaultConfig(&j.config);
+    j.config.seed = seed;
+    j.config.mutationRate = (uintptr_t)mutationRate;
+    j.config.inflowRateBase = (uintptr_t)inflowBase;
+    j.config.inflowRateVariation = (uintptr_t)inflowVariation;
+    j.config.reproductionCost = (uintptr_t)reproductionCost;
+    j.config.stopAt = stopAt ? (uint64_t)stopAt : UINT64_MAX;
+    j.config.directions = (uintptr_t)directions;
+    j.result = 0;
+    p = (struct BatchJob *)realloc(batchJobs, (batchJobCount + 1) * sizeof(struct BatchJob));
+    if (!p) {
+      fprintf(stderr,"*** Unable to allocate memory ***\n");
+      fclose(f);
+      return 1;
+    }
+    batchJobs = p;
+    batchJobs[batchJobCount++] = j;
+  }
+  fclose(f);
+
+  if (!threads) {
+    const long n = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = (n > 0) ? (uintptr_t)n : 1;
+  }
+  if (threads > batchJobCount)
+    threads = batchJobCount;
+  fprintf(stderr,"[BATCH] Running %ju ponds, %ju at a time\n", (uintmax_t)batchJobCount, (uintmax_t)threads);
+
+  atomic_store(&batchNextJob, 0);
+  pool = (pthread_t *)malloc((threads ? threads : 1) * sizeof(pthread_t));
+  for(k=0;(pool)&&(k<threads);++k) {
+    if (pthread_create(&pool[k], (const pthread_attr_t *)0, batchWorkerMain, (void *)0))
+      break;
+  }
+  threads = k;
+  if (!threads) /* Run them all here if no thread could be started */
+    batchWorkerMain((void *)0);
+  for(k=0;k<threads;++k)
+    pthread_join(pool[k], (void **)0);
+  free(pool);
+
+  for(k=0;k<batchJobCount;++k) {
+    if (batchJobs[k].result)
+      failed = 1;
+  }
+  free(batchJobs);
+  return failed;
+}
+
+#endif /* BATCH_PONDS */
+
+/* ----------------------------------------------------------------------- */
+/* Benchmark mode                                                          */
+/* ----------------------------------------------------------------------- */
+
+/**
+ * Run a benchmark workload and print its numbers
+ *
+ * Every workload starts from config.seed and runs for a set number of
+ * ticks:
+ *   genesis  starts from an empty pond, as a normal run does
+ *   loops    starts from a pond full of loop-heavy genomes (see
+ *            seedLoopCorpus())
+ *   mature   resumes a checkpoint of a grown pond made by warmup
+ *   warmup   starts from an empty pond and writes a checkpoint at the
+ *            end for mature runs of the same build, instead of numbers
+ * Reports are thrown away. Dumps and checkpoints are written to the
+ * current directory as usual. The numbers go to stdout as one CSV line:
+ *   <workload>,<ticks>,<seconds>,<cell executions/sec>,
+ *   <instructions/sec>,<ns/instruction>,<reports/sec>,<dump MB/s>
+ * Instructions/sec and ns/instruction are over the whole run, so they
+ * include the time spent outside the interpreter. Reports/sec is the
+ * rate while making reports and dump MB/s the rate while writing dumps (in the background with DUMP_THREAD); both are 0
+ * if there were none.
+ *
+ * @param workload Workload name
+ * @param ticks Number of ticks to run
+ * @param checkpoint Checkpoint file for mature and warmup
+ * @return 0 on success, 1 on failure
+ */
+static int runBench(const char *workload, const uint64_t ticks, const char *checkpoint)
+{
+  const int warmup = !strcmp(workload, "warmup");
+  const char *restore = (const char *)0;
+  char tmpPath[336];
+  double seconds, instructions;
+  uint64_t executed;
+
+  if (!ticks) {
+    fprintf(stderr,"*** The benchmark needs a number of ticks ***\n");
+    return 1;
+  }
+  if (!strcmp(workload, "loops")) {
+    config.loopCorpus = 1;
+  } else if (warmup || (!strcmp(workload, "mature"))) {
+    if ((!checkpoint)||(strlen(checkpoint) >= (sizeof(tmpPath) - 4))) {
+      fprintf(stderr,"*** The %s workload needs a checkpoint file ***\n", workload);
+      return 1;
+    }
+    if (!warmup)
+      restore = checkpoint;
+  } else if (strcmp(workload, "genesis")) {
+    fprintf(stderr,"*** Unknown workload %s (genesis, loops, mature or warmup) ***\n", workload);
+    return 1;
+  }
+  config.stopAt = UINT64_MAX;
+  config.runTicks = ticks;
+  config.report = fopen("/dev/null", "w");
+  if (!config.report) {
+    fprintf(stderr,"*** Unable to open /dev/null ***\n");
+    return 1;
+  }
+
+  if (runPond(restore))
+    return 1;
+  seconds = elapsedSeconds();
+  instructions = (double)(instructionCount() - startInstructions);
+  executed = stopClock - startClock;
+  fclose(config.report);
+  config.report = stdout;
+
+  if (warmup) {
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", checkpoint);
+    if (writeCheckpoint(checkpoint, tmpPath, stopClock)) {
+      fprintf(stderr,"*** Unable to write checkpoint %s ***\n", checkpoint);
+      return 1;
+    }
+    fprintf(stderr,"[BENCH] Wrote %s at clock %ju\n", checkpoint, (uintmax_t)stopClock);
+    return 0;
+  }
+
+  printf("%s,%ju,%.3f,%.0f,%.0f,%.3f,%.1f,%.1f\n",
+    workload,
+    (uintmax_t)executed,
+    seconds,
+    (double)executed / seconds,
+    instructions / seconds,
+    (instructions > 0.0) ? ((seconds * 1.0e9) / instructions) : 0.0,
+    (reportSeconds > 0.0) ? ((double)reportCount / reportSeconds) : 0.0,
+    (dumpSnapshot.secondsWriting > 0.0) ? (((double)dumpSnapshot.bytesWritten / 1.0e6) / dumpSnapshot.secondsWriting) : 0.0);
+  return 0;
+}
+
+/**
+ * Main method
+ *
+ * @param argc Number of args
+ * @param argv Argument array
+ */
+int main(int argc,char **argv)
+{
+  initKernels();
+#if NEIGHBOR_TABLES
+  initNeighborTables();
+#endif
+#if (GENOME_HASH_CACHE || DUMP_ANALYSIS)
+  initGenomeHash();
+#endif
+
+  /* -t runs the self-test and exits, -d <file> [<delta>...] converts
+   * binary dumps to CSV and exits, -p <dump> <birth log>... writes the
+   * phylogeny of a dump (see BIRTH_LOG), -b <jobs file> [<threads>] runs a
+   * batch (see BATCH_PONDS), -x <trace>... writes the hot paths of the
+   * genomes in traces (see EXEC_TRACE), -a <state file> <dump>...
+   * summarizes a series of dumps (see DUMP_ANALYSIS), -B <workload>
+   * <ticks> [<checkpoint>] runs a benchmark (see runBench()), -r <file>
+   * resumes a checkpoint, and -n <node> <hosts file> runs a node of a
+   * distributed pond (see DISTRIBUTED_NODES) */
+  const char *restore = (const char *)0;
+  if ((argc > 1) && (!strcmp(argv[1], "-t")))
+    return selfTest() ? 1 : 0;
+  if ((argc > 2) && (!strcmp(argv[1], "-d")))
+    return convertDumps(argv + 2, (uintptr_t)(argc - 2));
+#if BIRTH_LOG
+  if ((argc > 3) && (!strcmp(argv[1], "-p")))
+    return buildPhylogeny(argv[2], argv + 3, (uintptr_t)(argc - 3));
+#endif
+#if DUMP_ANALYSIS
+  if ((argc > 3) && (!strcmp(argv[1], "-a")))
+    return analyzeDumps(argv[2], argv + 3, (uintptr_t)(argc - 3));
+#endif
+#if EXEC_TRACE
+  if ((argc > 2) && (!strcmp(argv[1], "-x")))
+    return replayTraces(argv + 2, (uintptr_t)(argc - 2));
+#endif
+#if BATCH_PONDS
+  if ((argc > 2) && (!strcmp(argv[1], "-b")))
+    return runBatch(argv[2], (argc > 3) ? (uintptr_t)strtoul(argv[3], (char **)0, 10) : 0);
+#endif
+  if ((argc > 2) && (!strcmp(argv[1], "-r")))
+    restore = argv[2];
+
+  defaultConfig(&config);
+
+#if (DISTRIBUTED_NODES > 0)
+  /* Node 0 writes the report for the whole pond, and each node dumps
+   * its own strip */
+  if ((argc <= 3) || (strcmp(argv[1], "-n"))) {
+    fprintf(stderr,"*** This build runs a node of a distributed pond: -n <node> <hosts file> ***\n");
+    return 1;
+  }
+  if (nodeConnect(atoi(argv[2]), argv[3]))
+    return 1;
+  snprintf(config.outputPrefix, sizeof(config.outputPrefix), "node%d.", nodeRank);
+  if (nodeRank)
+    config.report = fopen("/dev/null", "w");
+#endif
+
+  /* Set up SDL if we're using it */
+#ifdef USE_SDL
+  if (SDL_Init(SDL_INIT_VIDEO) < 0 ) {
+    fprintf(stderr,"*** Unable to init SDL: %s ***\n",SDL_GetError());
+    exit(1);
+  }
+  atexit(SDL_Quit);
+#endif /* USE_SDL */
+
+  if ((argc > 3) && (!strcmp(argv[1], "-B")))
+    return runBench(argv[2], (uint64_t)strtoull(argv[3], (char **)0, 10), (argc > 4) ? argv[4] : (const char *)0);
+  if (runPond(restore))
+    exit(1);
 
-  } /* main loop */
-  
   exit(0);
   return 0; /* Make compiler shut up */
 }